@@ -0,0 +1,196 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "arena.hpp"
+
+#include <cxxabi.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+
+namespace banjo
+{
+
+// -------------------------------------------------------------------------- //
+// Allocation kinds
+
+namespace
+{
+
+// The global registry of allocation kinds. Kinds are registered
+// lazily, possibly from multiple threads.
+struct Kind_registry
+{
+  std::mutex                         mutex;
+  std::vector<std::type_info const*> kinds;
+};
+
+
+Kind_registry&
+kind_registry()
+{
+  static Kind_registry reg;
+  return reg;
+}
+
+
+// Returns the demangled name of the type.
+std::string
+demangle(std::type_info const& ti)
+{
+  int status = 0;
+  char* p = abi::__cxa_demangle(ti.name(), nullptr, nullptr, &status);
+  if (status != 0)
+    return ti.name();
+  std::string str = p;
+  std::free(p);
+
+  // Strip the namespace qualifier for brevity.
+  if (str.compare(0, 7, "banjo::") == 0)
+    str.erase(0, 7);
+  return str;
+}
+
+} // namespace
+
+
+std::size_t
+register_allocation_kind(std::type_info const& ti)
+{
+  Kind_registry& reg = kind_registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  reg.kinds.push_back(&ti);
+  return reg.kinds.size() - 1;
+}
+
+
+std::type_info const&
+get_allocation_kind(std::size_t k)
+{
+  Kind_registry& reg = kind_registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  return *reg.kinds[k];
+}
+
+
+std::size_t
+count_allocation_kinds()
+{
+  Kind_registry& reg = kind_registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  return reg.kinds.size();
+}
+
+
+// -------------------------------------------------------------------------- //
+// Arena
+
+constexpr std::size_t Arena::block_size;
+
+
+thread_local Arena* thread_arena = nullptr;
+
+
+Arena::Arena()
+  : ptr(nullptr), lim(nullptr), head(nullptr)
+  , count(0), used(0), total(0), nblocks(0)
+{ }
+
+
+Arena::~Arena()
+{
+  release();
+}
+
+
+// Allocate a new block large enough to hold n bytes aligned to a, and
+// return the allocated memory. Large requests are given their own
+// block, which is linked behind the current block so that the current
+// block can continue to be used.
+void*
+Arena::allocate_block(std::size_t n, std::size_t a)
+{
+  std::size_t hdr = sizeof(Block);
+  std::size_t need = hdr + n + a;
+  bool large = n > block_size / 4;
+  std::size_t size = large ? need : std::max(need, block_size);
+
+  Block* b = static_cast<Block*>(::operator new(size));
+  b->size = size;
+  total += size;
+  ++nblocks;
+
+  char* first = reinterpret_cast<char*>(b) + hdr;
+  char* last = reinterpret_cast<char*>(b) + size;
+  char* p = align_pointer(first, a);
+
+  if (large && head) {
+    b->prev = head->prev;
+    head->prev = b;
+  } else {
+    b->prev = head;
+    head = b;
+    lim = last;
+    ptr = p + n;
+  }
+  return p;
+}
+
+
+// Run all registered destructors in reverse order of construction and
+// release all blocks of memory.
+void
+Arena::release()
+{
+  for (auto iter = dtors.rbegin(); iter != dtors.rend(); ++iter)
+    iter->fn(iter->obj);
+  dtors.clear();
+
+  while (head) {
+    Block* prev = head->prev;
+    ::operator delete(head);
+    head = prev;
+  }
+
+  ptr = lim = nullptr;
+  count = used = total = nblocks = 0;
+  stats.clear();
+}
+
+
+// -------------------------------------------------------------------------- //
+// Statistics
+
+// Print a summary of memory allocated by the arena. Allocation kinds
+// are listed in decreasing order of their footprint.
+void
+print_statistics(std::ostream& os, Arena const& a)
+{
+  using Entry = std::pair<std::size_t, Allocation_stats>;
+  std::vector<Entry> entries;
+  std::vector<Allocation_stats> const& stats = a.statistics();
+  for (std::size_t k = 0; k < stats.size(); ++k)
+    if (stats[k].objects)
+      entries.emplace_back(k, stats[k]);
+  std::sort(entries.begin(), entries.end(), [](Entry const& x, Entry const& y) {
+    return x.second.bytes > y.second.bytes;
+  });
+
+  os << "memory: " << a.objects() << " objects, "
+     << a.allocated() << " bytes allocated, "
+     << a.reserved() << " bytes reserved in "
+     << a.blocks() << " blocks\n";
+  for (Entry const& e : entries) {
+    os << "  " << std::left << std::setw(24) << demangle(get_allocation_kind(e.first))
+       << std::right << std::setw(10) << e.second.objects << " objects"
+       << std::setw(12) << e.second.bytes << " bytes\n";
+  }
+}
+
+
+} // namespace banjo
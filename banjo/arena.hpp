@@ -0,0 +1,220 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_ARENA_HPP
+#define BANJO_ARENA_HPP
+
+// This module defines the bump-pointer arena that owns the memory
+// for all terms created by the builder. Terms are never freed
+// individually; the entire arena is released at once when its
+// owning context is destroyed.
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+
+namespace banjo
+{
+
+// -------------------------------------------------------------------------- //
+// Allocation kinds
+
+// Each distinct type of object allocated in an arena is assigned
+// a unique kind number. This is used to index the allocation
+// statistics for that type.
+std::size_t register_allocation_kind(std::type_info const&);
+
+// Returns the type information for the given allocation kind.
+std::type_info const& get_allocation_kind(std::size_t);
+
+// Returns the number of registered allocation kinds.
+std::size_t count_allocation_kinds();
+
+
+// Returns the allocation kind for the type T. The kind is assigned
+// the first time this is called.
+template<typename T>
+inline std::size_t
+allocation_kind()
+{
+  static std::size_t k = register_allocation_kind(typeid(T));
+  return k;
+}
+
+
+// Records the number of objects and bytes allocated for a single
+// kind of object.
+struct Allocation_stats
+{
+  std::size_t objects = 0;
+  std::size_t bytes = 0;
+};
+
+
+// -------------------------------------------------------------------------- //
+// Arena
+
+// A bump-pointer allocator. Memory is allocated from large blocks
+// that are chained together and released only when the arena is
+// destroyed (or explicitly released).
+//
+// Objects created by make() have their destructors run in reverse
+// order of construction when the arena is released. Objects that are
+// trivially destructible do not incur that bookkeeping.
+struct Arena
+{
+  // The default size of a memory block. Requests larger than a
+  // quarter of this size are given a dedicated block.
+  static constexpr std::size_t block_size = 64 * 1024;
+
+  Arena();
+  ~Arena();
+
+  // Non-copyable
+  Arena(Arena const&) = delete;
+  Arena& operator=(Arena const&) = delete;
+
+  // Allocate n bytes of memory with the given alignment.
+  void* allocate(std::size_t n, std::size_t a);
+
+  // Allocate and construct an object of type T.
+  template<typename T, typename... Args>
+  T* make(Args&&...);
+
+  // Destroy all objects and release all memory.
+  void release();
+
+  // Statistics.
+  std::size_t objects() const   { return count; }
+  std::size_t allocated() const { return used; }
+  std::size_t reserved() const  { return total; }
+  std::size_t blocks() const    { return nblocks; }
+
+  std::vector<Allocation_stats> const& statistics() const { return stats; }
+
+  // The header of each block of memory. The usable memory follows
+  // the header.
+  struct Block
+  {
+    Block*      prev;
+    std::size_t size;
+  };
+
+  // A registered destructor.
+  struct Cleanup
+  {
+    void (*fn)(void*);
+    void* obj;
+  };
+
+  void* allocate_block(std::size_t n, std::size_t a);
+  void  record(std::size_t k, std::size_t n);
+
+  char*       ptr;     // The next free byte in the current block
+  char*       lim;     // The end of the current block
+  Block*      head;    // The most recently allocated block
+  std::size_t count;   // Number of objects constructed
+  std::size_t used;    // Bytes allocated to objects
+  std::size_t total;   // Bytes reserved for blocks
+  std::size_t nblocks; // Number of blocks
+
+  std::vector<Cleanup>          dtors;
+  std::vector<Allocation_stats> stats;
+};
+
+
+// Returns a pointer aligned to a, which must be a power of 2.
+inline char*
+align_pointer(char* p, std::size_t a)
+{
+  std::uintptr_t n = reinterpret_cast<std::uintptr_t>(p);
+  return reinterpret_cast<char*>((n + a - 1) & ~(std::uintptr_t(a) - 1));
+}
+
+
+// Allocate n bytes of memory aligned to a. This is the fast path;
+// a new block is allocated only when the current one is exhausted.
+inline void*
+Arena::allocate(std::size_t n, std::size_t a)
+{
+  char* p = align_pointer(ptr, a);
+  if (p <= lim && std::size_t(lim - p) >= n) {
+    ptr = p + n;
+    return p;
+  }
+  return allocate_block(n, a);
+}
+
+
+// Update the statistics for the allocation kind k.
+inline void
+Arena::record(std::size_t k, std::size_t n)
+{
+  if (k >= stats.size())
+    stats.resize(k + 1);
+  ++stats[k].objects;
+  stats[k].bytes += n;
+  ++count;
+  used += n;
+}
+
+
+template<typename T>
+inline void
+destroy_object(void* p)
+{
+  static_cast<T*>(p)->~T();
+}
+
+
+template<typename T, typename... Args>
+inline T*
+Arena::make(Args&&... args)
+{
+  void* p = allocate(sizeof(T), alignof(T));
+  T* obj = new (p) T(std::forward<Args>(args)...);
+  if (!std::is_trivially_destructible<T>::value)
+    dtors.push_back({&destroy_object<T>, obj});
+  record(allocation_kind<T>(), sizeof(T));
+  return obj;
+}
+
+
+void print_statistics(std::ostream&, Arena const&);
+
+
+// The arena used for allocation on the current thread in place of a
+// builder's own arena, or nullptr if there is none. Worker threads
+// install their own arenas so that allocation is not synchronized.
+extern thread_local Arena* thread_arena;
+
+
+// Install an arena for the current thread for the lifetime of the
+// object.
+struct Use_arena
+{
+  Use_arena(Arena& a)
+    : prev(thread_arena)
+  {
+    thread_arena = &a;
+  }
+
+  ~Use_arena()
+  {
+    thread_arena = prev;
+  }
+
+  Arena* prev;
+};
+
+
+} // namespace banjo
+
+
+#endif
@@ -13,6 +13,7 @@
 #include <lingo/real.hpp>
 #include <lingo/token.hpp>
 
+#include <atomic>
 #include <vector>
 #include <utility>
 
@@ -71,6 +72,20 @@ using lingo::Integer;
 // terms must not include a valid source code location.
 struct Term
 {
+  Term() = default;
+
+  // Copies do not share the cached hash of the original.
+  Term(Term const& t)
+    : loc(t.loc)
+  { }
+
+  Term& operator=(Term const& t)
+  {
+    loc = t.loc;
+    hash.store(0, std::memory_order_relaxed);
+    return *this;
+  }
+
   virtual ~Term() { }
 
   // Returns the source code location of the term. this
@@ -83,6 +98,15 @@ struct Term
   virtual Region region() const { return {loc, loc}; }
 
   Location loc;
+
+  // The structural hash of the term, computed by hash_value() the
+  // first time it is needed. A value of 0 indicates that the hash
+  // has not been computed. A term must not be modified in a way that
+  // affects its hash after it has been hashed (see ast-hash.hpp).
+  //
+  // Shared terms may be hashed by several threads at once. They all
+  // compute the same value, so relaxed ordering is sufficient.
+  mutable std::atomic<std::size_t> hash{0};
 };
 
 
@@ -114,6 +114,13 @@ struct Decl::Mutator
 struct Object_decl : Decl
 {
   using Decl::Decl;
+
+  // Returns the slot of a parameter or local variable in the frame
+  // of its function, or -1 if no slot has been allocated (see
+  // allocate_frame).
+  int slot() const { return slot_; }
+
+  int slot_ = -1;
 };
 
 
@@ -177,10 +184,14 @@ struct Function_decl : Decl
   Def const& definition() const { return *def_; }
   Def&       definition()       { return *def_; }
 
+  // Returns the number of slots in a frame for a call to this
+  // function, or -1 if the frame has not been allocated.
+  int frame_size() const { return frame_; }
+
   Decl_list parms_;
   Expr*     constr_;
   Def*      def_;
-
+  int       frame_ = -1;
 };
 
 
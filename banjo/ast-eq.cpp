@@ -195,11 +195,13 @@ is_equivalent(Unary_type const& t1, Unary_type const& t2)
 }
 
 
-// TODO: The extent of the arrays must be equivalent.
+// Array types are equivalent when their element types and extents
+// are equivalent. This agrees with the canonical table of array types.
 bool
 is_equivalent(Array_type const& t1, Array_type const& t2)
 {
-  return is_equivalent(t1.type(), t2.type());
+  return is_equivalent(t1.type(), t2.type())
+      && is_equivalent(t1.extent(), t2.extent());
 }
 
 
@@ -213,7 +215,8 @@ is_equivalent(Tuple_type const& t1, Tuple_type const& t2)
 bool
 is_equivalent(Dynarray_type const& t1, Dynarray_type const& t2)
 {
-  return is_equivalent(t1.type(),t2.type());
+  return is_equivalent(t1.type(), t2.type())
+      && is_equivalent(t1.extent(), t2.extent());
 }
 
 
@@ -36,11 +36,29 @@ is_equivalent(List<T> const& a, List<T> const& b)
 }
 
 
+// Returns true when t1 and t2 are the same type. Types created by
+// the builder are canonical, so two types are equivalent exactly
+// when they are the same object.
+inline bool
+is_same(Type const& t1, Type const& t2)
+{
+  return &t1 == &t2;
+}
+
+
+// Returns true when the lists contain the same types.
+inline bool
+is_same(Type_list const& a, Type_list const& b)
+{
+  return a.base() == b.base();
+}
+
+
 // Returns true when type t1 differs from type t2.
 inline bool
 is_different(Type const& t1, Type const& t2)
 {
-  return !is_equivalent(t1, t2);
+  return !is_same(t1, t2);
 }
 
 
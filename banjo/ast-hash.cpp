@@ -4,6 +4,7 @@
 #include "ast-hash.hpp"
 #include "ast.hpp"
 
+#include <cassert>
 #include <typeinfo>
 
 
@@ -18,6 +19,28 @@ std::size_t hash_type(T const& t)
 }
 
 
+// Returns the hash of t, computing it with f if it has not already
+// been cached in t. The value 0 is reserved to indicate that the hash
+// has not been computed.
+template<typename T>
+inline std::size_t
+cached_hash(T const& t, std::size_t (*f)(T const&))
+{
+  if (std::size_t h = t.hash.load(std::memory_order_relaxed)) {
+#if defined(BANJO_CHECK_HASH) || !defined(NDEBUG)
+    std::size_t r = f(t);
+    assert(h == (r ? r : 1) && "stale cached hash");
+#endif
+    return h;
+  }
+  std::size_t h = f(t);
+  if (!h)
+    h = 1;
+  t.hash.store(h, std::memory_order_relaxed);
+  return h;
+}
+
+
 // -------------------------------------------------------------------------- //
 // Terms
 
@@ -33,6 +56,8 @@ hash_value(Term const& x)
     return hash_value(*e);
   if (Decl const* d = as<Decl>(&x))
     return hash_value(*d);
+  if (Cons const* c = as<Cons>(&x))
+    return hash_value(*c);
   lingo_unreachable();
 }
 
@@ -115,8 +140,8 @@ hash_value(Qualified_id const&)
 }
 
 
-std::size_t
-hash_value(Name const& n)
+static std::size_t
+compute_hash(Name const& n)
 {
   struct fn
   {
@@ -135,6 +160,13 @@ hash_value(Name const& n)
 }
 
 
+std::size_t
+hash_value(Name const& n)
+{
+  return cached_hash(n, compute_hash);
+}
+
+
 // -------------------------------------------------------------------------- //
 // Types
 
@@ -185,8 +217,8 @@ hash_declared_type(Declared_type const& t)
 
 
 // Compute the hash value of a type.
-std::size_t
-hash_value(Type const& t)
+static std::size_t
+compute_hash(Type const& t)
 {
   struct fn
   {
@@ -197,12 +229,19 @@ hash_value(Type const& t)
     std::size_t operator()(Integer_type const& t) const   { return hash_integer(t); }
     std::size_t operator()(Float_type const& t) const     { return hash_float(t); }
     std::size_t operator()(Function_type const& t) const  { return hash_function_type(t); }
-    std::size_t operator()(Class_type const& t) const     { return hash_declared_type(t); }
+    std::size_t operator()(Declared_type const& t) const  { return hash_declared_type(t); }
   };
   return apply(t, fn{});
 }
 
 
+std::size_t
+hash_value(Type const& t)
+{
+  return cached_hash(t, compute_hash);
+}
+
+
 // -------------------------------------------------------------------------- //
 // Expressions
 
@@ -273,8 +312,8 @@ hash_conv(Conv const& e)
 }
 
 
-std::size_t
-hash_value(Expr const& e)
+static std::size_t
+compute_hash(Expr const& e)
 {
   struct fn
   {
@@ -293,6 +332,13 @@ hash_value(Expr const& e)
 }
 
 
+std::size_t
+hash_value(Expr const& e)
+{
+  return cached_hash(e, compute_hash);
+}
+
+
 // -------------------------------------------------------------------------- //
 // Declartions
 
@@ -316,8 +362,8 @@ hash_parm(Type_parm const& d)
 }
 
 
-std::size_t
-hash_value(Decl const& d)
+static std::size_t
+compute_hash(Decl const& d)
 {
   struct fn
   {
@@ -328,6 +374,13 @@ hash_value(Decl const& d)
 }
 
 
+std::size_t
+hash_value(Decl const& d)
+{
+  return cached_hash(d, compute_hash);
+}
+
+
 // -------------------------------------------------------------------------- //
 // Constraints
 
@@ -382,8 +435,8 @@ hash_value(Binary_cons const& c)
 
 
 
-std::size_t
-hash_value(Cons const& c)
+static std::size_t
+compute_hash(Cons const& c)
 {
   struct fn
   {
@@ -399,4 +452,11 @@ hash_value(Cons const& c)
 }
 
 
+std::size_t
+hash_value(Cons const& c)
+{
+  return cached_hash(c, compute_hash);
+}
+
+
 } // namespace banjo
@@ -6,6 +6,22 @@
 
 // This module defines the hash function on AST nodes.
 //
+// The structural hash of a term is computed once and then cached in
+// the term, so hashing a previously hashed term is constant time.
+//
+// The hash is frozen when it is first computed. The fields that it is
+// computed from (the symbols of names, the operands of types,
+// expressions, and constraints, and the indexes of template
+// parameters) must not be modified afterwards, since the terms that
+// contain a term cache hashes computed from its hash. Other fields,
+// like the type of an expression, may be assigned during elaboration.
+// Declarations are hashed by identity, so their types and definitions
+// may also be assigned.
+//
+// In debug builds, or with BANJO_CHECK_HASH, each use of a cached hash
+// is checked against a hash recomputed from the term's fields. The
+// hashes of operands are not recomputed, so the check is shallow.
+//
 // TODO: Migrate this to use an iterative hash instead of Boost's hashing
 // library. It will generate better keys (although this is a big rewrite).
 
@@ -40,7 +56,7 @@ hash_value(List<T> const& list)
 template<typename T>
 struct Term_hash
 {
-  bool operator()(T const* t) const
+  std::size_t operator()(T const* t) const
   {
     return hash_value(*t);
   }
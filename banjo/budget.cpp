@@ -0,0 +1,116 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "budget.hpp"
+#include "ast.hpp"
+#include "context.hpp"
+#include "printer.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+
+namespace banjo
+{
+
+Evaluation_budget::Evaluation_budget(Context& c)
+  : cxt(c)
+  , limits(c.limits)
+  , max_steps(limits.steps ? limits.steps : std::numeric_limits<std::size_t>::max())
+  , steps(0)
+  , bytes(0)
+  , profiling(c.profiling)
+{ }
+
+
+// Complete any calls abandoned by an error, and add the profile to
+// the context's.
+Evaluation_budget::~Evaluation_budget()
+{
+  if (!profiling)
+    return;
+  while (!active.empty())
+    leave();
+  Context_lock lock(cxt);
+  for (auto const& x : profile) {
+    Function_profile& p = cxt.profile[x.first];
+    p.calls += x.second.calls;
+    p.steps += x.second.steps;
+    p.time += x.second.time;
+  }
+}
+
+
+// Begin a call to f whose frame has n bytes.
+void
+Evaluation_budget::enter(Function_decl const& f, std::size_t n)
+{
+  if (limits.depth && active.size() >= limits.depth)
+    throw Evaluation_error("evaluation exceeded the limit of {} nested calls "
+                           "in a call to '{}'", limits.depth, f.name());
+  if (limits.bytes && bytes + n > limits.bytes)
+    throw Evaluation_error("evaluation exceeded the limit of {} bytes "
+                           "in a call to '{}'", limits.bytes, f.name());
+  bytes += n;
+  Activation a {&f, n, steps, 0, Clock::time_point(), Function_profile::Duration::zero()};
+  if (profiling)
+    a.start = Clock::now();
+  active.push_back(a);
+}
+
+
+// End the innermost call. Its own steps and time are recorded, and
+// the total is charged to its caller's callees.
+void
+Evaluation_budget::leave()
+{
+  Activation a = active.back();
+  active.pop_back();
+  bytes -= a.bytes;
+  if (!profiling)
+    return;
+  std::size_t total = steps - a.steps;
+  Function_profile::Duration time = Clock::now() - a.start;
+  Function_profile& p = profile[a.fn];
+  ++p.calls;
+  p.steps += total - a.nested;
+  p.time += time - a.inner;
+  if (!active.empty()) {
+    active.back().nested += total;
+    active.back().inner += time;
+  }
+}
+
+
+void
+Evaluation_budget::exceeded_steps() const
+{
+  throw Evaluation_error("evaluation exceeded the limit of {} steps", limits.steps);
+}
+
+
+// Print the profile of each function, with the most expensive first.
+void
+print_profile(std::ostream& os, Evaluation_profile const& prof)
+{
+  using Entry = std::pair<Function_decl const*, Function_profile>;
+  std::vector<Entry> fns(prof.begin(), prof.end());
+  std::sort(fns.begin(), fns.end(), [](Entry const& a, Entry const& b) {
+    return a.second.time > b.second.time;
+  });
+
+  os << "evaluation profile: " << fns.size() << " functions\n";
+  for (Entry const& x : fns) {
+    using Micro = std::chrono::duration<double, std::micro>;
+    Micro time = x.second.time;
+    os << "  " << x.first->name() << ": "
+       << x.second.calls << " calls, "
+       << x.second.steps << " steps, "
+       << std::fixed << std::setprecision(1) << time.count() << " us\n";
+  }
+}
+
+
+} // namespace banjo
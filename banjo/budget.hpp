@@ -0,0 +1,128 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_BUDGET_HPP
+#define BANJO_BUDGET_HPP
+
+// This module defines the limits on the resources used by compile-time
+// evaluation, and an optional profile of the functions it calls.
+//
+// Each evaluation of a constant expression has its own budget. Both
+// the evaluator and the virtual machine charge a step for each term or
+// instruction they execute, and charge each call against the depth and
+// memory limits. An evaluation that exceeds a limit is abandoned with
+// an Evaluation_error.
+
+#include "prelude.hpp"
+#include "language.hpp"
+
+#include <chrono>
+#include <iosfwd>
+#include <unordered_map>
+#include <vector>
+
+
+namespace banjo
+{
+
+struct Context;
+
+
+// Limits on a single evaluation. A limit of 0 means that the resource
+// is not limited.
+struct Evaluation_limits
+{
+  std::size_t steps = 1 << 24;  // Terms or instructions executed
+  std::size_t depth = 512;      // Nested calls
+  std::size_t bytes = 64 << 20; // Bytes of active frames
+};
+
+
+// The resources used by calls to a single function. Steps and time
+// exclude those spent in the function's callees.
+struct Function_profile
+{
+  using Duration = std::chrono::steady_clock::duration;
+
+  std::size_t calls = 0;
+  std::size_t steps = 0;
+  Duration    time  = Duration::zero();
+};
+
+
+// The profiles of all functions called during compile-time evaluation.
+using Evaluation_profile = std::unordered_map<Function_decl const*, Function_profile>;
+
+
+void print_profile(std::ostream&, Evaluation_profile const&);
+
+
+// Tracks the resources used by a single evaluation. The profile is
+// recorded only if profiling is enabled in the context, and is added
+// to the context's profile when the evaluation completes.
+struct Evaluation_budget
+{
+  using Clock = std::chrono::steady_clock;
+
+  // An active call.
+  struct Activation
+  {
+    Function_decl const*       fn;
+    std::size_t                bytes;  // The size of the frame
+    std::size_t                steps;  // Steps at entry
+    std::size_t                nested; // Steps spent in callees
+    Clock::time_point          start;  // Time of entry
+    Function_profile::Duration inner;  // Time spent in callees
+  };
+
+  Evaluation_budget(Context&);
+  ~Evaluation_budget();
+
+  // Charge n steps.
+  void step(std::size_t n = 1)
+  {
+    steps += n;
+    if (steps > max_steps)
+      exceeded_steps();
+  }
+
+  void enter(Function_decl const&, std::size_t);
+  void leave();
+
+  [[noreturn]] void exceeded_steps() const;
+
+  Context&                cxt;
+  Evaluation_limits       limits;
+  std::size_t             max_steps; // The step limit, or the maximum size
+  std::size_t             steps;     // Steps taken
+  std::size_t             bytes;     // Bytes of active frames
+  bool                    profiling; // True if calls are profiled
+  std::vector<Activation> active;    // Active calls
+  Evaluation_profile      profile;   // Calls completed
+};
+
+
+// Charges a call to the budget for the lifetime of the object.
+struct Enter_call
+{
+  Enter_call(Evaluation_budget* b, Function_decl const& f, std::size_t n)
+    : budget(b)
+  {
+    if (budget)
+      budget->enter(f, n);
+  }
+
+  ~Enter_call()
+  {
+    if (budget)
+      budget->leave();
+  }
+
+  Evaluation_budget* budget;
+};
+
+
+} // namespace banjo
+
+
+#endif
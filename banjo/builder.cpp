@@ -5,65 +5,21 @@
 #include "context.hpp"
 #include "ast.hpp"
 
-#include <unordered_set>
-
 
 namespace banjo
 {
 
-// FIXME: Move this into lingo.
-//
-// A unique factory will only allocate new objects if they have not been
-// previously created.
-template<typename T, typename Hash, typename Eq>
-struct Hashed_unique_factory : std::unordered_set<T, Hash, Eq>
-{
-  template<typename... Args>
-  T& make(Args&&... args)
-  {
-    auto ins = this->emplace(std::forward<Args>(args)...);
-    return *const_cast<T*>(&*ins.first); // Yuck.
-  }
-};
-
-
-template<typename T>
-struct Hash
-{
-  std::size_t operator()(T const& t) const
-  {
-    return hash_value(t);
-  }
-
-  std::size_t operator()(List<T> const& t) const
-  {
-    return hash_value(t);
-  }
-};
-
-
-template<typename T>
-struct Eq
-{
-  bool operator()(T const& a, T const& b) const
-  {
-    return is_equivalent(a, b);
-  }
-
-  bool operator()(List<T> const& a, List<T> const& b) const
-  {
-    return is_equivalent(a, b);
-  }
-};
-
-
-template<typename T>
-using Factory = Hashed_unique_factory<T, Hash<T>, Eq<T>>;
-
-
 // -------------------------------------------------------------------------- //
 // Builder definition
 
+// Note that the context may still be under construction when its
+// builder base is initialized. Only the address of the arena is
+// taken here.
+Builder::Builder(Context& c)
+  : cxt(c), mem(c.arena)
+{ }
+
+
 Symbol_table&
 Builder::symbols() { return cxt.symbols(); }
 
@@ -77,7 +33,7 @@ Builder::symbols() { return cxt.symbols(); }
 Simple_id&
 Builder::get_id(char const* s)
 {
-  Symbol const* sym = symbols().put_identifier(identifier_tok, s);
+  Symbol const* sym = cxt.spellings().put_identifier(s);
   return make<Simple_id>(*sym);
 }
 
@@ -86,7 +42,7 @@ Builder::get_id(char const* s)
 Simple_id&
 Builder::get_id(std::string const& s)
 {
-  Symbol const* sym = symbols().put_identifier(identifier_tok, s);
+  Symbol const* sym = cxt.spellings().put_identifier(s);
   return make<Simple_id>(*sym);
 }
 
@@ -175,32 +131,74 @@ Builder::get_global_id()
 
 // -------------------------------------------------------------------------- //
 // Types
+//
+// All types (except unparsed types) are canonical: a type is created
+// at most once for any combination of its components. This guarantees
+// that two types are equivalent if and only if they are the same
+// object (see is_same). Canonical tables are shared by all threads,
+// so lookups are guarded while workers are active.
+
+
+// Returns the canonical term in the table m, having key k. If no such
+// term exists, one is constructed with the given arguments.
+template<typename T, typename M, typename K, typename... Args>
+inline T&
+get_unique(Builder& b, M& m, K const& k, Args&&... args)
+{
+  Context_lock lock(b.cxt);
+  auto iter = m.find(k);
+  if (iter != m.end())
+    return *iter->second;
+  T& t = b.make<T>(std::forward<Args>(args)...);
+  m.emplace(k, &t);
+  return t;
+}
+
+
+// Returns the canonical nullary type stored in p.
+template<typename T>
+inline T&
+get_unique(Builder& b, T*& p)
+{
+  Context_lock lock(b.cxt);
+  if (!p)
+    p = &b.make<T>();
+  return *p;
+}
+
+
+// Returns the key for a sequence of types.
+inline Type_seq
+get_type_seq(Type_list const& ts)
+{
+  return Type_seq(ts.base().begin(), ts.base().end());
+}
 
 
 Void_type&
 Builder::get_void_type()
 {
-  return make<Void_type>();
+  return get_unique(*this, cxt.types.void_);
 }
 
 
 Boolean_type&
 Builder::get_bool_type()
 {
-  return make<Boolean_type>();
+  return get_unique(*this, cxt.types.bool_);
 }
 
 
 Integer_type&
 Builder::get_integer_type(bool s, int p)
 {
-  return make<Integer_type>(s, p);
+  return get_unique<Integer_type>(*this, cxt.types.ints, std::make_pair(s, p), s, p);
 }
 
 Byte_type&
 Builder::get_byte_type()
 {
-  return make<Byte_type>();
+  return get_unique(*this, cxt.types.byte_);
 }
 
 
@@ -220,10 +218,18 @@ Builder::get_uint_type()
 }
 
 
+Float_type&
+Builder::get_float_type(int p)
+{
+  return get_unique<Float_type>(*this, cxt.types.floats, p, p);
+}
+
+
+// TODO: Default precision depends on configuration.
 Float_type&
 Builder::get_float_type()
 {
-  return make<Float_type>();
+  return get_float_type(64);
 }
 
 
@@ -246,28 +252,36 @@ Builder::get_function_type(Decl_list const& ps, Type& r)
 }
 
 
+// The key of a function type is its list of parameter types followed
+// by its return type.
 Function_type&
 Builder::get_function_type(Type_list const& ts, Type& r)
 {
-  return make<Function_type>(ts, r);
+  Type_seq k = get_type_seq(ts);
+  k.push_back(&r);
+  return get_unique<Function_type>(*this, cxt.types.fns, k, ts, r);
 }
 
+// Returns the coroutine type for the given declaration.
 Coroutine_type&
 Builder::get_coroutine_type(Type_decl& d)
 {
-  return make<Coroutine_type>(d);
+  return get_unique<Coroutine_type>(*this, cxt.types.coroutines, &d, d);
 }
+// Returns the type t qualified by qual. When t is already qualified,
+// this returns the type with the union of both sets of qualifiers,
+// which is a distinct canonical type.
+//
 // TODO: Do not build qualified types for functions or arrays.
 // Is that a hard error, or do we simply fold the const into
 // the return type and/or element type?
 Qualified_type&
 Builder::get_qualified_type(Type& t, Qualifier_set qual)
 {
-  if (Qualified_type* q = as<Qualified_type>(&t)) {
-    q->qual |= qual;
-    return *q;
-  }
-  return make<Qualified_type>(t, qual);
+  if (Qualified_type* q = as<Qualified_type>(&t))
+    return get_qualified_type(q->type(), Qualifier_set(q->qualifiers() | qual));
+  auto k = std::make_pair(&t, int(qual));
+  return get_unique<Qualified_type>(*this, cxt.types.quals, k, t, qual);
 }
 
 
@@ -288,56 +302,56 @@ Builder::get_volatile_type(Type& t)
 Pointer_type&
 Builder::get_pointer_type(Type& t)
 {
-  return make<Pointer_type>(t);
+  return get_unique<Pointer_type>(*this, cxt.types.ptrs, &t, t);
 }
 
 
 Reference_type&
 Builder::get_reference_type(Type& t)
 {
-  return make<Reference_type>(t);
+  return get_unique<Reference_type>(*this, cxt.types.refs, &t, t);
 }
 
 
 Array_type&
 Builder::get_array_type(Type& t, Expr& e)
 {
-  return make<Array_type>(t,e);
+  return get_unique<Array_type>(*this, cxt.types.arrays, Extent_key{&t, &e}, t, e);
 }
 
 
 Tuple_type&
 Builder::get_tuple_type(Type_list const& t)
 {
-  return make<Tuple_type>(t);
+  return get_unique<Tuple_type>(*this, cxt.types.tuples, get_type_seq(t), t);
 }
 
 
 Slice_type&
 Builder::get_slice_type(Type& t)
 {
-  return make<Slice_type>(t);
+  return get_unique<Slice_type>(*this, cxt.types.slices, &t, t);
 }
 
 
 Dynarray_type&
 Builder::get_dynarray_type(Type& t, Expr& e)
 {
-  return make<Dynarray_type>(t,e);
+  return get_unique<Dynarray_type>(*this, cxt.types.dynarrays, Extent_key{&t, &e}, t, e);
 }
 
 
 Pack_type&
 Builder::get_pack_type(Type& t)
 {
-  return make<Pack_type>(t);
+  return get_unique<Pack_type>(*this, cxt.types.packs, &t, t);
 }
 
 // Returns class type for the given type declaration.
 Class_type&
 Builder::get_class_type(Type_decl& d)
 {
-  return make<Class_type>(d);
+  return get_unique<Class_type>(*this, cxt.types.classes, &d, d);
 }
 
 
@@ -345,7 +359,7 @@ Builder::get_class_type(Type_decl& d)
 Typename_type&
 Builder::get_typename_type(Type_decl& d)
 {
-  return make<Typename_type>(d);
+  return get_unique<Typename_type>(*this, cxt.types.typenames, &d, d);
 }
 
 
@@ -353,7 +367,7 @@ Builder::get_typename_type(Type_decl& d)
 Auto_type&
 Builder::get_auto_type(Type_decl& d)
 {
-  return make<Auto_type>(d);
+  return get_unique<Auto_type>(*this, cxt.types.autos, &d, d);
 }
 
 
@@ -371,7 +385,7 @@ Builder::get_type_type()
 Synthetic_type&
 Builder::synthesize_type(Decl& d)
 {
-  return make<Synthetic_type>(d);
+  return get_unique<Synthetic_type>(*this, cxt.types.synthetics, &d, d);
 }
 
 
@@ -1129,62 +1143,73 @@ Builder::make_syntactic_requirement(Expr& e)
 // -------------------------------------------------------------------------- //
 // Constraints
 
-// FIXME: Save all uniqued terms in the context, not as global variables.
+// All constraints are canonical. A constraint is looked up using a
+// temporary whose operands are canonical, so hashing and comparing
+// the temporary only inspects its immediate operands.
+
+
+// Returns the canonical constraint equivalent to c. If no such
+// constraint exists, a copy of c is registered as canonical.
+template<typename T>
+inline T&
+get_unique(Builder& b, Cons_set& s, T const& c)
+{
+  Context_lock lock(b.cxt);
+  auto iter = s.find(&c);
+  if (iter != s.end())
+    return cast<T>(*modify(*iter));
+  T& t = b.make<T>(c);
+  s.insert(&t);
+  return t;
+}
+
 
 Concept_cons&
 Builder::get_concept_constraint(Decl& d, Term_list const& ts)
 {
-  static Factory<Concept_cons> f;
-  return f.make(d, ts);
+  return get_unique(*this, cxt.cons, Concept_cons(d, ts));
 }
 
 
 Predicate_cons&
 Builder::get_predicate_constraint(Expr& e)
 {
-  static Factory<Predicate_cons> f;
-  return f.make(e);
+  return get_unique(*this, cxt.cons, Predicate_cons(e));
 }
 
 
 Expression_cons&
 Builder::get_expression_constraint(Expr& e, Type& t)
 {
-  static Factory<Expression_cons> f;
-  return f.make(e, t);
+  return get_unique(*this, cxt.cons, Expression_cons(e, t));
 }
 
 
 Conversion_cons&
 Builder::get_conversion_constraint(Expr& e, Type& t)
 {
-  static Factory<Conversion_cons> f;
-  return f.make(e, t);
-
+  return get_unique(*this, cxt.cons, Conversion_cons(e, t));
 }
 
 
 Parameterized_cons&
 Builder::get_parameterized_constraint(Decl_list const& ds, Cons& c)
 {
-  static Factory<Parameterized_cons> f;
-  return f.make(ds, c);
+  return get_unique(*this, cxt.cons, Parameterized_cons(ds, c));
 }
 
 
 Conjunction_cons&
 Builder::get_conjunction_constraint(Cons& c1, Cons& c2)
 {
-  static Factory<Conjunction_cons> f;
-  return f.make(c1, c2);
+  return get_unique(*this, cxt.cons, Conjunction_cons(c1, c2));
 }
 
 
 Disjunction_cons&
 Builder::get_disjunction_constraint(Cons& c1, Cons& c2)
 {
-  static Factory<Disjunction_cons> f;
-  return f.make(c1, c2);
+  return get_unique(*this, cxt.cons, Disjunction_cons(c1, c2));
 }
 
 
@@ -6,6 +6,7 @@
 #define BANJO_BUILDER_HPP
 
 #include "prelude.hpp"
+#include "arena.hpp"
 #include "token.hpp"
 #include "language.hpp"
 #include "ast-stmt.hpp"
@@ -29,9 +30,7 @@ namespace banjo
 // location, then it can be uniqued.
 struct Builder
 {
-  Builder(Context& cxt)
-    : cxt(cxt)
-  { }
+  Builder(Context&);
 
   // Names
   //
@@ -58,6 +57,7 @@ struct Builder
   Integer_type&   get_integer_type(bool, int);
   Integer_type&   get_int_type();
   Integer_type&   get_uint_type();
+  Float_type&     get_float_type(int);
   Float_type&     get_float_type();
   Decltype_type&  get_decltype_type(Expr&);
   Function_type&  get_function_type(Decl_list const&, Type&);
@@ -223,17 +223,18 @@ struct Builder
   // Resources
   Symbol_table& symbols();
 
-  // Allocate an objet of the given type.
-  //
-  // TODO: This is a placeholder for using a legitimate object
-  // pool in the context (or somewhere else).
+  // Allocate an object of the given type in the context's arena or,
+  // on a worker thread, in that thread's arena.
+  // The object is destroyed when the context is destroyed.
   template<typename T, typename... Args>
   T& make(Args&&... args)
   {
-    return *new T(std::forward<Args>(args)...);
+    Arena& a = thread_arena ? *thread_arena : mem;
+    return *a.make<T>(std::forward<Args>(args)...);
   }
 
   Context& cxt;
+  Arena&   mem;
 };
 
 
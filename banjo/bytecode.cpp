@@ -0,0 +1,833 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "bytecode.hpp"
+#include "ast.hpp"
+#include "budget.hpp"
+#include "context.hpp"
+#include "evaluation.hpp"
+
+#include <iostream>
+#include <limits>
+
+
+namespace banjo
+{
+
+namespace
+{
+
+using Slot = std::uint16_t;
+
+
+// Thrown when a term is outside the compiled subset.
+struct Unsupported { };
+
+
+// Returns n as an operand.
+inline Slot
+narrow(std::size_t n)
+{
+  if (n > std::numeric_limits<Slot>::max())
+    throw Limitation_error("function is too large to compile");
+  return n;
+}
+
+
+// Tracks the functions compiled while compiling a single function or
+// expression. If any of them cannot be compiled, then none of them
+// can, since they may refer to each other.
+struct Session
+{
+  Session(Context& c)
+    : cxt(c)
+  { }
+
+  Function_code const& function(Function_decl const&);
+  void                 fail();
+
+  Context&                          cxt;
+  std::vector<Function_decl const*> started;
+};
+
+
+// The state of the compilation of a single function body or
+// expression.
+struct Compiler
+{
+  // The jump targets of the innermost loop.
+  struct Loop
+  {
+    std::size_t              start;
+    std::vector<std::size_t> breaks;
+  };
+
+  Compiler(Session& s, Function_code& c)
+    : sess(s), out(c), top(0)
+  { }
+
+  std::size_t here() const { return out.code.size(); }
+
+  std::size_t emit(Opcode, std::size_t = 0, std::size_t = 0, std::size_t = 0);
+  void        patch(std::size_t, std::size_t);
+
+  Slot temp();
+  Slot local(Decl const&);
+  Slot constant(Value const&);
+  Slot callee(Function_decl const&);
+
+  Slot operand(Expr const&);
+  void expression(Expr const&, Slot);
+  void fit(Type const&, Slot);
+  void unary(Opcode, Unary_expr const&, Slot);
+  void binary(Opcode, Binary_expr const&, Slot);
+  void logical(Opcode, Binary_expr const&, Slot);
+  void assign(Assign_expr const&, Slot);
+  void call(Call_expr const&, Slot);
+  void reference(Decl const&, Slot);
+
+  void statement(Stmt const&);
+  void block(Compound_stmt const&);
+  void declaration(Decl const&);
+  void ret(Return_stmt const&);
+  void if_then(If_then_stmt const&);
+  void if_else(If_else_stmt const&);
+  void loop(While_stmt const&);
+  void jump(Stmt const&);
+
+  void parameters(Function_decl const&);
+
+  Session&          sess;
+  Function_code&    out;
+  std::size_t       top;   // The next free slot
+  std::vector<Loop> loops; // Enclosing loops
+};
+
+
+// Emit an instruction and return its position.
+std::size_t
+Compiler::emit(Opcode op, std::size_t a, std::size_t b, std::size_t c)
+{
+  out.code.push_back({op, narrow(a), narrow(b), narrow(c)});
+  return out.code.size() - 1;
+}
+
+
+// Set the target of the jump at position i.
+void
+Compiler::patch(std::size_t i, std::size_t target)
+{
+  out.code[i].a = narrow(target);
+}
+
+
+// Allocate the next free slot above the function's variables.
+// Temporaries are released by resetting the top of the frame.
+Slot
+Compiler::temp()
+{
+  Slot s = narrow(top++);
+  if (top > out.frame)
+    out.frame = top;
+  return s;
+}
+
+
+// Returns the frame slot of a parameter or local variable of the
+// function being compiled (see allocate_frame). An expression compiled
+// outside of a function has no variables.
+Slot
+Compiler::local(Decl const& d)
+{
+  Object_decl const* var = as<Object_decl>(&d);
+  if (!out.fn || !var || var->slot() < 0)
+    throw Unsupported();
+  return narrow(var->slot());
+}
+
+
+Slot
+Compiler::constant(Value const& v)
+{
+  out.constants.push_back(v);
+  return narrow(out.constants.size() - 1);
+}
+
+
+Slot
+Compiler::callee(Function_decl const& f)
+{
+  for (std::size_t i = 0; i < out.callees.size(); ++i)
+    if (out.callees[i].fn == &f)
+      return i;
+  Function_code const& code = sess.function(f);
+  out.callees.push_back({&f, &code});
+  return narrow(out.callees.size() - 1);
+}
+
+
+// Returns true if values of type t are represented by a single
+// integer in the machine.
+inline bool
+is_scalar(Type const& t)
+{
+  return is<Integer_type>(&t) || is<Boolean_type>(&t);
+}
+
+
+// -------------------------------------------------------------------------- //
+// Expressions
+
+// Returns the slot holding the value of e. Variables are used in place.
+// Otherwise, the value is computed into a new temporary.
+Slot
+Compiler::operand(Expr const& e)
+{
+  Expr const* p = &e;
+  while (Value_conv const* c = as<Value_conv>(p))
+    p = &c->source();
+  if (Object_expr const* v = as<Object_expr>(p))
+    return local(v->declaration());
+  Slot s = temp();
+  expression(e, s);
+  return s;
+}
+
+
+void
+Compiler::expression(Expr const& e, Slot dst)
+{
+  struct fn
+  {
+    Compiler& self;
+    Slot      dst;
+
+    void operator()(Expr const& e)         { throw Unsupported(); }
+    void operator()(Boolean_expr const& e) { self.emit(op_const, dst, self.constant((int)e.value())); }
+    void operator()(Integer_expr const& e) { self.emit(op_const, dst, self.constant(Integer_value(e.value().getu()))); }
+    void operator()(Decl_expr const& e)    { self.reference(e.declaration(), dst); }
+    void operator()(Add_expr const& e)     { self.binary(op_add, e, dst); }
+    void operator()(Sub_expr const& e)     { self.binary(op_sub, e, dst); }
+    void operator()(Mul_expr const& e)     { self.binary(op_mul, e, dst); }
+    void operator()(Div_expr const& e)     { self.binary(op_div, e, dst); }
+    void operator()(Rem_expr const& e)     { self.binary(op_rem, e, dst); }
+    void operator()(Neg_expr const& e)     { self.unary(op_neg, e, dst); }
+    void operator()(Pos_expr const& e)     { self.unary(op_move, e, dst); }
+    void operator()(Bit_and_expr const& e) { self.binary(op_bit_and, e, dst); }
+    void operator()(Bit_or_expr const& e)  { self.binary(op_bit_or, e, dst); }
+    void operator()(Bit_xor_expr const& e) { self.binary(op_bit_xor, e, dst); }
+    void operator()(Bit_lsh_expr const& e) { self.binary(op_bit_lsh, e, dst); }
+    void operator()(Bit_rsh_expr const& e) { self.binary(op_bit_rsh, e, dst); }
+    void operator()(Bit_not_expr const& e) { self.unary(op_bit_not, e, dst); }
+    void operator()(Eq_expr const& e)      { self.binary(op_eq, e, dst); }
+    void operator()(Ne_expr const& e)      { self.binary(op_ne, e, dst); }
+    void operator()(Lt_expr const& e)      { self.binary(op_lt, e, dst); }
+    void operator()(Gt_expr const& e)      { self.binary(op_gt, e, dst); }
+    void operator()(Le_expr const& e)      { self.binary(op_le, e, dst); }
+    void operator()(Ge_expr const& e)      { self.binary(op_ge, e, dst); }
+    void operator()(Cmp_expr const& e)     { self.binary(op_cmp, e, dst); }
+    void operator()(And_expr const& e)     { self.logical(op_jump_ifn, e, dst); }
+    void operator()(Or_expr const& e)      { self.logical(op_jump_if, e, dst); }
+    void operator()(Not_expr const& e)     { self.unary(op_not, e, dst); }
+    void operator()(Assign_expr const& e)  { self.assign(e, dst); }
+    void operator()(Call_expr const& e)    { self.call(e, dst); }
+
+    // Conversions between scalar values.
+    void operator()(Value_conv const& e)         { self.expression(e.source(), dst); }
+    void operator()(Qualification_conv const& e) { self.expression(e.source(), dst); }
+    void operator()(Integer_conv const& e)       { self.expression(e.source(), dst); self.fit(e.type(), dst); }
+    void operator()(Boolean_conv const& e)       { self.emit(op_bool, dst, self.operand(e.source())); }
+
+    // Initializers of scalar objects.
+    void operator()(Trivial_init const& e) { self.emit(op_const, dst, self.constant(0)); }
+    void operator()(Copy_init const& e)    { self.expression(e.expression(), dst); }
+  };
+
+  std::size_t t = top;
+  apply(e, fn{*this, dst});
+  top = t;
+}
+
+
+// Values are computed in 64 bits. If the value in dst has a narrower
+// integer type, truncate it to the precision of that type, and sign
+// extend it if the type is signed.
+void
+Compiler::fit(Type const& t, Slot dst)
+{
+  Integer_type const* z = as<Integer_type>(&t);
+  if (!z || z->precision() >= 64)
+    return;
+  emit(z->is_signed() ? op_sext : op_zext, dst, dst, z->precision());
+}
+
+
+void
+Compiler::unary(Opcode op, Unary_expr const& e, Slot dst)
+{
+  emit(op, dst, operand(e.operand()));
+  fit(e.type(), dst);
+}
+
+
+void
+Compiler::binary(Opcode op, Binary_expr const& e, Slot dst)
+{
+  Slot a = operand(e.left());
+  Slot b = operand(e.right());
+  emit(op, dst, a, b);
+  fit(e.type(), dst);
+}
+
+
+// The result of a logical operation is the value of the left operand
+// if it determines the result, and the value of the right operand
+// otherwise. The result is computed in a temporary since dst may be
+// a variable used by the right operand.
+void
+Compiler::logical(Opcode op, Binary_expr const& e, Slot dst)
+{
+  Slot t = temp();
+  expression(e.left(), t);
+  std::size_t j = emit(op, 0, t);
+  expression(e.right(), t);
+  patch(j, here());
+  emit(op_move, dst, t);
+}
+
+
+// Only local variables can be assigned.
+void
+Compiler::assign(Assign_expr const& e, Slot dst)
+{
+  Object_expr const* v = as<Object_expr>(&e.left());
+  if (!v)
+    throw Unsupported();
+  Slot s = local(v->declaration());
+  expression(e.right(), s);
+  if (s != dst)
+    emit(op_move, dst, s);
+}
+
+
+// Only direct calls are compiled. Arguments are evaluated into
+// consecutive slots.
+void
+Compiler::call(Call_expr const& e, Slot dst)
+{
+  Function_expr const* f = as<Function_expr>(&e.function());
+  if (!f)
+    throw Unsupported();
+  Function_decl const& fn = f->declaration();
+  Expr_list const& args = e.arguments();
+  if (args.size() != fn.parameters().size())
+    throw Unsupported();
+  Slot first = top;
+  for (std::size_t i = 0; i < args.size(); ++i)
+    temp();
+  Slot s = first;
+  for (Expr const& a : args)
+    expression(a, s++);
+  emit(op_call, dst, callee(fn), first);
+}
+
+
+void
+Compiler::reference(Decl const& d, Slot dst)
+{
+  if (Function_decl const* f = as<Function_decl>(&d)) {
+    emit(op_const, dst, constant(Function_value(f)));
+    return;
+  }
+  Slot s = local(d);
+  if (s != dst)
+    emit(op_move, dst, s);
+}
+
+
+// -------------------------------------------------------------------------- //
+// Statements
+
+void
+Compiler::statement(Stmt const& s)
+{
+  struct fn
+  {
+    Compiler& self;
+
+    void operator()(Stmt const& s)             { throw Unsupported(); }
+    void operator()(Empty_stmt const& s)       { }
+    void operator()(Compound_stmt const& s)    { self.block(s); }
+    void operator()(Expression_stmt const& s)  { self.expression(s.expression(), self.temp()); }
+    void operator()(Declaration_stmt const& s) { self.declaration(s.declaration()); }
+    void operator()(Return_stmt const& s)      { self.ret(s); }
+    void operator()(If_then_stmt const& s)     { self.if_then(s); }
+    void operator()(If_else_stmt const& s)     { self.if_else(s); }
+    void operator()(While_stmt const& s)       { self.loop(s); }
+    void operator()(Break_stmt const& s)       { self.jump(s); }
+    void operator()(Continue_stmt const& s)    { self.jump(s); }
+  };
+
+  // Temporaries are released after each statement.
+  std::size_t t = top;
+  apply(s, fn{*this});
+  top = t;
+}
+
+
+void
+Compiler::block(Compound_stmt const& s)
+{
+  for (Stmt const& s1 : s.statements())
+    statement(s1);
+}
+
+
+// Initialize a variable in its frame slot.
+void
+Compiler::declaration(Decl const& d)
+{
+  Variable_decl const* var = as<Variable_decl>(&d);
+  if (!var || !is_scalar(declared_type(d)))
+    throw Unsupported();
+  Slot s = local(d);
+  Def const& init = var->initializer();
+  if (Expression_def const* def = as<Expression_def>(&init))
+    expression(def->expression(), s);
+  else if (is<Empty_def>(&init))
+    emit(op_const, s, constant(0));
+  else
+    throw Unsupported();
+}
+
+
+void
+Compiler::ret(Return_stmt const& s)
+{
+  emit(op_return, operand(s.expression()));
+}
+
+
+void
+Compiler::if_then(If_then_stmt const& s)
+{
+  std::size_t j = emit(op_jump_ifn, 0, operand(s.condition()));
+  statement(s.true_branch());
+  patch(j, here());
+}
+
+
+void
+Compiler::if_else(If_else_stmt const& s)
+{
+  std::size_t j1 = emit(op_jump_ifn, 0, operand(s.condition()));
+  statement(s.true_branch());
+  std::size_t j2 = emit(op_jump);
+  patch(j1, here());
+  statement(s.false_branch());
+  patch(j2, here());
+}
+
+
+void
+Compiler::loop(While_stmt const& s)
+{
+  loops.push_back({here(), {}});
+  std::size_t j = emit(op_jump_ifn, 0, operand(s.condition()));
+  statement(s.body());
+  emit(op_jump, loops.back().start);
+  patch(j, here());
+  for (std::size_t b : loops.back().breaks)
+    patch(b, here());
+  loops.pop_back();
+}
+
+
+void
+Compiler::jump(Stmt const& s)
+{
+  if (loops.empty())
+    throw Unsupported();
+  if (is<Break_stmt>(&s))
+    loops.back().breaks.push_back(emit(op_jump));
+  else
+    emit(op_jump, loops.back().start);
+}
+
+
+// Parameters occupy the first slots of the frame, and temporaries
+// follow the local variables.
+void
+Compiler::parameters(Function_decl const& f)
+{
+  if (f.frame_size() < 0)
+    throw Unsupported();
+  std::size_t n = 0;
+  for (Decl const& p : f.parameters()) {
+    if (!is_scalar(declared_type(p)) || local(p) != n)
+      throw Unsupported();
+    ++n;
+  }
+  out.parms = n;
+  top = out.frame = f.frame_size();
+}
+
+
+// -------------------------------------------------------------------------- //
+// Sessions
+
+// Returns the code for f, compiling it if needed. The code is cached
+// before the body is compiled so that recursive calls can refer to it.
+Function_code const&
+Session::function(Function_decl const& f)
+{
+  Function_code const* p;
+  if (cxt.code.find(&f, p)) {
+    if (!p)
+      throw Unsupported();
+    return *p;
+  }
+
+  Function_def const* def = as<Function_def>(&f.definition());
+  if (!def)
+    throw Unsupported();
+
+  Function_code& code = cxt.make<Function_code>(&f);
+  cxt.code.save(&f, &code);
+  started.push_back(&f);
+
+  Compiler comp(*this, code);
+  comp.parameters(f);
+  comp.statement(def->statement());
+  comp.emit(op_fail);
+  return code;
+}
+
+
+// Record that none of the functions started in this session can be
+// compiled.
+void
+Session::fail()
+{
+  for (Function_decl const* f : started)
+    cxt.code.save(f, nullptr);
+}
+
+
+} // namespace
+
+
+// Returns the compiled code for f, or nullptr if f cannot be compiled.
+// Functions too large to encode are left to the evaluator.
+Function_code const*
+get_function_code(Context& cxt, Function_decl const& f)
+{
+  Context_lock lock(cxt);
+  Session sess(cxt);
+  try {
+    return &sess.function(f);
+  } catch (Unsupported&) {
+    sess.fail();
+    return nullptr;
+  } catch (Limitation_error&) {
+    sess.fail();
+    return nullptr;
+  } catch (...) {
+    sess.fail();
+    throw;
+  }
+}
+
+
+// Compile e into the given code, which must be empty. Returns false
+// if e cannot be compiled or is too large to encode.
+bool
+compile_expression(Context& cxt, Expr const& e, Function_code& code)
+{
+  Context_lock lock(cxt);
+  Session sess(cxt);
+  try {
+    Compiler comp(sess, code);
+    Slot s = comp.temp();
+    comp.expression(e, s);
+    comp.emit(op_return, s);
+    return true;
+  } catch (Unsupported&) {
+    sess.fail();
+    return false;
+  } catch (Limitation_error&) {
+    sess.fail();
+    return false;
+  } catch (...) {
+    sess.fail();
+    throw;
+  }
+}
+
+
+// -------------------------------------------------------------------------- //
+// Memoization
+
+constexpr std::size_t Call_memo::max_args;
+constexpr std::size_t Call_memo::ways;
+constexpr std::size_t Call_memo::default_capacity;
+
+
+// The capacity is rounded up to a whole number of sets, and the
+// number of sets to a power of 2.
+Call_memo::Call_memo(std::size_t n)
+  : sets(1)
+{
+  while (sets * ways < n)
+    sets *= 2;
+  table.reset(new Entry[sets * ways]());
+}
+
+
+// Returns the set that may hold the result of calling f with the
+// given arguments.
+Call_memo::Entry*
+Call_memo::set(Function_code const& f, Key const& args)
+{
+  std::uint64_t h = reinterpret_cast<std::uintptr_t>(&f);
+  for (std::size_t i = 0; i < f.parms; ++i)
+    h = (h ^ std::uint64_t(args[i])) * 0x100000001b3ull;
+  h ^= h >> 32;
+  return &table[(h & (sets - 1)) * ways];
+}
+
+
+// If the result of calling f with the given arguments has been saved,
+// assign it to result and return true.
+bool
+Call_memo::find(Function_code const& f, Key const& args, Value& result)
+{
+  std::lock_guard<std::mutex> lock(sync);
+  Entry* s = set(f, args);
+  for (std::size_t i = 0; i < ways; ++i) {
+    Entry& e = s[i];
+    if (e.fn == &f && std::equal(args, args + f.parms, e.args)) {
+      e.used = ++clock;
+      result = e.result;
+      ++hit;
+      return true;
+    }
+  }
+  ++miss;
+  return false;
+}
+
+
+// Save the result of calling f with the given arguments, replacing
+// an empty or least recently used entry.
+void
+Call_memo::save(Function_code const& f, Key const& args, Value const& result)
+{
+  std::lock_guard<std::mutex> lock(sync);
+  Entry* s = set(f, args);
+  Entry* victim = s;
+  for (std::size_t i = 0; i < ways; ++i) {
+    if (!s[i].fn) {
+      victim = &s[i];
+      break;
+    }
+    if (s[i].used < victim->used)
+      victim = &s[i];
+  }
+  if (victim->fn)
+    ++evicted;
+  else
+    ++count;
+  victim->fn = &f;
+  std::copy(args, args + f.parms, victim->args);
+  victim->result = result;
+  victim->used = ++clock;
+}
+
+
+void
+print_statistics(std::ostream& os, char const* name, Call_memo const& m)
+{
+  os << name << ": " << m.size() << " of " << m.capacity() << " entries, "
+     << m.hits() << " hits, "
+     << m.misses() << " misses, "
+     << m.evictions() << " evictions\n";
+}
+
+
+// -------------------------------------------------------------------------- //
+// Virtual machine
+
+namespace
+{
+
+// Restores the size of the stack when a computation completes or
+// is abandoned.
+struct Save_stack
+{
+  Save_stack(std::vector<Value>& s)
+    : stack(s), size(s.size())
+  { }
+
+  ~Save_stack()
+  {
+    stack.resize(size);
+  }
+
+  std::vector<Value>& stack;
+  std::size_t         size;
+};
+
+
+// The return address of a call. If the result of the call is to be
+// cached, the frame also holds the callee and its arguments, since
+// the callee may assign to its parameters.
+struct Frame
+{
+  Function_code const* code;
+  Instruction const*   pc;
+  std::size_t          base;
+  Slot                 ret;
+  Function_code const* callee;
+  Call_memo::Key       args;
+};
+
+
+} // namespace
+
+
+// Execute the code with the given arguments.
+Value
+Machine::operator()(Function_code const& f, Value const* args)
+{
+  Save_stack save(stack);
+  std::vector<Frame> frames;
+
+  Function_code const* code = &f;
+  Instruction const* pc = code->code.data();
+  std::size_t base = stack.size();
+  stack.resize(base + code->frame);
+  std::copy(args, args + code->parms, stack.begin() + base);
+  Value* r = &stack[base];
+
+  // Steps are counted locally, and stored in the budget before each
+  // call and return so that they are attributed to the right function.
+  std::size_t steps = budget ? budget->steps : 0;
+  std::size_t limit = budget ? budget->max_steps : std::numeric_limits<std::size_t>::max();
+
+  #define int_(n) r[n].get_integer()
+  while (true) {
+    if (++steps > limit) {
+      budget->steps = steps;
+      budget->exceeded_steps();
+    }
+    Instruction const& i = *pc++;
+    switch (i.op) {
+      case op_const: r[i.a] = code->constants[i.b]; break;
+      case op_move: r[i.a] = r[i.b]; break;
+
+      case op_add: r[i.a] = wrap(std::uint64_t(int_(i.b)) + int_(i.c)); break;
+      case op_sub: r[i.a] = wrap(std::uint64_t(int_(i.b)) - int_(i.c)); break;
+      case op_mul: r[i.a] = wrap(std::uint64_t(int_(i.b)) * int_(i.c)); break;
+      case op_div: r[i.a] = divide(int_(i.b), int_(i.c)); break;
+      case op_rem: r[i.a] = remainder(int_(i.b), int_(i.c)); break;
+      case op_neg: r[i.a] = wrap(-std::uint64_t(int_(i.b))); break;
+
+      case op_bit_and: r[i.a] = int_(i.b) & int_(i.c); break;
+      case op_bit_or: r[i.a] = int_(i.b) | int_(i.c); break;
+      case op_bit_xor: r[i.a] = int_(i.b) ^ int_(i.c); break;
+      case op_bit_lsh: r[i.a] = wrap(std::uint64_t(int_(i.b)) << shift_count(int_(i.c))); break;
+      case op_bit_rsh: r[i.a] = int_(i.b) >> shift_count(int_(i.c)); break;
+      case op_bit_not: r[i.a] = ~int_(i.b); break;
+
+      case op_eq: r[i.a] = int(int_(i.b) == int_(i.c)); break;
+      case op_ne: r[i.a] = int(int_(i.b) != int_(i.c)); break;
+      case op_lt: r[i.a] = int(int_(i.b) < int_(i.c)); break;
+      case op_gt: r[i.a] = int(int_(i.b) > int_(i.c)); break;
+      case op_le: r[i.a] = int(int_(i.b) <= int_(i.c)); break;
+      case op_ge: r[i.a] = int(int_(i.b) >= int_(i.c)); break;
+      case op_cmp: r[i.a] = int(int_(i.b) > int_(i.c)) - int(int_(i.b) < int_(i.c)); break;
+
+      case op_not: r[i.a] = int(!int_(i.b)); break;
+      case op_bool: r[i.a] = int(int_(i.b) != 0); break;
+      case op_sext: r[i.a] = sign_extend(int_(i.b), i.c); break;
+      case op_zext: r[i.a] = zero_extend(int_(i.b), i.c); break;
+
+      case op_jump: pc = code->code.data() + i.a; break;
+      case op_jump_if: if (int_(i.b)) pc = code->code.data() + i.a; break;
+      case op_jump_ifn: if (!int_(i.b)) pc = code->code.data() + i.a; break;
+
+      case op_call: {
+        Function_code const& g = *code->callees[i.b].code;
+        frames.push_back({code, pc, base, i.a, nullptr, {}});
+        if (memo && g.parms <= Call_memo::max_args) {
+          Frame& f = frames.back();
+          for (std::size_t k = 0; k < g.parms; ++k)
+            f.args[k] = int_(i.c + k);
+          if (memo->find(g, f.args, r[i.a])) {
+            frames.pop_back();
+            break;
+          }
+          f.callee = &g;
+        }
+        if (budget) {
+          budget->steps = steps;
+          budget->enter(*code->callees[i.b].fn, g.frame * sizeof(Value));
+        }
+        std::size_t next = stack.size();
+        stack.resize(next + g.frame);
+        std::copy_n(stack.begin() + base + i.c, g.parms, stack.begin() + next);
+        code = &g;
+        pc = g.code.data();
+        base = next;
+        r = &stack[base];
+        break;
+      }
+
+      case op_return: {
+        Value v = r[i.a];
+        stack.resize(base);
+        if (budget)
+          budget->steps = steps;
+        if (frames.empty())
+          return v;
+        if (budget)
+          budget->leave();
+        Frame f = frames.back();
+        frames.pop_back();
+        code = f.code;
+        pc = f.pc;
+        base = f.base;
+        r = &stack[base];
+        r[f.ret] = v;
+        if (f.callee)
+          memo->save(*f.callee, f.args, v);
+        break;
+      }
+
+      case op_fail:
+        throw Evaluation_error("function evaluation failed");
+    }
+  }
+  #undef int_
+}
+
+
+// -------------------------------------------------------------------------- //
+// Evaluation
+
+Value
+evaluate(Context& cxt, Expr const& e)
+{
+  Evaluation_budget budget(cxt);
+  Function_code code(nullptr);
+  if (compile_expression(cxt, e, code)) {
+    Machine vm(&cxt.calls, &budget);
+    return vm(code, nullptr);
+  }
+  Evaluator eval(&budget);
+  return eval(e);
+}
+
+
+} // namespace banjo
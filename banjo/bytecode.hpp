@@ -0,0 +1,210 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_BYTECODE_HPP
+#define BANJO_BYTECODE_HPP
+
+// This module lowers function definitions and constant expressions
+// into a compact register bytecode, and defines the virtual machine
+// that executes it.
+//
+// Each function is compiled once into a frame of fixed size. The
+// parameters and local variables use the slots assigned to them when
+// the definition was elaborated (see allocate_frame), and temporaries
+// follow them. The machine never looks up a declaration while running.
+//
+// Only a subset of the language is compiled: integer and boolean
+// arithmetic, local variables, assignment, control flow, and calls
+// to functions in that subset. Anything else is rejected at compile
+// time, and evaluation falls back to the tree-walking evaluator.
+
+#include "prelude.hpp"
+#include "language.hpp"
+#include "cache.hpp"
+#include "value.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace banjo
+{
+
+struct Context;
+struct Evaluation_budget;
+
+
+// The instructions of the virtual machine. Unless noted otherwise,
+// operands a, b, and c are slots in the current frame, and an
+// instruction computes `a = b op c`.
+enum Opcode : std::uint16_t
+{
+  op_const,     // a = constants[b]
+  op_move,      // a = b
+  op_add,
+  op_sub,
+  op_mul,
+  op_div,
+  op_rem,
+  op_neg,       // a = -b
+  op_bit_and,
+  op_bit_or,
+  op_bit_xor,
+  op_bit_lsh,
+  op_bit_rsh,
+  op_bit_not,   // a = ~b
+  op_eq,
+  op_ne,
+  op_lt,
+  op_gt,
+  op_le,
+  op_ge,
+  op_cmp,       // a = -1, 0, or 1
+  op_not,       // a = !b
+  op_bool,      // a = b != 0
+  op_sext,      // a = the low c bits of b, sign extended
+  op_zext,      // a = the low c bits of b
+  op_jump,      // goto a
+  op_jump_if,   // if (b) goto a
+  op_jump_ifn,  // if (!b) goto a
+  op_call,      // a = callees[b](c, c + 1, ...)
+  op_return,    // return a
+  op_fail,      // control flowed off the end of a function
+};
+
+
+// An instruction. The meaning of the operands depends on the opcode.
+struct Instruction
+{
+  Opcode        op;
+  std::uint16_t a;
+  std::uint16_t b;
+  std::uint16_t c;
+};
+
+
+struct Function_code;
+
+
+// A function called by compiled code. The code is compiled along
+// with the caller.
+struct Callee
+{
+  Function_decl const* fn;
+  Function_code const* code;
+};
+
+
+// The compiled form of a function definition or expression.
+struct Function_code
+{
+  Function_code(Function_decl const* f)
+    : fn(f), parms(0), frame(0)
+  { }
+
+  Function_decl const*     fn;        // The function, or null
+  std::size_t              parms;     // The number of parameters
+  std::size_t              frame;     // The number of slots
+  std::vector<Instruction> code;      // The instructions
+  std::vector<Value>       constants; // Literal values
+  std::vector<Callee>      callees;   // Called functions
+};
+
+
+// Maps a function to its compiled code. A null entry records that
+// the function cannot be compiled.
+using Code_cache = Memo_table<Function_decl const*, Function_code const*>;
+
+
+Function_code const* get_function_code(Context&, Function_decl const&);
+bool                 compile_expression(Context&, Expr const&, Function_code&);
+
+
+// Caches the results of calls made by the virtual machine. Compiled
+// code can only read its arguments and write its own locals, so every
+// compiled function is free of side effects, and a call with the same
+// arguments always produces the same value.
+//
+// The table is set-associative with a fixed number of entries. When
+// a set is full, its least recently used entry is evicted. Calls to
+// functions with more than max_args parameters are not cached.
+//
+// The table has its own mutex so that it can be shared by machines
+// running on different threads.
+struct Call_memo
+{
+  static constexpr std::size_t max_args = 4;
+  static constexpr std::size_t ways = 4;
+  static constexpr std::size_t default_capacity = 1 << 14;
+
+  using Key = Integer_value[max_args];
+
+  struct Entry
+  {
+    Function_code const* fn;     // The callee, or null if empty
+    Key                  args;   // The arguments
+    Value                result; // The returned value
+    std::size_t          used;   // The time of the last use
+  };
+
+  Call_memo(std::size_t = default_capacity);
+
+  bool find(Function_code const&, Key const&, Value&);
+  void save(Function_code const&, Key const&, Value const&);
+
+  std::size_t size() const      { return count; }
+  std::size_t capacity() const  { return sets * ways; }
+  std::size_t hits() const      { return hit; }
+  std::size_t misses() const    { return miss; }
+  std::size_t evictions() const { return evicted; }
+
+  Entry* set(Function_code const&, Key const&);
+
+  std::unique_ptr<Entry[]> table;
+  std::size_t              sets;
+  std::size_t              clock = 0;
+  std::size_t              count = 0;
+  std::size_t              hit = 0;
+  std::size_t              miss = 0;
+  std::size_t              evicted = 0;
+  std::mutex               sync;
+};
+
+
+void print_statistics(std::ostream&, char const*, Call_memo const&);
+
+
+// The virtual machine. The registers of all active calls are kept in
+// a single stack, so a call only needs to extend the stack by the
+// size of the callee's frame.
+//
+// If the machine has a memo table, the results of calls are cached
+// in it, and repeated calls are not executed. If the machine has a
+// budget, each instruction is charged as a step, and each call is
+// charged against the depth and memory limits.
+struct Machine
+{
+  Machine(Call_memo* m = nullptr, Evaluation_budget* b = nullptr)
+    : memo(m), budget(b)
+  { }
+
+  Value operator()(Function_code const&, Value const*);
+
+  Call_memo*         memo;   // Results of previous calls, if any
+  Evaluation_budget* budget; // Limits on the computation, if any
+  std::vector<Value> stack;  // Slots of active frames
+};
+
+
+// Evaluate the expression with the virtual machine if it can be
+// compiled, or with the tree-walking evaluator otherwise.
+Value evaluate(Context&, Expr const&);
+
+
+} // namespace banjo
+
+
+#endif
@@ -0,0 +1,91 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_CACHE_HPP
+#define BANJO_CACHE_HPP
+
+// This module defines memo tables used to cache the results of
+// expensive semantic computations (e.g., concept expansion).
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+
+namespace banjo
+{
+
+// A memo table maps keys to previously computed results. The table
+// records the number of successful and failed lookups.
+//
+// The table has its own mutex, so that it can be shared by threads
+// elaborating definitions concurrently. Results are copied in and out
+// of the table while the mutex is held.
+template<typename K, typename V, typename H = std::hash<K>, typename E = std::equal_to<K>>
+struct Memo_table
+{
+  using Map = std::unordered_map<K, V, H, E>;
+
+  // If a result is cached for k, assign it to v and return true.
+  bool find(K const& k, V& v)
+  {
+    std::lock_guard<std::mutex> lock(sync);
+    auto iter = map.find(k);
+    if (iter == map.end()) {
+      ++miss;
+      return false;
+    }
+    ++hit;
+    v = iter->second;
+    return true;
+  }
+
+  // Save the result v for the key k, replacing any previous result.
+  void save(K const& k, V const& v)
+  {
+    std::lock_guard<std::mutex> lock(sync);
+    map[k] = v;
+  }
+
+  // Remove the result for k.
+  void erase(K const& k)
+  {
+    std::lock_guard<std::mutex> lock(sync);
+    map.erase(k);
+  }
+
+  // Remove all results. Statistics are retained.
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(sync);
+    map.clear();
+  }
+
+  std::size_t size() const   { return map.size(); }
+  std::size_t hits() const   { return hit; }
+  std::size_t misses() const { return miss; }
+
+  Map         map;
+  std::size_t hit = 0;
+  std::size_t miss = 0;
+  std::mutex  sync;
+};
+
+
+// Print the statistics of the named memo table.
+template<typename K, typename V, typename H, typename E>
+void
+print_statistics(std::ostream& os, char const* name, Memo_table<K, V, H, E> const& m)
+{
+  os << name << ": " << m.size() << " entries, "
+     << m.hits() << " hits, "
+     << m.misses() << " misses\n";
+}
+
+
+} // namespace banjo
+
+
+#endif
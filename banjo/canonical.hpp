@@ -0,0 +1,109 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_CANONICAL_HPP
+#define BANJO_CANONICAL_HPP
+
+// This module defines the tables used to canonicalize terms. A
+// canonical term is constructed at most once for any combination
+// of its components. Because the components of a canonical term
+// are themselves canonical, the table is keyed on the identity of
+// those components and not their structure.
+
+#include "prelude.hpp"
+#include "language.hpp"
+
+#include <boost/functional/hash.hpp>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+
+namespace banjo
+{
+
+// A unique table maps the components of a term to the canonical
+// term constructed from those components.
+template<typename K, typename T, typename H = boost::hash<K>, typename E = std::equal_to<K>>
+using Unique_table = std::unordered_map<K, T*, H, E>;
+
+
+// A sequence of types used as the key of a function or tuple type.
+// For function types, the return type is the last element.
+using Type_seq = std::vector<Type const*>;
+
+
+// The key of an array type. The extent is compared structurally
+// since expressions are not canonicalized.
+struct Extent_key
+{
+  Type const* type;
+  Expr const* extent;
+};
+
+
+struct Extent_hash
+{
+  std::size_t operator()(Extent_key const& k) const
+  {
+    std::size_t h = 0;
+    boost::hash_combine(h, k.type);
+    boost::hash_combine(h, hash_value(*k.extent));
+    return h;
+  }
+};
+
+
+struct Extent_eq
+{
+  bool operator()(Extent_key const& a, Extent_key const& b) const
+  {
+    return a.type == b.type && is_equivalent(*a.extent, *b.extent);
+  }
+};
+
+
+// The canonical types of a translation context. Every type built
+// by the builder is registered in (and found in) this table, except
+// for unparsed types.
+struct Type_table
+{
+  Type_table()
+    : void_(), bool_(), byte_()
+  { }
+
+  Void_type*    void_;
+  Boolean_type* bool_;
+  Byte_type*    byte_;
+
+  Unique_table<std::pair<bool, int>, Integer_type>                          ints;
+  Unique_table<int, Float_type>                                             floats;
+  Unique_table<Type_seq, Function_type>                                     fns;
+  Unique_table<std::pair<Type const*, int>, Qualified_type>                 quals;
+  Unique_table<Type const*, Pointer_type>                                   ptrs;
+  Unique_table<Type const*, Reference_type>                                 refs;
+  Unique_table<Type const*, Slice_type>                                     slices;
+  Unique_table<Type const*, Pack_type>                                      packs;
+  Unique_table<Type_seq, Tuple_type>                                        tuples;
+  Unique_table<Extent_key, Array_type, Extent_hash, Extent_eq>              arrays;
+  Unique_table<Extent_key, Dynarray_type, Extent_hash, Extent_eq>           dynarrays;
+  Unique_table<Decl const*, Class_type>                                     classes;
+  Unique_table<Decl const*, Typename_type>                                  typenames;
+  Unique_table<Decl const*, Coroutine_type>                                 coroutines;
+  Unique_table<Decl const*, Auto_type>                                      autos;
+  Unique_table<Decl const*, Synthetic_type>                                 synthetics;
+};
+
+
+// The canonical constraints of a translation context. Constraints
+// are compared structurally when they are first registered. Since
+// the operands of a constraint are canonical, later comparisons of
+// constraints only need to compare their identities.
+using Cons_set = std::unordered_set<Cons const*, Cons_hash, Cons_eq>;
+
+
+} // namespace banjo
+
+
+#endif
@@ -41,10 +41,8 @@ expand_def(Context& cxt, Concept_def& def, Substitution& sub)
 
 // Expand the concept by substituting the template arguments
 // throughthe concept's definition and normalizing the result.
-//
-// TODO: Memoize the expansions.
-Cons&
-expand(Context& cxt, Concept_cons& c)
+static Cons&
+expand_concept(Context& cxt, Concept_cons& c)
 {
   Concept_decl& d = c.declaration();
   Decl_list& tparms = d.parameters();
@@ -64,6 +62,21 @@ expand(Context& cxt, Concept_cons& c)
 }
 
 
+// Returns the expansion of the concept constraint c. Concept
+// constraints are canonical, so the expansion for a concept and
+// its arguments is computed once and cached in the context.
+Cons&
+expand(Context& cxt, Concept_cons& c)
+{
+  Cons* p;
+  if (cxt.expansions.find(&c, p))
+    return *p;
+  Cons& r = expand_concept(cxt, c);
+  cxt.expansions.save(&c, &r);
+  return r;
+}
+
+
 Cons const&
 expand(Context& cxt, Concept_cons const& c)
 {
@@ -91,7 +104,7 @@ admit_concept_expr(Context& cxt, Concept_cons& c, Expr& e)
 // does a reference-expression appear as a constraint?
 template<typename Usage>
 Expr*
-admit_reference_expr(Context& cxt, Usage& c, Reference_expr& e)
+admit_reference_expr(Context& cxt, Usage& c, Decl_expr& e)
 {
   return &e;
 }
@@ -114,6 +127,7 @@ admit_binary_expr(Context& cxt, Usage& c, Binary_expr& e)
   Type& t1 = declared_type(a.left());
   Type& t2 = declared_type(a.right());
   try {
+    Suppress_diagnostics quiet(cxt);
     copy_initialize(cxt, t1, e.left());
     copy_initialize(cxt, t2, e.right());
   } catch(Translation_error&) {
@@ -152,6 +166,7 @@ admit_call_expr(Context& cxt, Usage& c, Call_expr& e)
 
   // If conversion fails, this is not accessible.
   try {
+    Suppress_diagnostics quiet(cxt);
     initialize_parameters(cxt, ts, es);
   } catch (Translation_error&) {
     return nullptr;
@@ -175,7 +190,7 @@ admit_usage_expr(Context& cxt, Usage& c, Expr& e)
     Context& cxt;
     Usage&   c;
     Expr* operator()(Expr& e)           { banjo_unhandled_case(e); }
-    Expr* operator()(Reference_expr& e) { return admit_reference_expr(cxt, c, e); }
+    Expr* operator()(Decl_expr& e)      { return admit_reference_expr(cxt, c, e); }
     Expr* operator()(Binary_expr& e)    { return admit_binary_expr(cxt, c, e); }
     Expr* operator()(Call_expr& e)      { return admit_call_expr(cxt, c, e); }
   };
@@ -215,7 +230,7 @@ admit_disjunction_expr(Context& cxt, Disjunction_cons& c, Expr& e)
 {
   if (Expr* e1 = admit_expression(cxt, c.left(), e)) {
     if (Expr* e2 = admit_expression(cxt, c.right(), e)) {
-      if (!is_equivalent(e1->type(), e2->type()))
+      if (!is_same(e1->type(), e2->type()))
         throw Translation_error(cxt, "multiple types deduced for '{}'", e);
       return e1;
     }
@@ -301,6 +316,7 @@ admit_binary_conv(Context& cxt, Conversion_cons& c, Binary_expr& e)
   Type& t1 = declared_type(a.left());
   Type& t2 = declared_type(a.right());
   try {
+    Suppress_diagnostics quiet(cxt);
     copy_initialize(cxt, t1, e.left());
     copy_initialize(cxt, t2, e.right());
   } catch(Translation_error&) {
@@ -322,9 +338,7 @@ admit_binary_conv(Context& cxt, Conversion_cons& c, Binary_expr& e)
   // prefer #1. Perhaps we should collect viable conversion
   // and then sort at the end. Note that this is true for simple
   // typings also.
-  //
-  // FIXME: Add constructors to the builder. This is just plain dumb.
-  return new Dependent_conv(c.type(), e);
+  return &cxt.make<Dependent_conv>(c.type(), e);
 }
 
 
@@ -346,7 +360,7 @@ admit_usage_conv(Context& cxt, Conversion_cons& c, Expr& e, Type& t)
 
   // If the expression's type is not equivalent to t, this constraint
   // does not prove admissibility.
-  if (!is_equivalent(c.type(), t))
+  if (!is_same(c.type(), t))
     return nullptr;
 
   return apply(e, fn{cxt, c});
@@ -13,11 +13,17 @@
 namespace banjo
 {
 
+thread_local Local_state* Context::worker = nullptr;
+
+
 Context::Context()
-  : Builder(*this), syms()
-  , global(&make_scope()), scope(nullptr)
+  : Builder(*this), syms(), interns(syms)
+  , state{nullptr, Location(), nullptr, nullptr}
+  , global(new Scope())
   , id(0)
-  , diags(false)
+  , profiling(false)
+  , lazy(false)
+  , jobs(1), concurrent(false)
 {
   // Initialize the color system. This is a process-level
   // configuration. Perhaps we we should only initialize
@@ -35,7 +41,7 @@ Context::Context()
 Decl*
 Context::immediate_context()
 {
-  return scope->context();
+  return current_scope().context();
 }
 
 
@@ -43,7 +49,7 @@ Context::immediate_context()
 Decl*
 Context::current_context()
 {
-  Scope* p = scope;
+  Scope* p = local().scope;
   while (p) {
     if (Decl* d = p->context())
       return d;
@@ -53,4 +59,18 @@ Context::current_context()
 }
 
 
+void
+print_statistics(std::ostream& os, Context const& cxt)
+{
+  print_statistics(os, cxt.memory());
+  for (auto const& a : cxt.arenas)
+    print_statistics(os, *a);
+  print_statistics(os, "expansions", cxt.expansions);
+  print_statistics(os, "satisfaction", cxt.satisfied);
+  print_statistics(os, "subsumption", cxt.subsumed);
+  print_statistics(os, "bytecode", cxt.code);
+  print_statistics(os, "calls", cxt.calls);
+}
+
+
 } // namespace banjo
@@ -5,9 +5,23 @@
 #define BANJO_CONTEXT_HPP
 
 #include "prelude.hpp"
+#include "ast-eq.hpp"
+#include "ast-hash.hpp"
+#include "budget.hpp"
 #include "builder.hpp"
+#include "bytecode.hpp"
+#include "canonical.hpp"
+#include "cache.hpp"
+#include "intern.hpp"
+#include "diagnostics.hpp"
+#include "incremental.hpp"
 #include "scope.hpp"
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 
 namespace banjo
 {
@@ -19,9 +33,82 @@ struct Scope;
 using Scope_map = std::unordered_map<Decl*, Scope*>;
 
 
-// A repository of information to support translation.
-//
-// TODO: Add an allocator/object pool and management support.
+// A definition whose elaboration has been deferred until the declaration
+// is referenced (see require_definition). The definition is elaborated
+// by the first thread that requires it. Other threads wait until it is
+// done.
+struct Deferred
+{
+  enum State
+  {
+    pending, // Not yet elaborated
+    active,  // Being elaborated by the owner
+    done,    // Elaborated
+  };
+
+  Scope*          scope; // The scope of the definition
+  State           state;
+  std::thread::id owner; // The elaborating thread, if active
+};
+
+
+// Maps deferred declarations to the state of their definitions.
+using Deferred_map = std::unordered_map<Decl*, Deferred>;
+
+
+// Maps a thread to the deferred definition it is waiting for.
+using Waiting_map = std::unordered_map<std::thread::id, Decl*>;
+
+
+// Maps a (canonical) concept constraint to its expansion.
+using Expansion_cache = Memo_table<Concept_cons const*, Cons*>;
+
+// The result of satisfying a (canonical) constraint, and the names of
+// the declarations that the result depends on.
+struct Satisfaction
+{
+  bool                     result;
+  std::vector<Name const*> names;
+};
+
+
+// Maps a (canonical) constraint to the result of its satisfaction.
+// Results are indexed by the names they depend on, so that declaring
+// a name discards only the results that it could change (see
+// declare()).
+struct Satisfaction_cache : Memo_table<Cons const*, Satisfaction>
+{
+  using Index = std::unordered_map<Name const*, std::vector<Cons const*>, Name_hash, Name_eq>;
+
+  void save(Cons const*, Satisfaction const&);
+  void invalidate(Name const&);
+  void clear();
+
+  Index users; // The constraints whose results depend on each name
+};
+
+
+// Maps a pair of (canonical) constraints (a, c) to the result of
+// proving that a subsumes c.
+using Cons_pair = std::pair<Cons const*, Cons const*>;
+using Subsumption_cache = Memo_table<Cons_pair, bool, boost::hash<Cons_pair>>;
+
+
+// Translation state that is local to a thread of elaboration. The
+// main thread uses the context's own state. Worker threads install
+// their own state (see Enter_worker).
+struct Local_state
+{
+  Scope*             scope; // The current scope
+  Location           input; // The input location
+  Diagnostic_buffer* diags; // Buffered diagnostics, if any
+  Decl const*        decl;  // The tracked declaration being elaborated
+};
+
+
+// A repository of information to support translation. The context
+// owns the arena in which all terms are allocated; those terms are
+// released when the context is destroyed.
 //
 // TODO: Integrate diagnostics.
 struct Context : Builder
@@ -36,12 +123,24 @@ struct Context : Builder
   Symbol_table const& symbols() const { return syms; }
   Symbol_table&       symbols()       { return syms; }
 
+  // Returns the concurrent interning table.
+  Intern_table const& spellings() const { return interns; }
+  Intern_table&       spellings()       { return interns; }
+
+  // Returns the memory arena for terms.
+  Arena const& memory() const { return arena; }
+  Arena&       memory()       { return arena; }
+
   // Unique ids
   int get_unique_id();
 
+  // Returns the state of the current thread.
+  Local_state const& local() const { return worker ? *worker : state; }
+  Local_state&       local()       { return worker ? *worker : state; }
+
   // Input location
-  Location input_location() const       { return input; }
-  void     input_location(Location loc) { input = loc; }
+  Location input_location() const       { return local().input; }
+  void     input_location(Location loc) { local().input = loc; }
 
   // Scope management
   Scope& make_scope();
@@ -54,31 +153,88 @@ struct Context : Builder
   Decl* immediate_context();
   Decl* current_context();
 
-  // Diagnostic state
-  bool diagnose_errors() const { return diags; }
-
-  Symbol_table syms;   // The symbol table
-  Location     input;  // The input location
+  // Diagnostic state. Returns false if diagnostics are being
+  // discarded.
+  bool diagnose_errors() const { return !local().diags || !local().diags->discard; }
 
+  Arena        arena;   // Memory for terms
+  Type_table   types;   // Canonical types
+  Cons_set     cons;    // Canonical constraints
+  Symbol_table syms;    // The symbol table
+  Intern_table interns; // Interned spellings
+  Local_state  state;   // The state of the main thread
 
   // Scope information
   Scope*       global; // The global scope
-  Scope*       scope;  // The current scope
   Scope_map    saved;  // Saved scopes.
 
   // Store information for generating unique names.
   int             id;     // The current id counter
 
-  // Diagnostic state
-  bool diags; // True if diagnostics should be emitted.
+  // Memoized semantic computations.
+  Expansion_cache    expansions; // Expanded concepts
+  Satisfaction_cache satisfied;  // Satisfied constraints
+  Subsumption_cache  subsumed;   // Proven subsumptions
+
+  // Compiled functions for compile-time evaluation.
+  Code_cache code;  // Compiled functions
+  Call_memo  calls; // Results of compile-time calls
+
+  // Resources for compile-time evaluation (see budget.hpp).
+  Evaluation_limits  limits;    // Limits on each evaluation
+  bool               profiling; // True if calls are profiled
+  Evaluation_profile profile;   // Profiled calls
+
+  // Incremental compilation.
+  Decl_tracker tracker; // Token hashes and uses of declarations
+
+  // Lazy elaboration. Deferred definitions are elaborated when they
+  // are first referenced (see require_definition).
+  bool         lazy;     // True if definitions are elaborated on demand
+  Deferred_map deferred; // Deferred definitions and their scopes
+  Waiting_map  waiting;  // Definitions awaited by other threads
+
+  // Concurrency. While worker threads are active, the shared tables
+  // above are guarded by the context's mutex (see Context_lock).
+  int                                 jobs;       // Maximum worker threads
+  bool                                concurrent; // True if workers are active
+  std::mutex                          sync;       // Guards shared tables
+  std::condition_variable             elaborated; // Signals deferred definitions
+  std::vector<std::unique_ptr<Arena>> arenas;     // Memory for worker terms
+
+  // The state of the current worker thread, if any.
+  static thread_local Local_state* worker;
 };
 
 
-// Returns a new general purpose scope.
+// Acquires the context's mutex while worker threads are active.
+struct Context_lock
+{
+  Context_lock(Context& cxt)
+    : m(cxt.concurrent ? &cxt.sync : nullptr)
+  {
+    if (m)
+      m->lock();
+  }
+
+  ~Context_lock()
+  {
+    if (m)
+      m->unlock();
+  }
+
+  std::mutex* m;
+};
+
+
+// Returns a new general purpose scope. The outermost scope of a
+// translation has no enclosing scope.
 inline Scope&
 Context::make_scope()
 {
-  return *new Scope(current_scope());
+  if (Scope* s = local().scope)
+    return *new Scope(*s);
+  return *new Scope();
 }
 
 
@@ -86,7 +242,9 @@ Context::make_scope()
 inline Scope&
 Context::make_scope(Decl& d)
 {
-  return *new Scope(current_scope(), d);
+  if (Scope* s = local().scope)
+    return *new Scope(*s, d);
+  return *new Scope(d);
 }
 
 
@@ -96,6 +254,7 @@ Context::make_scope(Decl& d)
 inline Scope&
 Context::saved_scope(Decl& d)
 {
+  Context_lock lock(*this);
   auto iter = saved.find(&d);
   if (iter != saved.end()) {
     return *iter->second;
@@ -116,7 +275,7 @@ Context::saved_scope(Decl& d)
 inline void
 Context::set_scope(Scope& s)
 {
-  scope = &s;
+  local().scope = &s;
 }
 
 
@@ -124,7 +283,7 @@ Context::set_scope(Scope& s)
 inline Scope&
 Context::current_scope()
 {
-  return *scope;
+  return *local().scope;
 }
 
 
@@ -134,10 +293,15 @@ Context::current_scope()
 inline int
 Context::get_unique_id()
 {
+  Context_lock lock(*this);
   return id++;
 }
 
 
+// Print memory usage and the statistics of memoized computations.
+void print_statistics(std::ostream&, Context const&);
+
+
 // An RAII helper that manages the entry and exit of scopes.
 struct Enter_scope
 {
@@ -179,6 +343,30 @@ Enter_scope::~Enter_scope()
 }
 
 
+// -------------------------------------------------------------------------- //
+// Worker threads
+
+// Installs the local state and arena of a worker thread for the
+// lifetime of the object. The local state should start in the scope
+// where work was handed off.
+struct Enter_worker
+{
+  Enter_worker(Local_state& s, Arena& a)
+    : prev(Context::worker), arena(a)
+  {
+    Context::worker = &s;
+  }
+
+  ~Enter_worker()
+  {
+    Context::worker = prev;
+  }
+
+  Local_state* prev;
+  Use_arena    arena;
+};
+
+
 // -------------------------------------------------------------------------- //
 // Input location
 
@@ -202,30 +390,53 @@ struct Save_input_location
 // Diagnostic utilities
 
 
+// Install a diagnostic buffer for the current thread. Diagnostics
+// are collected in the buffer instead of being emitted. If the buffer
+// is null, diagnostics are emitted immediately.
 struct Change_diagnostics
 {
-  Change_diagnostics(Context& cxt, bool b)
-    : cxt(cxt), prev(cxt.diags)
+  Change_diagnostics(Context& cxt, Diagnostic_buffer* b)
+    : cxt(cxt), prev(cxt.local().diags), discarding(discarding_diagnostics)
   {
-    cxt.diags = b;
+    cxt.local().diags = b;
+    discarding_diagnostics = b && b->discard;
   }
 
   ~Change_diagnostics()
   {
-    cxt.diags = prev;
+    cxt.local().diags = prev;
+    discarding_diagnostics = discarding;
   }
 
-  Context& cxt;
-  bool     prev;
+  Context&           cxt;
+  Diagnostic_buffer* prev;
+  bool               discarding;
 };
 
 
-// Indicate that diagnostics should be suppressed.
-struct Suppress_diagnostics : Change_diagnostics
+// Collect diagnostics in the given buffer. The owner of the buffer
+// decides whether to emit, append, or discard them.
+struct Buffer_diagnostics : Change_diagnostics
+{
+  Buffer_diagnostics(Context& cxt, Diagnostic_buffer& b)
+    : Change_diagnostics(cxt, &b)
+  { }
+};
+
+
+// Indicate that diagnostics should be suppressed. Suppressed
+// diagnostics are counted, but never formatted.
+struct Suppress_diagnostics
 {
   Suppress_diagnostics(Context& cxt)
-    : Change_diagnostics(cxt, false)
+    : buf(true), change(cxt, &buf)
   { }
+
+  // Returns the number of errors suppressed.
+  std::size_t errors() const { return buf.errors(); }
+
+  Diagnostic_buffer  buf;
+  Change_diagnostics change;
 };
 
 
@@ -233,7 +444,7 @@ struct Suppress_diagnostics : Change_diagnostics
 struct Emit_diagnostics : Change_diagnostics
 {
   Emit_diagnostics(Context& cxt)
-    : Change_diagnostics(cxt, true)
+    : Change_diagnostics(cxt, nullptr)
   { }
 };
 
@@ -243,12 +454,30 @@ using lingo::warning;
 using lingo::note;
 
 
+// Emit a diagnostic at the current input position, or save it in
+// the current thread's buffer.
+template<typename... Args>
+inline void
+diagnose(Context& cxt, Diagnostic_kind k, char const* msg, Args const&... args)
+{
+  Diagnostic_buffer* buf = cxt.local().diags;
+  if (buf) {
+    buf->put(k, cxt.input_location(), msg, args...);
+    return;
+  }
+  Context_lock lock(cxt);
+  Diagnostic_buffer tmp;
+  tmp.put(k, cxt.input_location(), msg, args...);
+  tmp.emit();
+}
+
+
 // Emit a formatted message at the current input position.
 template<typename... Args>
 inline void
 error(Context& cxt, char const* msg, Args const&... args)
 {
-  error(cxt.input_location(), msg, args...);
+  diagnose(cxt, error_diag, msg, args...);
 }
 
 
@@ -257,7 +486,7 @@ template<typename... Args>
 inline void
 warning(Context& cxt, char const* msg, Args const&... args)
 {
-  warning(cxt.input_location(), msg, args...);
+  diagnose(cxt, warning_diag, msg, args...);
 }
 
 
@@ -266,7 +495,7 @@ template<typename... Args>
 inline void
 note(Context& cxt, char const* msg, Args const&... args)
 {
-  note(cxt.input_location(), msg, args...);
+  diagnose(cxt, note_diag, msg, args...);
 }
 
 
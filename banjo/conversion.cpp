@@ -31,10 +31,10 @@ namespace banjo
 // FIXME: Check that e's type is complete before invoking the
 // conversion.
 Expr&
-convert_object_to_value(Expr& e, Type& t)
+convert_object_to_value(Context& cxt, Expr& e, Type& t)
 {
   if (Reference_type* et = as<Reference_type>(&e.type()))
-    return *new Value_conv(et->type(), e);
+    return cxt.make<Value_conv>(et->type(), e);
   return e;
 }
 
@@ -42,10 +42,10 @@ convert_object_to_value(Expr& e, Type& t)
 // Perform at most one categorical conversion. There is currently
 // just one that could performed: object-to-value.
 Expr&
-convert_category(Expr& e, Type& t)
+convert_category(Context& cxt, Expr& e, Type& t)
 {
   if (!is<Reference_type>(&t))
-    return convert_object_to_value(e, t);
+    return convert_object_to_value(cxt, e, t);
   return e;
 }
 
@@ -55,10 +55,10 @@ convert_category(Expr& e, Type& t)
 
 // A value of integer type can be converted to bool.
 Expr&
-convert_to_bool(Expr& e, Boolean_type& t)
+convert_to_bool(Context& cxt, Expr& e, Boolean_type& t)
 {
   if (is<Integer_type>(&e.type()))
-    return *new Boolean_conv(t, e);
+    return cxt.make<Boolean_conv>(t, e);
   return e;
 }
 
@@ -75,7 +75,7 @@ convert_to_bool(Expr& e, Boolean_type& t)
 //
 // Also use a different conversion for bool-to-int?
 Expr&
-convert_to_wider_integer(Expr& e, Integer_type& t)
+convert_to_wider_integer(Context& cxt, Expr& e, Integer_type& t)
 {
   // A value of integer type can be converted...
   if (has_integer_type(e)) {
@@ -84,16 +84,16 @@ convert_to_wider_integer(Expr& e, Integer_type& t)
     // actually going to happen. Especially, if we convert
     // sign and widen simultaneously.
     if (et.precision() < t.precision())
-      return *new Integer_conv(t, e);
+      return cxt.make<Integer_conv>(t, e);
     else if (et.sign() != t.sign())
-      return *new Integer_conv(t, e);
+      return cxt.make<Integer_conv>(t, e);
     else
       return e;
   }
 
   // A value of type bool can be converted...
   if (is<Boolean_type>(&e.type()))
-    return *new Integer_conv(t, e);
+    return cxt.make<Integer_conv>(t, e);
 
   return e;
 }
@@ -148,7 +148,7 @@ convert_to_float(Expr& e, Float_type& t)
 //
 // TODO: Why are references not converted in C++?
 Expr&
-convert_value(Expr& e, Type& t)
+convert_value(Context& cxt, Expr& e, Type& t)
 {
   // Value conversions do not apply to reeference types.
   if (is<Reference_type>(&e.type()))
@@ -160,11 +160,11 @@ convert_value(Expr& e, Type& t)
 
   // Try a boolean conversion.
   if (Boolean_type* b = as<Boolean_type>(&u))
-    return convert_to_bool(e, *b);
+    return convert_to_bool(cxt, e, *b);
 
   // Try an integer conversion.
   if (Integer_type* z = as<Integer_type>(&u))
-    return convert_to_wider_integer(e, *z);
+    return convert_to_wider_integer(cxt, e, *z);
 
   // Try one of the floating point conversions.
   if (Float_type* f = as<Float_type>(&u))
@@ -243,7 +243,7 @@ is_similar(Type const& a, Type const& b)
   struct fn
   {
     Type const& b;
-    bool operator()(Type const& a)           { return is_equivalent(a, b); }
+    bool operator()(Type const& a)           { return is_same(a, b); }
     bool operator()(Qualified_type const&)   { lingo_unreachable(); }
     bool operator()(Pointer_type const& a)   { return is_similar(a, cast<Pointer_type>(b)); }
     bool operator()(Array_type const& a)     { return is_similar(a, cast<Array_type>(b)); }
@@ -373,13 +373,13 @@ can_convert_signature(Qualifier_list const& a, Qualifier_list const& b)
 // Note that the top-level cv-qualifiers can be removed by this
 // conversion since it applies to values (i.e., copies).
 Expr&
-convert_qualifier(Expr& e, Type& t)
+convert_qualifier(Context& cxt, Expr& e, Type& t)
 {
   if (is_similar(e.type(), t)) {
     Qualifier_list sa = get_qualification_signature(e.type());
     Qualifier_list sb = get_qualification_signature(t);
     if (can_convert_signature(sa, sb))
-      return *new Qualification_conv(t, e);
+      return cxt.make<Qualification_conv>(t, e);
   }
   return e;
 }
@@ -394,18 +394,18 @@ convert_qualifier(Expr& e, Type& t)
 // FIXME: Should `t` be an object type? That is we should perform
 // conversions iff we can declare an object of type T?
 Expr&
-standard_conversion(Expr& e, Type& t)
+standard_conversion(Context& cxt, Expr& e, Type& t)
 {
-  Expr& c1 = convert_category(e, t);
-  if (is_equivalent(c1.type(), t))
+  Expr& c1 = convert_category(cxt, e, t);
+  if (is_same(c1.type(), t))
     return c1;
 
-  Expr& c2 = convert_value(c1, t);
-  if (is_equivalent(c2.type(), t))
+  Expr& c2 = convert_value(cxt, c1, t);
+  if (is_same(c2.type(), t))
     return c2;
 
-  Expr& c3 = convert_qualifier(c2, t);
-  if (is_equivalent(c3.type(), t))
+  Expr& c3 = convert_qualifier(cxt, c2, t);
+  if (is_same(c3.type(), t))
     return c3;
 
   throw Type_error("cannot convert '{}' (type '{}') to '{}'", e, e.type(), t);
@@ -415,7 +415,7 @@ standard_conversion(Expr& e, Type& t)
 bool is_tuple_equiv_to_array(Tuple_type& t1, Array_type& t2)
 {
   for(auto it = t1.type_list().begin(); it != t1.type_list().end(); it++) {
-    if(!is_equivalent(*it,t2.type())) return false;
+    if(!is_same(*it,t2.type())) return false;
   }
   return true;
 }
@@ -424,12 +424,12 @@ bool is_tuple_equiv_to_array(Tuple_type& t1, Array_type& t2)
 // Try to find a conversion from a source expression `e` and
 // a destination type `t`.
 Expr&
-standard_conversion(Expr const& e, Type const& t)
+standard_conversion(Context& cxt, Expr const& e, Type const& t)
 {
   // Just forward to the non-const version of this function.
   // We strip the const qualifier because we're going to be
   // building new terms.
-  return standard_conversion(modify(e), modify(t));
+  return standard_conversion(cxt, modify(e), modify(t));
 }
 
 
@@ -461,7 +461,7 @@ convert_to_common_float(Expr& e1, Expr& e2)
 }
 
 Expr_pair
-convert_to_common_int(Expr& e1, Expr& e2)
+convert_to_common_int(Context& cxt, Expr& e1, Expr& e2)
 {
   Integer_type& t1 = cast<Integer_type>(e1.type());
   Integer_type& t2 = cast<Integer_type>(e2.type());
@@ -470,25 +470,24 @@ convert_to_common_int(Expr& e1, Expr& e2)
   // the most precision.
   if (t1.sign() == t2.sign()) {
     if (t1.precision() < t2.precision())
-      return {convert_to_wider_integer(e1, t2), e2};
+      return {convert_to_wider_integer(cxt, e1, t2), e2};
     if (t2.precision() < t1.precision())
-      return {e1, convert_to_wider_integer(e2, t1)};
+      return {e1, convert_to_wider_integer(cxt, e2, t1)};
   }
 
   // If the unsigned operand has greater rank than the signed
   // operand, convert to the type of the unsigned operand.
   if (t1.is_unsigned() && t2.precision() < t1.precision())
-    return {e1, convert_to_wider_integer(e2, t1)};
+    return {e1, convert_to_wider_integer(cxt, e2, t1)};
   if (t2.is_unsigned() && t1.precision() < t2.precision())
-    return {convert_to_wider_integer(e1, t2), e2};
+    return {convert_to_wider_integer(cxt, e1, t2), e2};
 
   // Otherwise, both operands are converted to the corresponding
   // unsigned type of the signed operand.
-  //
-  // FIXME: Use a Builder (hence context) for this conversion.
   int p = t1.is_signed() ? t1.precision() : t2.precision();
-  Integer_type& c = *new Integer_type(false, p);
-  return {convert_to_wider_integer(e1, c), convert_to_wider_integer(e2, c)};
+  Integer_type& c = cxt.get_integer_type(false, p);
+  return {convert_to_wider_integer(cxt, e1, c),
+          convert_to_wider_integer(cxt, e2, c)};
 }
 
 
@@ -513,10 +512,10 @@ convert_to_common_int(Expr& e1, Expr& e2)
 // conditional expression? Note that the arithmetic version converts
 // to values, and the conditional expression can retain references.
 Expr_pair
-arithmetic_conversion(Expr& e1, Expr& e2)
+arithmetic_conversion(Context& cxt, Expr& e1, Expr& e2)
 {
   // If the types are the same, no conversions are applied.
-  if (is_equivalent(e1.type(), e2.type()))
+  if (is_same(e1.type(), e2.type()))
     return {e1, e2};
 
   // If either operand has floating point type, convert to the type
@@ -528,7 +527,7 @@ arithmetic_conversion(Expr& e1, Expr& e2)
 
   // If both oerands have integer type, the following rules apply.
   if (has_integer_type(e1) && has_integer_type(e2))
-    return convert_to_common_int(e1, e2);
+    return convert_to_common_int(cxt, e1, e2);
 
   // TODO: No conversion from e1 to e2.
   throw Type_error("no usual arithmetic conversions for '{}' and '{}'", e1, e2);
@@ -536,9 +535,9 @@ arithmetic_conversion(Expr& e1, Expr& e2)
 
 
 Expr_pair
-arithmetic_conversion(Expr const& e1, Expr const& e2)
+arithmetic_conversion(Context& cxt, Expr const& e1, Expr const& e2)
 {
-  return arithmetic_conversion(modify(e1), modify(e2));
+  return arithmetic_conversion(cxt, modify(e1), modify(e2));
 }
 
 
@@ -700,13 +699,15 @@ dependent_conversion(Context& cxt, Expr& e, Type& t)
   // expression. Discard that conversion and replace it with
   // a dependent conversion.
   try {
+    Suppress_diagnostics quiet(cxt);
+
     // FIXME: If an object-to-value conversion is applied, then
     // we need to also ensure that the type is copy constructible.
     // Note that copy constructible would also entail move
     // constructible.
-    Expr& c = standard_conversion(e, t);
+    Expr& c = standard_conversion(cxt, e, t);
     (void)c;
-    return *new Dependent_conv(t, e);
+    return cxt.make<Dependent_conv>(t, e);
   } catch (Translation_error&) {
     // Fall through...
   }
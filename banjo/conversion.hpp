@@ -189,8 +189,8 @@ enum Conversion_comp
 
 // FIXME: All of these should take a context.
 
-Expr&     standard_conversion(Expr const&, Type const&);
-Expr_pair arithmetic_conversion(Expr const&, Expr const&);
+Expr&     standard_conversion(Context& cxt, Expr const&, Type const&);
+Expr_pair arithmetic_conversion(Context& cxt, Expr const&, Expr const&);
 Expr&     contextual_conversion_to_bool(Context& cxt, Expr&);
 Expr&     dependent_conversion(Context& cxt, Expr&, Type&);
 
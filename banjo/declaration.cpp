@@ -49,10 +49,37 @@ declare(Context& cxt, Overload_set& ovl, Decl& decl)
 }
 
 
-// Atdd the declaration d to the given scope.
+// Discard the cached satisfaction results that can change when d is
+// declared in the scope s. A member of a class can change any result
+// that depends on the class. A function, class, concept, or template
+// can change the results that depend on its name. Other declarations,
+// and declarations in block and function scopes, are not visible
+// where the constraints of a template are checked.
+static void
+invalidate_satisfaction(Context& cxt, Scope const& s, Decl const& d)
+{
+  Decl const* owner = s.context();
+  if (owner && (is<Class_decl>(owner) || is<Coroutine_decl>(owner))) {
+    cxt.satisfied.invalidate(owner->name());
+    return;
+  }
+  if (!owner && s.enclosing_scope())
+    return;
+  if (owner && is<Function_decl>(owner))
+    return;
+  if (is<Function_decl>(&d)
+      || is<Class_decl>(&d)
+      || is<Concept_decl>(&d)
+      || is<Template_decl>(&d))
+    cxt.satisfied.invalidate(d.name());
+}
+
+
+// Add the declaration d to the given scope.
 void
 declare(Context& cxt, Scope& scope, Decl& decl)
 {
+  invalidate_satisfaction(cxt, scope, decl);
   if (Overload_set* ovl = scope.lookup(decl.name()))
     declare(cxt, *ovl, decl);
   else
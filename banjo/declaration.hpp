@@ -21,6 +21,9 @@ void declare(Context&, Scope&, Decl&);
 
 void declare_required_expression(Context&, Expr&);
 
+// Lazy elaboration.
+void require_definition(Context&, Decl&);
+
 
 // Declaration checking.
 void check_declarations(Context& cxt, Decl const&, Decl const&);
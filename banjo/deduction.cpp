@@ -50,9 +50,9 @@ deduce_from_type(Pointer_type& p, Type& a, Substitution& sub)
 // Note that this form of deduction is not available in C++ since
 // arrays decay to pointers.
 bool
-deduce_from_type(Sequence_type& p, Type& a, Substitution& sub)
+deduce_from_type(Slice_type& p, Type& a, Substitution& sub)
 {
-  if (Sequence_type* t = as<Sequence_type>(&a))
+  if (Slice_type* t = as<Slice_type>(&a))
     return deduce_from_type(p.type(), t->type(), sub);
   return false;
 }
@@ -75,7 +75,7 @@ deduce_from_type(Typename_type& p, Type& a, Substitution& sub)
   Decl& d = p.declaration();
   if (sub.has_mapping(d)) {
     if (Type* t = as<Type>(sub.get_mapping(d))) {
-      if (!is_equivalent(a, *t))
+      if (!is_same(a, *t))
         return false;
     } else {
       sub.map_to(d, a);
@@ -107,15 +107,14 @@ deduce_from_type(Type& p, Type& a, Substitution& sub)
 
     bool operator()(Auto_type& p)      { lingo_unreachable(); }
     bool operator()(Decltype_type& p)  { lingo_unreachable(); }
-    bool operator()(Declauto_type& p)  { lingo_unreachable(); }
     bool operator()(Function_type& p)  { lingo_unreachable(); }
     bool operator()(Reference_type& p) { return deduce_from_type(p, a, sub); }
     bool operator()(Qualified_type& p) { return deduce_from_type(p, a, sub); }
     bool operator()(Pointer_type& p)   { return deduce_from_type(p, a, sub); }
     bool operator()(Array_type& p)     { lingo_unreachable(); }
-    bool operator()(Tuple& p)          { lingo_unreachable(); }
+    bool operator()(Tuple_type& p)     { lingo_unreachable(); }
     bool operator()(Dynarray_type& p)  { lingo_unreachable(); }
-    bool operator()(Sequence_type& p)  { return deduce_from_type(p, a, sub); }
+    bool operator()(Slice_type& p)     { return deduce_from_type(p, a, sub); }
     bool operator()(Typename_type& p)  { return deduce_from_type(p, a, sub); }
   };
   return apply(p, fn{a, sub});
@@ -178,9 +177,13 @@ select_template_parameters(Type& t, Substitution& init, Substitution& ret)
     void operator()(Qualified_type& t) { select_template_parameters(t.type(), init, ret); }
     void operator()(Pointer_type& t)   { select_template_parameters(t.type(), init, ret); }
     void operator()(Array_type& t)     { select_template_parameters(t.type(), init, ret); }
-    void operator()(Tuple& t)          { select_template_parameters(t.type(), init, ret); }
+    void operator()(Tuple_type& t)
+    {
+      for (Type& t1 : t.type_list())
+        select_template_parameters(t1, init, ret);
+    }
     void operator()(Dynarray_type& t)  { select_template_parameters(t.type(), init, ret); }
-    void operator()(Sequence_type& t)  { select_template_parameters(t.type(), init, ret); }
+    void operator()(Slice_type& t)     { select_template_parameters(t.type(), init, ret); }
     void operator()(Typename_type& t)  { select_template_parameter(t, init, ret); }
   };
   apply(t, fn{init, ret});
@@ -0,0 +1,52 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "diagnostics.hpp"
+
+#include <iterator>
+
+
+namespace banjo
+{
+
+void
+Diagnostic_buffer::append(Diagnostic_buffer& b)
+{
+  nerrors += b.nerrors;
+  if (!discard)
+    diags.insert(diags.end(),
+                 std::make_move_iterator(b.diags.begin()),
+                 std::make_move_iterator(b.diags.end()));
+  b.clear();
+}
+
+
+void
+Diagnostic_buffer::emit()
+{
+  for (Buffered_diagnostic const& d : diags) {
+    switch (d.kind) {
+    case error_diag:
+      error(d.loc, "{}", d.msg);
+      break;
+    case warning_diag:
+      warning(d.loc, "{}", d.msg);
+      break;
+    default:
+      note(d.loc, "{}", d.msg);
+      break;
+    }
+  }
+  clear();
+}
+
+
+void
+Diagnostic_buffer::clear()
+{
+  diags.clear();
+  nerrors = 0;
+}
+
+
+} // namespace banjo
@@ -0,0 +1,76 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_DIAGNOSTICS_HPP
+#define BANJO_DIAGNOSTICS_HPP
+
+// This module provides buffers that collect diagnostics instead of
+// emitting them immediately. Buffers support speculative work (e.g.,
+// overload probing), where diagnostics may be discarded, and parallel
+// work, where diagnostics from independent tasks are committed in a
+// deterministic order.
+
+#include "prelude.hpp"
+
+#include <vector>
+
+
+namespace banjo
+{
+
+// A diagnostic that has been formatted but not yet emitted.
+struct Buffered_diagnostic
+{
+  Diagnostic_kind kind;
+  Location        loc;
+  String          msg;
+};
+
+
+// A buffer of diagnostics. A discarding buffer only counts the
+// diagnostics given to it; their messages are never formatted.
+struct Diagnostic_buffer
+{
+  explicit Diagnostic_buffer(bool d = false)
+    : discard(d), nerrors(0)
+  { }
+
+  template<typename... Args>
+  void put(Diagnostic_kind, Location, char const*, Args const&...);
+
+  // Returns the number of errors given to the buffer.
+  std::size_t errors() const { return nerrors; }
+
+  // Returns true if no diagnostics are buffered.
+  bool empty() const { return diags.empty(); }
+
+  // Append the diagnostics of b to this buffer and clear b.
+  void append(Diagnostic_buffer& b);
+
+  // Emit the buffered diagnostics, in order, and clear the buffer.
+  void emit();
+
+  // Discard the buffered diagnostics.
+  void clear();
+
+  bool                             discard;
+  std::size_t                      nerrors;
+  std::vector<Buffered_diagnostic> diags;
+};
+
+
+template<typename... Args>
+inline void
+Diagnostic_buffer::put(Diagnostic_kind k, Location loc, char const* msg, Args const&... args)
+{
+  if (k == error_diag)
+    ++nerrors;
+  if (!discard)
+    diags.push_back({k, loc, format(msg, args...)});
+}
+
+
+} // namespace banjo
+
+
+#endif
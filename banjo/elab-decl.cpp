@@ -35,6 +35,7 @@ Parser::elaborate_declaration(Stmt& s)
 void
 Parser::elaborate_declaration(Decl& d)
 {
+  Track_uses track(cxt, d);
   struct fn
   {
     Parser& p;
@@ -185,7 +186,7 @@ Parser::elaborate_type(Type& t)
 {
   if (Unparsed_type* soup = as<Unparsed_type>(&t)) {
     Save_input_location loc(cxt);
-    Token_stream ts(soup->tokens());
+    Token_buffer ts(soup->tokens());
     Parser parse(cxt, ts);
     return parse.type();
   }
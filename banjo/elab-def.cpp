@@ -4,9 +4,14 @@
 #include "parser.hpp"
 #include "printer.hpp"
 #include "declaration.hpp"
+#include "evaluation.hpp"
 #include "ast.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <iostream>
+#include <thread>
 
 
 namespace banjo
@@ -18,8 +23,213 @@ namespace banjo
 void
 Parser::elaborate_definitions(Stmt_list& ss)
 {
+  if (cxt.lazy) {
+    for (Stmt& s : ss) {
+      if (is_deferred_definition(s)) {
+        Decl& d = cast<Declaration_stmt>(s).declaration();
+        cxt.deferred.emplace(&d, Deferred{&cxt.current_scope(), Deferred::pending, {}});
+      }
+    }
+  }
+
+  if (cxt.jobs > 1 && &cxt.current_scope() == state.translation) {
+    elaborate_definitions_concurrently(ss);
+    return;
+  }
+  for (Stmt& s : ss) {
+    if (!is_deferred_definition(s))
+      elaborate_definition(s);
+  }
+}
+
+
+// Returns true if s declares a function whose definition is elaborated
+// only when the function is referenced. This is the case for functions
+// named by identifiers in the translation scope in lazy mode, except
+// for main. Operator functions can be used without being referenced
+// by name, so they are always elaborated.
+bool
+Parser::is_deferred_definition(Stmt& s)
+{
+  if (!cxt.lazy || &cxt.current_scope() != state.translation)
+    return false;
+  if (Declaration_stmt* s1 = as<Declaration_stmt>(&s)) {
+    if (Function_decl* f = as<Function_decl>(&s1->declaration())) {
+      Simple_id* id = as<Simple_id>(&f->name());
+      return id && id->symbol().spelling() != "main";
+    }
+  }
+  return false;
+}
+
+
+// Returns true if the thread t is waiting, directly or through other
+// threads, for a definition being elaborated by the thread self.
+static bool
+waits_for(Context& cxt, std::thread::id t, std::thread::id self)
+{
+  while (t != self) {
+    auto iter = cxt.waiting.find(t);
+    if (iter == cxt.waiting.end())
+      return false;
+    t = cxt.deferred.find(iter->second)->second.owner;
+  }
+  return true;
+}
+
+
+// Marks a deferred definition as done when its elaboration completes
+// or fails, and wakes the threads waiting for it.
+struct Finish_deferred
+{
+  Finish_deferred(Context& c, Deferred& d)
+    : cxt(c), def(d)
+  { }
+
+  ~Finish_deferred()
+  {
+    {
+      Context_lock lock(cxt);
+      def.state = Deferred::done;
+    }
+    cxt.elaborated.notify_all();
+  }
+
+  Context&  cxt;
+  Deferred& def;
+};
+
+
+// Elaborate the definition of d if it was deferred. Definitions are
+// elaborated in the scope in which they were deferred, and at most
+// once.
+//
+// If another thread is elaborating the definition, wait until it is
+// done. If d is referenced while its definition is being elaborated by
+// this thread, or by a thread that is waiting for this one (i.e., the
+// functions are recursive), return immediately, as sequential
+// elaboration would.
+void
+require_definition(Context& cxt, Decl& d)
+{
+  std::thread::id self = std::this_thread::get_id();
+  Deferred* def;
+  {
+    std::unique_lock<std::mutex> lock(cxt.sync, std::defer_lock);
+    if (cxt.concurrent)
+      lock.lock();
+    auto iter = cxt.deferred.find(&d);
+    if (iter == cxt.deferred.end())
+      return;
+    def = &iter->second;
+    while (def->state == Deferred::active) {
+      if (!cxt.concurrent || waits_for(cxt, def->owner, self))
+        return;
+      cxt.waiting[self] = &d;
+      cxt.elaborated.wait(lock);
+      cxt.waiting.erase(self);
+    }
+    if (def->state == Deferred::done)
+      return;
+    def->state = Deferred::active;
+    def->owner = self;
+  }
+
+  Finish_deferred finish(cxt, *def);
+  Save_input_location loc(cxt);
+  Enter_scope scope(cxt, *def->scope);
+  Token_buffer none;
+  Parser p(cxt, none);
+  p.elaborate_definition(d);
+}
+
+
+// Returns the function or coroutine declared by s, if any. The
+// bodies of these declarations can be elaborated independently of
+// each other.
+static Decl*
+get_independent_definition(Stmt& s)
+{
+  if (Declaration_stmt* s1 = as<Declaration_stmt>(&s)) {
+    Decl& d = s1->declaration();
+    if (is<Function_decl>(&d) || is<Coroutine_decl>(&d))
+      return &d;
+  }
+  return nullptr;
+}
+
+
+// Elaborate the definitions of a translation unit using worker
+// threads. All other definitions (e.g., classes and variables) are
+// elaborated first, in order, so that function bodies can refer to
+// them. Each function and coroutine body is then elaborated on a
+// worker thread, starting in the translation scope, with its own
+// scope stack and arena.
+//
+// Diagnostics and errors are collected per definition. Once all
+// workers have finished, diagnostics are committed in source order
+// up to the first failing definition, whose error is rethrown, as
+// it would have been by sequential elaboration.
+void
+Parser::elaborate_definitions_concurrently(Stmt_list& ss)
+{
+  std::vector<Decl*> defs;
   for (Stmt& s : ss) {
-    elaborate_definition(s);
+    if (is_deferred_definition(s))
+      continue;
+    if (Decl* d = get_independent_definition(s))
+      defs.push_back(d);
+    else
+      elaborate_definition(s);
+  }
+
+  std::size_t n = std::min<std::size_t>(cxt.jobs, defs.size());
+  for (std::size_t i = 0; i < n; ++i)
+    cxt.arenas.emplace_back(new Arena());
+
+  std::vector<std::exception_ptr> errs(defs.size());
+  std::vector<Diagnostic_buffer> diags(defs.size());
+  std::atomic<std::size_t> next(0);
+  Local_state init = cxt.local();
+  auto work = [&](Arena& arena) {
+    Local_state local = init;
+    Enter_worker worker(local, arena);
+
+    // Unparsed definitions are parsed by new parsers, so a worker
+    // does not need any tokens of its own.
+    Token_buffer none;
+    Parser p(cxt, none);
+    for (std::size_t i = next++; i < defs.size(); i = next++) {
+      Buffer_diagnostics buffer(cxt, diags[i]);
+      try {
+        p.elaborate_definition(*defs[i]);
+      } catch (...) {
+        errs[i] = std::current_exception();
+      }
+    }
+  };
+
+  // The calling thread is the first worker.
+  std::size_t base = cxt.arenas.size() - n;
+  cxt.concurrent = true;
+  std::vector<std::thread> pool;
+  for (std::size_t i = 1; i < n; ++i)
+    pool.emplace_back(work, std::ref(*cxt.arenas[base + i]));
+  if (n != 0)
+    work(*cxt.arenas[base]);
+  for (std::thread& t : pool)
+    t.join();
+  cxt.concurrent = false;
+
+  // Commit diagnostics in source order, stopping at the first
+  // definition that failed.
+  for (std::size_t i = 0; i < defs.size(); ++i) {
+    if (init.diags)
+      init.diags->append(diags[i]);
+    else
+      diags[i].emit();
+    if (errs[i])
+      std::rethrow_exception(errs[i]);
   }
 }
 
@@ -35,6 +245,7 @@ Parser::elaborate_definition(Stmt& s)
 void
 Parser::elaborate_definition(Decl& d)
 {
+  Track_uses track(cxt, d);
   struct fn
   {
     Parser& p;
@@ -128,6 +339,9 @@ Parser::elaborate_function_definition(Function_decl& decl, Expression_def& def)
   Stmt& ret = cxt.make_return_statement(expr);
   Stmt& body = cxt.make_compound_statement({&ret});
   decl.def_ = &cxt.make_function_definition(body);
+
+  // Assign frame slots to the parameters.
+  allocate_frame(decl);
 }
 
 
@@ -148,6 +362,9 @@ Parser::elaborate_function_definition(Function_decl& decl, Function_def& def)
   // Update the definition with the new statement. We don't need
   // to update the declaration.
   def.stmt_ = &stmt;
+
+  // Assign frame slots to the parameters and local variables.
+  allocate_frame(decl);
 }
 
 
@@ -191,7 +408,7 @@ Parser::elaborate_expression(Expr& e)
 {
   if (Unparsed_expr* soup = as<Unparsed_expr>(&e)) {
     Save_input_location loc(cxt);
-    Token_stream ts(soup->tokens());
+    Token_buffer ts(soup->tokens());
     Parser parse(cxt, ts);
     return parse.expression();
   }
@@ -204,7 +421,7 @@ Parser::elaborate_compound_statement(Stmt& s)
 {
   if (Unparsed_stmt* soup = as<Unparsed_stmt>(&s)) {
     Save_input_location loc(cxt);
-    Token_stream ts(soup->tokens());
+    Token_buffer ts(soup->tokens());
     Parser parse(cxt, ts);
     return parse.compound_statement();
   }
@@ -217,7 +434,7 @@ Parser::elaborate_member_statement(Stmt& s)
 {
   if (Unparsed_stmt* soup = as<Unparsed_stmt>(&s)) {
     Save_input_location loc(cxt);
-    Token_stream ts(soup->tokens());
+    Token_buffer ts(soup->tokens());
     Parser parse(cxt, ts);
     return parse.member_statement();
   }
@@ -13,6 +13,9 @@
 namespace banjo
 {
 
+thread_local bool discarding_diagnostics = false;
+
+
 Location
 Compiler_error::location(Context const& cxt)
 {
@@ -9,6 +9,24 @@
 namespace banjo
 {
 
+// True if diagnostics on the current thread are being discarded (see
+// Suppress_diagnostics). When set, the messages of compiler errors
+// are not formatted.
+extern thread_local bool discarding_diagnostics;
+
+
+// Returns the formatted message, or the unformatted message if
+// diagnostics are being discarded.
+template<typename... Args>
+inline String
+format_message(char const* s, Args const&... args)
+{
+  if (discarding_diagnostics)
+    return s;
+  return format(s, args...);
+}
+
+
 // The compiler-error class represents a runtime error that contains
 // a compiler diagnostic. This overrides the what() function to provide
 // a textual represntation of that diagnostic.
@@ -47,12 +65,12 @@ struct Compiler_error : std::runtime_error
 
   template<typename... Args>
   Compiler_error(char const* s, Args const&... args)
-    : Compiler_error(error_diag, format(s, args...))
+    : Compiler_error(error_diag, format_message(s, args...))
   { }
 
   template<typename... Args>
   Compiler_error(Location loc, char const* s, Args const&... args)
-    : Compiler_error(error_diag, loc, format(s, args...))
+    : Compiler_error(error_diag, loc, format_message(s, args...))
   { }
 
   template<typename... Args>
@@ -62,7 +80,7 @@ struct Compiler_error : std::runtime_error
 
   template<typename... Args>
   Compiler_error(Context& cxt, char const* s, Args const&... args)
-    : Compiler_error(error_diag, location(cxt), format(s, args...))
+    : Compiler_error(error_diag, location(cxt), format_message(s, args...))
   { }
 
   virtual const char* what() const noexcept;
@@ -3,7 +3,9 @@
 
 #include "evaluation.hpp"
 #include "ast.hpp"
+#include "budget.hpp"
 #include "builder.hpp"
+#include "bytecode.hpp"
 #include "printer.hpp"
 
 #include <iostream>
@@ -12,6 +14,62 @@
 namespace banjo
 {
 
+// -------------------------------------------------------------------------- //
+// Frames
+
+constexpr std::size_t Frame_stack::block_size;
+
+
+// Allocate a frame of n values. The frame is placed in the current
+// block if it fits, and in the next block otherwise.
+Value*
+Frame_stack::push(std::size_t n)
+{
+  std::size_t b = marks.empty() ? 0 : marks.back().block;
+  if (b < blocks.size() && blocks[b].size - blocks[b].used < n)
+    ++b;
+  if (b == blocks.size())
+    blocks.push_back({nullptr, 0, 0});
+  Block& blk = blocks[b];
+  if (blk.size < n) {
+    // Blocks above the current frame are unused, so a block that is
+    // too small can be replaced.
+    blk.size = std::max(n, block_size);
+    blk.data.reset(new Value[blk.size]);
+  }
+  marks.push_back({b, blk.used});
+  Value* p = blk.data.get() + blk.used;
+  blk.used += n;
+  return p;
+}
+
+
+// Release the most recently allocated frame. Its values are reset,
+// which frees the storage of any aggregates, and leaves the slots
+// ready for the next frame.
+void
+Frame_stack::pop()
+{
+  Mark m = marks.back();
+  marks.pop_back();
+  Block& blk = blocks[m.block];
+  std::fill(blk.data.get() + m.used, blk.data.get() + blk.used, Value());
+  blk.used = m.used;
+}
+
+
+// Returns the slot of a parameter or local variable in the current
+// frame.
+Value&
+Evaluator::slot(Decl const& d)
+{
+  Object_decl const& var = cast<Object_decl>(d);
+  if (!frame || var.slot() < 0)
+    throw Evaluation_error("cannot evaluate a reference to '{}'", var.name());
+  return frame[var.slot()];
+}
+
+
 // Returns a reference to the object or function corresponding
 // do the declaration `d`.
 //
@@ -22,8 +80,8 @@ Evaluator::alias(Decl const& d)
 {
   // If the expression refers to an object, then produce
   // a reference to its stored value.
-  if (Object_decl const* var = as<Object_decl>(&d))
-    return &stack.lookup(var)->second;
+  if (is<Object_decl>(&d))
+    return &slot(d);
 
   // If the expression refers to a function, then produce
   // a reference to that function.
@@ -42,8 +100,8 @@ Evaluator::load(Decl const& d)
 {
   // If the expression refers to an object, then produce
   // a reference to its stored value.
-  if (Object_decl const* var = as<Object_decl>(&d))
-    return stack.lookup(var)->second;
+  if (is<Object_decl>(&d))
+    return slot(d);
 
   // What else?
   banjo_unhandled_case(d);
@@ -51,15 +109,12 @@ Evaluator::load(Decl const& d)
 
 
 // Stores a value in the object corresponding to the given
-// declaration. This copies the value into the object, and
+// declaration. This moves the value into the object, and
 // returns a reference to that value.
-//
-// FIXME: We should not be able to store values in objects that
-// have not been allocated.
 Value&
-Evaluator::store(Decl const& d, Value const& v)
+Evaluator::store(Decl const& d, Value v)
 {
-  return stack.top().rebind(&d, v).second;
+  return slot(d) = std::move(v);
 }
 
 
@@ -67,10 +122,7 @@ Evaluator::store(Decl const& d, Value const& v)
 // procedure is invoked.
 //
 // This currently works by prototyping an object of the approppriate
-// shape and storing that for the declaration.
-//
-// TODO: It would be better if we could just emplace the approiately
-// shaped object directly into the store.
+// shape and storing that in the object's slot.
 Value&
 Evaluator::alloca(Decl const& d)
 {
@@ -90,6 +142,35 @@ Evaluator::alloca(Decl const& d)
 // -------------------------------------------------------------------------- //
 // Evaluation of expressions
 
+namespace
+{
+
+// Integer operations (see evaluation.hpp).
+
+Integer_value add(Integer_value a, Integer_value b) { return wrap(std::uint64_t(a) + b); }
+Integer_value sub(Integer_value a, Integer_value b) { return wrap(std::uint64_t(a) - b); }
+Integer_value mul(Integer_value a, Integer_value b) { return wrap(std::uint64_t(a) * b); }
+Integer_value neg(Integer_value a)                  { return wrap(-std::uint64_t(a)); }
+Integer_value pos(Integer_value a)                  { return a; }
+
+Integer_value bit_and(Integer_value a, Integer_value b) { return a & b; }
+Integer_value bit_or(Integer_value a, Integer_value b)  { return a | b; }
+Integer_value bit_xor(Integer_value a, Integer_value b) { return a ^ b; }
+Integer_value bit_lsh(Integer_value a, Integer_value b) { return wrap(std::uint64_t(a) << shift_count(b)); }
+Integer_value bit_rsh(Integer_value a, Integer_value b) { return a >> shift_count(b); }
+Integer_value bit_not(Integer_value a)                  { return ~a; }
+
+Integer_value eq(Integer_value a, Integer_value b)  { return a == b; }
+Integer_value ne(Integer_value a, Integer_value b)  { return a != b; }
+Integer_value lt(Integer_value a, Integer_value b)  { return a < b; }
+Integer_value gt(Integer_value a, Integer_value b)  { return a > b; }
+Integer_value le(Integer_value a, Integer_value b)  { return a <= b; }
+Integer_value ge(Integer_value a, Integer_value b)  { return a >= b; }
+Integer_value cmp(Integer_value a, Integer_value b) { return (a > b) - (a < b); }
+
+} // namespace
+
+
 Value
 Evaluator::evaluate(Expr const& e)
 {
@@ -101,10 +182,39 @@ Evaluator::evaluate(Expr const& e)
     Value operator()(Integer_expr const& e) { return self.evaluate_integer(e); }
     Value operator()(Decl_expr const& e)    { return self.evaluate_reference(e); }
     Value operator()(Call_expr const& e)    { return self.evaluate_call(e); }
+    Value operator()(Add_expr const& e)     { return self.evaluate_binary(e, add); }
+    Value operator()(Sub_expr const& e)     { return self.evaluate_binary(e, sub); }
+    Value operator()(Mul_expr const& e)     { return self.evaluate_binary(e, mul); }
+    Value operator()(Div_expr const& e)     { return self.evaluate_binary(e, divide); }
+    Value operator()(Rem_expr const& e)     { return self.evaluate_binary(e, remainder); }
+    Value operator()(Neg_expr const& e)     { return self.evaluate_unary(e, neg); }
+    Value operator()(Pos_expr const& e)     { return self.evaluate_unary(e, pos); }
+    Value operator()(Bit_and_expr const& e) { return self.evaluate_binary(e, bit_and); }
+    Value operator()(Bit_or_expr const& e)  { return self.evaluate_binary(e, bit_or); }
+    Value operator()(Bit_xor_expr const& e) { return self.evaluate_binary(e, bit_xor); }
+    Value operator()(Bit_lsh_expr const& e) { return self.evaluate_binary(e, bit_lsh); }
+    Value operator()(Bit_rsh_expr const& e) { return self.evaluate_binary(e, bit_rsh); }
+    Value operator()(Bit_not_expr const& e) { return self.evaluate_unary(e, bit_not); }
+    Value operator()(Eq_expr const& e)      { return self.evaluate_binary(e, eq); }
+    Value operator()(Ne_expr const& e)      { return self.evaluate_binary(e, ne); }
+    Value operator()(Lt_expr const& e)      { return self.evaluate_binary(e, lt); }
+    Value operator()(Gt_expr const& e)      { return self.evaluate_binary(e, gt); }
+    Value operator()(Le_expr const& e)      { return self.evaluate_binary(e, le); }
+    Value operator()(Ge_expr const& e)      { return self.evaluate_binary(e, ge); }
+    Value operator()(Cmp_expr const& e)     { return self.evaluate_binary(e, cmp); }
     Value operator()(And_expr const& e)     { return self.evaluate_and(e); }
     Value operator()(Or_expr const& e)      { return self.evaluate_or(e); }
     Value operator()(Not_expr const& e)     { return self.evaluate_not(e); }
+    Value operator()(Assign_expr const& e)  { return self.evaluate_assign(e); }
+    Value operator()(Value_conv const& e)   { return self.evaluate_value(e); }
+    Value operator()(Qualification_conv const& e) { return self.evaluate(e.source()); }
+    Value operator()(Integer_conv const& e) { return self.evaluate_integer_conv(e); }
+    Value operator()(Boolean_conv const& e) { return self.evaluate_boolean_conv(e); }
+    Value operator()(Trivial_init const& e) { return 0; }
+    Value operator()(Copy_init const& e)    { return self.evaluate(e.expression()); }
   };
+  if (budget)
+    budget->step();
   return apply(e, fn{*this});
 }
 
@@ -153,8 +263,10 @@ Evaluator::evaluate_call(Call_expr const& e)
     lingo_unreachable();
 
   // Each parameter is declared as a local variable within the
-  // function.
-  Enter_frame frame(*this);
+  // function. Arguments are evaluated in the caller's frame.
+  int n = f.frame_size();
+  lingo_assert(n >= 0);
+  Enter_frame frame(*this, n);
   Expr_list const& args = e.arguments();
   Decl_list const& parms = f.parameters();
   auto ai = args.begin();
@@ -166,8 +278,12 @@ Evaluator::evaluate_call(Call_expr const& e)
     // TODO: Parameters are copy-initialized. Reuse initialization
     // here, insted of this kind of direct storage. Use alloca
     // and then dispatch to the initializer.
-    store(parm, evaluate(arg));
+    frame.frame[cast<Object_decl>(parm).slot()] = evaluate(arg);
+    ++ai;
+    ++pi;
   }
+  Enter_call call(budget, f, n * sizeof(Value));
+  frame.enter();
 
   // Evaluate the function definition.
   //
@@ -183,6 +299,17 @@ Evaluator::evaluate_call(Call_expr const& e)
 }
 
 
+// Load the value of an object.
+Value
+Evaluator::evaluate_value(Value_conv const& e)
+{
+  Value v = evaluate(e.source());
+  if (v.is_reference())
+    return *v.get_reference();
+  return v;
+}
+
+
 Value
 Evaluator::evaluate_and(And_expr const& e)
 {
@@ -213,6 +340,67 @@ Evaluator::evaluate_not(Not_expr const& e)
 }
 
 
+Value
+Evaluator::evaluate_unary(Unary_expr const& e, Integer_value (*op)(Integer_value))
+{
+  Value v = evaluate(e.operand());
+  return fit(e.type(), op(v.get_integer()));
+}
+
+
+// The left operand is evaluated before the right.
+Value
+Evaluator::evaluate_binary(Binary_expr const& e, Integer_value (*op)(Integer_value, Integer_value))
+{
+  Value a = evaluate(e.left());
+  Value b = evaluate(e.right());
+  return fit(e.type(), op(a.get_integer(), b.get_integer()));
+}
+
+
+// Store the value of the right operand in the object referred to
+// by the left, and return that value.
+Value
+Evaluator::evaluate_assign(Assign_expr const& e)
+{
+  Value r = evaluate(e.left());
+  Value v = evaluate(e.right());
+  *r.get_reference() = v;
+  return v;
+}
+
+
+Value
+Evaluator::evaluate_integer_conv(Integer_conv const& e)
+{
+  Value v = evaluate(e.source());
+  return fit(e.type(), v.get_integer());
+}
+
+
+Value
+Evaluator::evaluate_boolean_conv(Boolean_conv const& e)
+{
+  Value v = evaluate(e.source());
+  return int(v.get_integer() != 0);
+}
+
+
+// Truncate n to the precision of an integer type t narrower than 64
+// bits, and sign extend it if t is signed.
+Value
+Evaluator::fit(Type const& t, Integer_value n)
+{
+  Integer_type const* z = as<Integer_type>(&t);
+  if (!z || z->precision() >= 64)
+    return n;
+  if (z->is_signed())
+    return sign_extend(n, z->precision());
+  else
+    return zero_extend(n, z->precision());
+}
+
+
 // -------------------------------------------------------------------------- //
 // Evaluation of statements
 
@@ -229,19 +417,28 @@ Evaluator::evaluate(Stmt const& s, Value& r)
     Value&     r;
 
     Control operator()(Stmt const& s)             { lingo_unhandled(s); }
+    Control operator()(Empty_stmt const& s)       { return next_ctl; }
     Control operator()(Compound_stmt const& s)    { return self.evaluate_block(s, r); }
     Control operator()(Declaration_stmt const& s) { return self.evaluate_declaration(s, r); }
     Control operator()(Expression_stmt const& s)  { return self.evaluate_expression(s, r); }
     Control operator()(Return_stmt const& s)      { return self.evaluate_return(s, r); }
+    Control operator()(If_then_stmt const& s)     { return self.evaluate_if(s, r); }
+    Control operator()(If_else_stmt const& s)     { return self.evaluate_if(s, r); }
+    Control operator()(While_stmt const& s)       { return self.evaluate_while(s, r); }
+    Control operator()(Break_stmt const& s)       { return break_ctl; }
+    Control operator()(Continue_stmt const& s)    { return continue_ctl; }
   };
+  if (budget)
+    budget->step();
   return apply(s, fn{*this, r});
 }
 
 
+// Local variables are stored in the function's frame, so a block
+// does not need a frame of its own.
 Control
 Evaluator::evaluate_block(Compound_stmt const& s, Value& r)
 {
-  Enter_frame frame(*this);
   for (Stmt const& s1 : s.statements()) {
     Control ctl = evaluate(s1, r);
     switch (ctl) {
@@ -281,6 +478,43 @@ Evaluator::evaluate_return(Return_stmt const& s, Value& r)
 }
 
 
+Control
+Evaluator::evaluate_if(If_then_stmt const& s, Value& r)
+{
+  Value c = evaluate(s.condition());
+  if (c.get_integer())
+    return evaluate(s.true_branch(), r);
+  return next_ctl;
+}
+
+
+Control
+Evaluator::evaluate_if(If_else_stmt const& s, Value& r)
+{
+  Value c = evaluate(s.condition());
+  if (c.get_integer())
+    return evaluate(s.true_branch(), r);
+  else
+    return evaluate(s.false_branch(), r);
+}
+
+
+// A break leaves the loop, and a continue proceeds to the next test
+// of the condition.
+Control
+Evaluator::evaluate_while(While_stmt const& s, Value& r)
+{
+  while (evaluate(s.condition()).get_integer()) {
+    Control ctl = evaluate(s.body(), r);
+    if (ctl == break_ctl)
+      break;
+    if (ctl == return_ctl)
+      return ctl;
+  }
+  return next_ctl;
+}
+
+
 // -------------------------------------------------------------------------- //
 // Evaluation of declarations
 
@@ -297,20 +531,26 @@ Evaluator::elaborate(Decl const& d)
 }
 
 
+// Allocate the object and evaluate its initializer, if any.
+//
+// FIXME: Implement initialization for other kinds of definitions.
 void
 Evaluator::elaborate_object(Object_decl const& d)
 {
-  // FIXME: Implement initialization!
   Value& v = alloca(d);
-  (void)v;
-  lingo_unreachable();
+  if (Variable_decl const* var = as<Variable_decl>(&d)) {
+    if (Expression_def const* def = as<Expression_def>(&var->initializer()))
+      v = evaluate(def->expression());
+  }
 }
 
 
 // -------------------------------------------------------------------------- //
 // Reduction
 
-
+// Reduce e to a literal. The expression is evaluated by the virtual
+// machine when it can be compiled (see bytecode.hpp), and by the
+// evaluator otherwise.
 Expr&
 reduce(Context& cxt, Expr& e)
 {
@@ -337,7 +577,7 @@ reduce(Context& cxt, Expr& e)
     Expr& operator()(Tuple_value const& v)     { lingo_unreachable(); }
 
   };
-  return apply(evaluate(e), fn{cxt, e.type()});
+  return apply(evaluate(cxt, e), fn{cxt, e.type()});
 }
 
 
@@ -348,4 +588,77 @@ reduce(Context& cxt, Expr const& e)
 }
 
 
+// -------------------------------------------------------------------------- //
+// Frame allocation
+
+namespace
+{
+
+// Assigns slots to the local variables of a function body. Variables
+// in sibling blocks share slots.
+struct Frame_allocator
+{
+  Frame_allocator()
+    : next(0), size(0)
+  { }
+
+  void declare(Object_decl& d)
+  {
+    d.slot_ = next++;
+    size = std::max(size, next);
+  }
+
+  void statement(Stmt& s)
+  {
+    struct fn
+    {
+      Frame_allocator& self;
+      void operator()(Stmt& s)             { }
+      void operator()(Compound_stmt& s)    { self.block(s); }
+      void operator()(Declaration_stmt& s) { self.declaration(s.declaration()); }
+      void operator()(If_then_stmt& s)     { self.statement(s.true_branch()); }
+      void operator()(If_else_stmt& s)     { self.statement(s.true_branch()); self.statement(s.false_branch()); }
+      void operator()(While_stmt& s)       { self.statement(s.body()); }
+    };
+    apply(s, fn{*this});
+  }
+
+  void block(Compound_stmt& s)
+  {
+    int n = next;
+    for (Stmt& s1 : s.statements())
+      statement(s1);
+    next = n;
+  }
+
+  void declaration(Decl& d)
+  {
+    if (Object_decl* var = as<Object_decl>(&d))
+      declare(*var);
+  }
+
+  int next; // The next free slot
+  int size; // The number of slots used
+};
+
+
+} // namespace
+
+
+// Assign frame slots to the parameters and local variables of f, and
+// returns the size of the frame. This is done when the definition of
+// f is elaborated or read from a saved translation.
+int
+allocate_frame(Function_decl& f)
+{
+  Frame_allocator alloc;
+  for (Decl& p : f.parameters())
+    alloc.declaration(p);
+  if (Function_def* def = as<Function_def>(&f.definition()))
+    alloc.statement(def->statement());
+  f.frame_ = alloc.size;
+  return alloc.size;
+}
+
+
 } // namespace banjo
@@ -9,27 +9,43 @@
 #include "context.hpp"
 #include "value.hpp"
 
-#include <lingo/environment.hpp>
+#include <memory>
+#include <vector>
 
 
 namespace banjo
 {
 
-// TODO: Specialize the store and call stack to use load and store
-// instead of lookup and bind. That's a bit more conventional for
-// the kinds of operations here.
+// The frames of active calls. Each frame is a contiguous array of
+// values indexed by the slots of parameters and local variables (see
+// allocate_frame). Frames are allocated from large blocks that never
+// move, so references to local objects remain valid while their frame
+// is live.
+struct Frame_stack
+{
+  static constexpr std::size_t block_size = 4096;
 
+  Value* push(std::size_t);
+  void   pop();
 
-// Dynamic binding of declarations to their values.
-using Store = Environment<Decl const*, Value>;
+  // A block of frames.
+  struct Block
+  {
+    std::unique_ptr<Value[]> data;
+    std::size_t              size;
+    std::size_t              used;
+  };
 
+  // The position of a frame.
+  struct Mark
+  {
+    std::size_t block;
+    std::size_t used;
+  };
 
-// The store stack maintains the dynamic binding between symbols
-// and their values. Each time a new binding environment is entered
-// (e.g., a block scope), a new frame is created to store bindings.
-//
-// This is also the call stack.
-using Call_stack = Stack<Store>;
+  std::vector<Block> blocks;
+  std::vector<Mark>  marks;
+};
 
 
 // Represents the evaluation of a statement. This determines the
@@ -50,6 +66,10 @@ enum Control
 struct Evaluator
 {
 public:
+  Evaluator(Evaluation_budget* b = nullptr)
+    : budget(b), frame(nullptr)
+  { }
+
   Value operator()(Expr const& e) { return evaluate(e); }
 
   Value evaluate(Expr const&);
@@ -60,12 +80,22 @@ public:
   Value evaluate_and(And_expr const&);
   Value evaluate_or(Or_expr const&);
   Value evaluate_not(Not_expr const&);
+  Value evaluate_value(Value_conv const&);
+  Value evaluate_unary(Unary_expr const&, Integer_value (*)(Integer_value));
+  Value evaluate_binary(Binary_expr const&, Integer_value (*)(Integer_value, Integer_value));
+  Value evaluate_assign(Assign_expr const&);
+  Value evaluate_integer_conv(Integer_conv const&);
+  Value evaluate_boolean_conv(Boolean_conv const&);
+  Value fit(Type const&, Integer_value);
 
   Control evaluate(Stmt const&, Value&);
   Control evaluate_block(Compound_stmt const&, Value&);
   Control evaluate_declaration(Declaration_stmt const&, Value&);
   Control evaluate_expression(Expression_stmt const&, Value&);
   Control evaluate_return(Return_stmt const&, Value&);
+  Control evaluate_if(If_then_stmt const&, Value&);
+  Control evaluate_if(If_else_stmt const&, Value&);
+  Control evaluate_while(While_stmt const&, Value&);
 
   void elaborate(Decl const&);
   void elaborate_object(Object_decl const&);
@@ -73,33 +103,106 @@ public:
   // Memory management
   Value  alias(Decl const&);
   Value  load(Decl const&);
-  Value& store(Decl const&, Value const&);
+  Value& store(Decl const&, Value);
   Value& alloca(Decl const&);
+  Value& slot(Decl const&);
 
   struct Enter_frame;
 
-  Call_stack stack;
+  Evaluation_budget* budget; // Limits on the evaluation, if any
+  Frame_stack        stack;  // Frames of active calls
+  Value*             frame;  // The current frame
 };
 
 
-// A helper class for managing stack frames.
+// A helper class for managing stack frames. The frame is allocated
+// when the object is constructed, but does not become the current
+// frame until it is entered. This allows arguments to be evaluated
+// in the caller's frame and stored directly in the callee's.
 struct Evaluator::Enter_frame
 {
-  Enter_frame(Evaluator& e)
-    : eval(e)
-  {
-    eval.stack.push();
-  }
+  Enter_frame(Evaluator& e, std::size_t n)
+    : eval(e), prev(e.frame), frame(e.stack.push(n))
+  { }
 
   ~Enter_frame()
   {
+    eval.frame = prev;
     eval.stack.pop();
   }
 
+  void enter() { eval.frame = frame; }
+
   Evaluator& eval;
+  Value*     prev;
+  Value*     frame;
 };
 
 
+// -------------------------------------------------------------------------- //
+// Integer arithmetic
+//
+// Integers are computed in 64 bits, and arithmetic wraps on overflow.
+// Results of narrower types are then truncated to their precision. The
+// evaluator and the virtual machine share these operations so that
+// they compute the same results.
+
+inline Integer_value
+wrap(std::uint64_t n)
+{
+  return Integer_value(n);
+}
+
+
+inline Integer_value
+divide(Integer_value a, Integer_value b)
+{
+  if (b == 0)
+    throw Evaluation_error("division by zero");
+  if (b == -1)
+    return wrap(-std::uint64_t(a));
+  return a / b;
+}
+
+
+inline Integer_value
+remainder(Integer_value a, Integer_value b)
+{
+  if (b == 0)
+    throw Evaluation_error("division by zero");
+  if (b == -1)
+    return 0;
+  return a % b;
+}
+
+
+// Returns the low p bits of n, sign extended.
+inline Integer_value
+sign_extend(Integer_value n, int p)
+{
+  int s = 64 - p;
+  return Integer_value(std::uint64_t(n) << s) >> s;
+}
+
+
+// Returns the low p bits of n.
+inline Integer_value
+zero_extend(Integer_value n, int p)
+{
+  return std::uint64_t(n) & ((std::uint64_t(1) << p) - 1);
+}
+
+
+// Returns n as a shift count.
+inline int
+shift_count(Integer_value n)
+{
+  if (n < 0 || n >= 64)
+    throw Evaluation_error("shift count '{}' is out of range", n);
+  return n;
+}
+
+
 // -------------------------------------------------------------------------- //
 // Expression evaluation
 
@@ -116,6 +219,12 @@ Expr const& reduce(Context&, Expr const&);
 Expr&       reduce(Context&, Expr&);
 
 
+// -------------------------------------------------------------------------- //
+// Frames
+
+int allocate_frame(Function_decl&);
+
+
 } // namespace banjo
 
 
@@ -6,6 +6,8 @@
 #include "template.hpp"
 #include "context.hpp"
 #include "lookup.hpp"
+#include "declaration.hpp"
+#include "incremental.hpp"
 #include "printer.hpp"
 
 #include <iostream>
@@ -22,6 +24,8 @@ namespace banjo
 Expr&
 make_reference(Context& cxt, Decl& d)
 {
+  note_use(cxt, d);
+
   // TODO: What other kinds of objects do we have here...
   //
   // TODO: Dispatch.
@@ -29,8 +33,10 @@ make_reference(Context& cxt, Decl& d)
     return cxt.make_reference(*v);
   if (Object_parm* p = as<Object_parm>(&d))
     return cxt.make_reference(*p);
-  if (Function_decl* f = as<Function_decl>(&d))
+  if (Function_decl* f = as<Function_decl>(&d)) {
+    require_definition(cxt, *f);
     return cxt.make_reference(*f);
+  }
 
   // If it's a template name, then it must almost certainly
   // refer to a function template.
@@ -58,7 +64,7 @@ make_reference(Context& cxt, Decl& d)
 Expr&
 make_reference(Context& cxt, Simple_id& id)
 {
-  Decl_list decls = unqualified_lookup(cxt, id);
+  Overload_view decls = unqualified_lookup(cxt, id);
   if (decls.size() == 1)
     return make_reference(cxt, decls.front());
 
@@ -159,7 +165,7 @@ Expr&
 make_member_reference(Context& cxt, Expr& obj, Simple_id& name)
 {
   Type& type = obj.type();
-  Decl_list decls = qualified_lookup(cxt, type, name);
+  Overload_view decls = qualified_lookup(cxt, type, name);
   if (decls.size() == 1)
     return make_member_reference(cxt, obj, decls.front());
   lingo_unreachable();
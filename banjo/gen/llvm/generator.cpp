@@ -6,6 +6,7 @@
 #include <banjo/ast.hpp>
 #include <banjo/printer.hpp>
 #include <banjo/evaluation.hpp>
+#include <banjo/bytecode.hpp>
 
 #include <llvm/IR/Type.h>
 #include <llvm/IR/GlobalVariable.h>
@@ -114,7 +115,7 @@ llvm::Type*
 Generator::get_type(Array_type const& t) 
 {
   llvm::Type* t1 = get_type(t.type());
-  Value v = evaluate(t.extent());
+  Value v = evaluate(tcxt, t.extent());
   return llvm::ArrayType::get(t1, v.get_integer());
 }
 
@@ -124,7 +125,7 @@ llvm::Type*
 Generator::get_type(Dynarray_type const& t) 
 {
   llvm::Type* t1 = get_type(t.type());
-  Value v = evaluate(t.extent());
+  Value v = evaluate(tcxt, t.extent());
   return llvm::ArrayType::get(t1, v.get_integer());
 }
 
@@ -243,7 +244,7 @@ Generator::gen(Literal_expr const* e)
   // TODO: Write better type queries.
   //
   // TODO: Write a better interface for values.
-  Value v = evaluate(e);
+  Value v = evaluate(tcxt, *e);
   Type const* t = e->type();
   if (t == get_boolean_type())
     return build.getInt1(v.get_integer());
@@ -1010,6 +1011,19 @@ Generator::gen(Variable_decl const& d)
 
 
 
+// Returns true if the definition of d has not been elaborated.
+static bool
+has_unparsed_definition(Function_decl const& d)
+{
+  Def const& def = d.definition();
+  if (Function_def const* f = as<Function_def>(&def))
+    return is<Unparsed_stmt>(&f->statement());
+  if (Expression_def const* e = as<Expression_def>(&def))
+    return is<Unparsed_expr>(&e->expression());
+  return false;
+}
+
+
 void
 Generator::gen(Function_decl const& d)
 {
@@ -1027,6 +1041,10 @@ Generator::gen(Function_decl const& d)
   // Create a new binding for the variable.
   declare(d, fn);
 
+  // A function whose definition was deferred and never referenced
+  // (see -lazy) is emitted as a declaration.
+  if (has_unparsed_definition(d))
+    return;
 
   // Establish a new environment for declarations within this 
   // function's scope.
@@ -8,6 +8,7 @@
 
 #include <banjo/language.hpp>
 #include <banjo/ast.hpp>
+#include <banjo/context.hpp>
 
 #include <lingo/environment.hpp>
 
@@ -48,7 +49,7 @@ using Type_env = Environment<Decl const*, llvm::Type*>;
 
 struct Generator
 {
-  Generator();
+  Generator(Context&);
 
   llvm::Module* operator()(Stmt const&);
 
@@ -117,6 +118,10 @@ struct Generator
   void declare(Decl const&, llvm::Value*);
   llvm::Value* lookup(Decl const&);
 
+  // The translation context, which provides the limits and caches
+  // used for compile-time evaluation.
+  Context& tcxt;
+
   // The context and default IR builder.
   llvm::LLVMContext cxt;
   llvm::IRBuilder<> build;
@@ -143,8 +148,8 @@ struct Generator
 
 
 inline
-Generator::Generator()
-  : cxt(), build(cxt), mod(nullptr), declcxt(invalid_cxt)
+Generator::Generator(Context& c)
+  : tcxt(c), cxt(), build(cxt), mod(nullptr), declcxt(invalid_cxt)
 { }
 
 
@@ -0,0 +1,232 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "incremental.hpp"
+#include "ast.hpp"
+#include "context.hpp"
+#include "printer.hpp"
+#include "source.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+
+namespace banjo
+{
+
+// -------------------------------------------------------------------------- //
+// Cache files
+//
+// A cache file starts with a version line. Each following line holds
+// the fingerprint of one declaration as tab-separated fields: the key,
+// the token hash, the interface hash, and the keys of the declarations
+// it uses.
+
+static char const* cache_version = "banjo-cache 1";
+
+
+// Load the cache from the given file. Returns false if the file does
+// not exist or is not a cache file of this version.
+bool
+Decl_cache::load(String const& path)
+{
+  std::ifstream is(path);
+  String line;
+  if (!std::getline(is, line) || line != cache_version)
+    return false;
+
+  decls.clear();
+  while (std::getline(is, line)) {
+    std::stringstream ss(line);
+    Decl_fingerprint fp;
+    String field;
+    std::getline(ss, fp.key, '\t');
+    std::getline(ss, field, '\t');
+    fp.tokens = std::stoull(field);
+    std::getline(ss, field, '\t');
+    fp.interface = std::stoull(field);
+    while (std::getline(ss, field, '\t'))
+      fp.uses.push_back(field);
+    decls.emplace(fp.key, std::move(fp));
+  }
+  return true;
+}
+
+
+// Save the cache to the given file. Returns false if the file cannot
+// be written.
+bool
+Decl_cache::save(String const& path) const
+{
+  std::ofstream os(path);
+  os << cache_version << '\n';
+  for (auto const& x : decls) {
+    Decl_fingerprint const& fp = x.second;
+    os << fp.key << '\t' << fp.tokens << '\t' << fp.interface;
+    for (String const& u : fp.uses)
+      os << '\t' << u;
+    os << '\n';
+  }
+  return bool(os);
+}
+
+
+// -------------------------------------------------------------------------- //
+// Declaration tracking
+
+// Record the hash of the tokens of a declaration in the translation
+// scope.
+void
+Decl_tracker::declare(Decl const& d, std::uint64_t h)
+{
+  if (tokens.emplace(&d, h).second)
+    decls.push_back(&d);
+}
+
+
+// Record that the declaration or definition of user uses d.
+void
+Decl_tracker::use(Decl const& user, Decl const& d)
+{
+  if (&user != &d)
+    uses[&user].push_back(&d);
+}
+
+
+void
+note_use(Context& cxt, Decl const& d)
+{
+  if (!cxt.tracker.enabled)
+    return;
+  if (Decl const* user = cxt.local().decl) {
+    Context_lock lock(cxt);
+    cxt.tracker.use(*user, d);
+  }
+}
+
+
+Track_uses::Track_uses(Context& c, Decl const& d)
+  : cxt(c), prev(c.local().decl)
+{
+  if (cxt.tracker.tokens.count(&d))
+    cxt.local().decl = &d;
+}
+
+
+Track_uses::~Track_uses()
+{
+  cxt.local().decl = prev;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Fingerprints
+
+// Returns the key of a declaration, which is its signature. Overloads
+// are distinguished by their types, so the key of a function does not
+// depend on the order of declarations.
+static String
+get_key(Decl const& d)
+{
+  std::stringstream ss;
+  ss << d.name();
+  if (is<Function_decl>(&d))
+    ss << ' ' << d.type();
+  return ss.str();
+}
+
+
+// Returns the hash of the interface of a declaration. The interface of
+// a type is its definition, so that is given by its tokens.
+static std::uint64_t
+get_interface(Decl const& d, std::uint64_t tokens)
+{
+  if (is<Type_decl>(&d))
+    return tokens;
+  std::stringstream ss;
+  ss << d.type();
+  return hash_spelling(ss.str());
+}
+
+
+// Returns the fingerprints of the tracked declarations. Uses of
+// declarations outside the translation scope (e.g., parameters and
+// local variables) are not recorded.
+Decl_cache
+make_decl_cache(Decl_tracker const& t)
+{
+  std::unordered_map<Decl const*, String> keys;
+  for (Decl const* d : t.decls)
+    keys.emplace(d, get_key(*d));
+
+  Decl_cache cache;
+  for (Decl const* d : t.decls) {
+    Decl_fingerprint fp;
+    fp.key = keys[d];
+    fp.tokens = t.tokens.at(d);
+    fp.interface = get_interface(*d, fp.tokens);
+    auto iter = t.uses.find(d);
+    if (iter != t.uses.end()) {
+      for (Decl const* u : iter->second) {
+        auto k = keys.find(u);
+        if (k != keys.end())
+          fp.uses.push_back(k->second);
+      }
+    }
+
+    // Redeclarations have the same key. Their fingerprints are combined
+    // so that a change to any of them is detected.
+    auto prev = cache.decls.find(fp.key);
+    if (prev != cache.decls.end()) {
+      Decl_fingerprint& fp0 = prev->second;
+      fp0.tokens = (fp0.tokens ^ fp.tokens) * 0x100000001b3ull;
+      fp0.interface = get_interface(*d, fp0.tokens);
+      fp0.uses.insert(fp0.uses.end(), fp.uses.begin(), fp.uses.end());
+    } else {
+      cache.decls.emplace(fp.key, std::move(fp));
+    }
+  }
+
+  for (auto& x : cache.decls) {
+    std::vector<String>& uses = x.second.uses;
+    std::sort(uses.begin(), uses.end());
+    uses.erase(std::unique(uses.begin(), uses.end()), uses.end());
+  }
+  return cache;
+}
+
+
+// Returns true if the fingerprint fp in cur is stale with respect to
+// the previous cache.
+static bool
+is_stale(Decl_cache const& prev, Decl_cache const& cur, Decl_fingerprint const& fp)
+{
+  auto iter = prev.decls.find(fp.key);
+  if (iter == prev.decls.end() || iter->second.tokens != fp.tokens)
+    return true;
+  for (String const& u : fp.uses) {
+    auto p = prev.decls.find(u);
+    auto c = cur.decls.find(u);
+    if (p == prev.decls.end() || p->second.interface != c->second.interface)
+      return true;
+  }
+  return false;
+}
+
+
+// Returns the keys of the declarations in cur that are stale with
+// respect to the previous cache, in sorted order.
+std::vector<String>
+get_stale_declarations(Decl_cache const& prev, Decl_cache const& cur)
+{
+  std::vector<String> stale;
+  for (auto const& x : cur.decls)
+    if (is_stale(prev, cur, x.second))
+      stale.push_back(x.first);
+  std::sort(stale.begin(), stale.end());
+  return stale;
+}
+
+
+} // namespace banjo
@@ -0,0 +1,96 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_INCREMENTAL_HPP
+#define BANJO_INCREMENTAL_HPP
+
+// This module determines which declarations are affected by a change
+// to a translation. Each declaration in the translation scope is
+// fingerprinted by a hash of its tokens and a hash of its interface
+// (its declared type). The declarations used by each declaration are
+// recorded during elaboration. A declaration is stale if its tokens
+// have changed or if the interface of any declaration it uses has
+// changed.
+//
+// Stale declarations are only reported. Every declaration is still
+// parsed and elaborated on each run; unchanged declarations are not
+// reused from a previous translation.
+//
+// Fingerprints are saved in a cache file between runs.
+
+#include "prelude.hpp"
+#include "language.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+namespace banjo
+{
+
+// The fingerprint of a declaration. The key identifies the declaration
+// across runs by its signature: its name, and the type of a function.
+struct Decl_fingerprint
+{
+  String              key;
+  std::uint64_t       tokens;
+  std::uint64_t       interface;
+  std::vector<String> uses;
+};
+
+
+// The fingerprints of all declarations in a translation.
+struct Decl_cache
+{
+  using Map = std::unordered_map<String, Decl_fingerprint>;
+
+  bool load(String const&);
+  bool save(String const&) const;
+
+  std::size_t size() const { return decls.size(); }
+
+  Map decls;
+};
+
+
+// Records the token hashes of declarations in the translation scope
+// and the declarations used by each, as the translation is parsed
+// and elaborated.
+struct Decl_tracker
+{
+  void declare(Decl const&, std::uint64_t);
+  void use(Decl const&, Decl const&);
+
+  bool                                                      enabled = false;
+  std::vector<Decl const*>                                  decls;
+  std::unordered_map<Decl const*, std::uint64_t>            tokens;
+  std::unordered_map<Decl const*, std::vector<Decl const*>> uses;
+};
+
+
+Decl_cache make_decl_cache(Decl_tracker const&);
+std::vector<String> get_stale_declarations(Decl_cache const&, Decl_cache const&);
+
+
+// Record that the declaration being elaborated uses d.
+void note_use(Context&, Decl const&);
+
+
+// Attribute uses to the declaration d while it is elaborated, if d is
+// tracked. Uses within nested declarations (e.g., class members) are
+// attributed to the enclosing tracked declaration.
+struct Track_uses
+{
+  Track_uses(Context&, Decl const&);
+  ~Track_uses();
+
+  Context&    cxt;
+  Decl const* prev;
+};
+
+
+} // namespace banjo
+
+
+#endif
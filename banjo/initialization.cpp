@@ -160,7 +160,7 @@ copy_initialize(Context& cxt, Type& t, Expr& e)
   //
   // TODO: Catch exceptions and restructure the error with
   // the conversion error as an explanation.
-  Expr& c = standard_conversion(e, t);
+  Expr& c = standard_conversion(cxt, e, t);
   return build.make_copy_init(t, c);
 }
 
@@ -170,7 +170,7 @@ Expr&
 array_initialize(Type& t, Expr& e)
 {
   Type& et = e.type();
-  if(is_equivalent(t,et))
+  if(is_same(t,et))
     return e;
     
   if(is_tuple_type(e.type())) {
@@ -185,7 +185,7 @@ Expr&
 tuple_initialize(Type& t, Expr& e)
 {
   Type& et = e.type();
-  if(is_equivalent(t,et))
+  if(is_same(t,et))
     return e;
   
   if(is_array_type(e.type())) {
@@ -277,7 +277,7 @@ direct_initialize(Context& cxt, Type& t, Expr_list& es)
   //
   // TODO: Catch exceptions and restructure the error with
   // the conversion error as an explanation.
-  Expr& c = standard_conversion(e, t);
+  Expr& c = standard_conversion(cxt, e, t);
   return cxt.make_copy_init(t, c);
 }
 
@@ -327,7 +327,7 @@ is_reference_related(Type const& t1, Type const& t2)
 {
   Type const& u1 = t1.unqualified_type();
   Type const& u2 = t2.unqualified_type();
-  return is_equivalent(u1, u2);
+  return is_same(u1, u2);
 }
 
 
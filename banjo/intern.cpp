@@ -0,0 +1,107 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "intern.hpp"
+#include "token.hpp"
+
+
+namespace banjo
+{
+
+constexpr std::size_t Intern_table::stripes;
+
+
+// Returns the symbol for s in the stripe, or nullptr if s has not
+// been interned.
+Symbol const*
+Intern_table::find(Stripe& st, String_view s)
+{
+  std::shared_lock<std::shared_timed_mutex> lock(st.lock);
+  auto iter = st.map.find(s);
+  if (iter != st.map.end())
+    return iter->second;
+  return nullptr;
+}
+
+
+// Record the symbol for s in the stripe. This must be called with
+// the symbol table locked, so no other thread can be saving s.
+Symbol const*
+Intern_table::save(Stripe& st, String_view s, Symbol const* sym)
+{
+  std::unique_lock<std::shared_timed_mutex> lock(st.lock);
+  st.pool.emplace_back(s.begin(), s.end());
+  String const& str = st.pool.back();
+  st.map.emplace(String_view(str.data(), str.size()), sym);
+  return sym;
+}
+
+
+// Returns the symbol with spelling s, or nullptr if there is no
+// such symbol.
+Symbol const*
+Intern_table::get(String_view s)
+{
+  Stripe& st = stripe(s);
+  if (Symbol const* sym = find(st, s))
+    return sym;
+
+  std::lock_guard<std::mutex> lock(sync);
+  if (Symbol const* sym = find(st, s))
+    return sym;
+  if (Symbol const* sym = syms.get(String(s.begin(), s.end())))
+    return save(st, s, sym);
+  return nullptr;
+}
+
+
+// Returns the symbol with spelling s. If there is no such symbol,
+// s is entered as an identifier.
+Symbol const*
+Intern_table::put_identifier(String_view s)
+{
+  Stripe& st = stripe(s);
+  if (Symbol const* sym = find(st, s))
+    return sym;
+
+  std::lock_guard<std::mutex> lock(sync);
+  if (Symbol const* sym = find(st, s))
+    return sym;
+  String str(s.begin(), s.end());
+  Symbol const* sym = syms.get(str);
+  if (!sym)
+    sym = syms.put_identifier(identifier_tok, str);
+  return save(st, s, sym);
+}
+
+
+// Returns the integer symbol with spelling s and value n.
+Symbol const*
+Intern_table::put_integer(String_view s, int n)
+{
+  Stripe& st = stripe(s);
+  if (Symbol const* sym = find(st, s))
+    return sym;
+
+  std::lock_guard<std::mutex> lock(sync);
+  if (Symbol const* sym = find(st, s))
+    return sym;
+  Symbol const* sym = syms.put_integer(integer_tok, String(s.begin(), s.end()), n);
+  return save(st, s, sym);
+}
+
+
+// Returns the number of interned spellings.
+std::size_t
+Intern_table::size() const
+{
+  std::size_t n = 0;
+  for (Stripe const& st : table) {
+    std::shared_lock<std::shared_timed_mutex> lock(st.lock);
+    n += st.map.size();
+  }
+  return n;
+}
+
+
+} // namespace banjo
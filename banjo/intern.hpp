@@ -0,0 +1,86 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_INTERN_HPP
+#define BANJO_INTERN_HPP
+
+// This module provides a concurrent front end to the symbol table.
+// Spellings are mapped to their symbols by a lock-striped hash table.
+// Lookups of spellings that have already been interned only acquire
+// a shared lock on one stripe. The underlying symbol table is only
+// consulted (under an exclusive lock) the first time a spelling is
+// seen.
+//
+// Symbols are owned by the symbol table and their addresses are
+// stable. The table owns copies of the spellings it maps, so views
+// passed to lookup functions need not outlive the call.
+
+#include "prelude.hpp"
+#include "source.hpp"
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+
+namespace banjo
+{
+
+// A concurrent table of interned spellings. All functions may be
+// called from multiple threads.
+struct Intern_table
+{
+  static constexpr std::size_t stripes = 64;
+
+  explicit Intern_table(Symbol_table& s)
+    : syms(s)
+  { }
+
+  // Non-copyable
+  Intern_table(Intern_table const&) = delete;
+  Intern_table& operator=(Intern_table const&) = delete;
+
+  Symbol const* get(String_view);
+  Symbol const* put_identifier(String_view);
+  Symbol const* put_integer(String_view, int);
+
+  std::size_t size() const;
+
+  // A stripe maps spellings to symbols. Spellings are views of the
+  // strings in the stripe's pool. Stripes are cache-line aligned so
+  // that their locks are not falsely shared.
+  struct alignas(64) Stripe
+  {
+    using Map = std::unordered_map<String_view, Symbol const*, String_view_hash>;
+
+    mutable std::shared_timed_mutex lock;
+    Map                             map;
+    std::deque<String>              pool;
+  };
+
+  Stripe& stripe(String_view s);
+
+  Symbol const* find(Stripe&, String_view);
+  Symbol const* save(Stripe&, String_view, Symbol const*);
+
+  Symbol_table& syms;  // The underlying symbol table
+  std::mutex    sync;  // Guards the symbol table
+  Stripe        table[stripes];
+};
+
+
+// Returns the stripe for the spelling s. Stripes are selected by the
+// high-order bits of the hash, since the low-order bits select the
+// bucket within the stripe.
+inline Intern_table::Stripe&
+Intern_table::stripe(String_view s)
+{
+  return table[(hash_spelling(s) >> 32) % stripes];
+}
+
+
+} // namespace banjo
+
+
+#endif
@@ -4,29 +4,46 @@
 #include "lexer.hpp"
 #include "token.hpp"
 #include "context.hpp"
+#include "scan.hpp"
 
 #include "lingo/error.hpp"
 
-#include <cassert>
+#include <atomic>
 #include <cctype>
 #include <string>
 #include <iostream>
+#include <thread>
 
 namespace banjo
 {
 
-Symbol_table&
-Lexer::symbols()
+Intern_table&
+Lexer::spellings()
 {
-  return cxt_.symbols();
+  return cxt_.spellings();
 }
 
 
-// Copy the current character into the save buffer.
+// -------------------------------------------------------------------------- //
+// Lexer
+//
+// Runs of whitespace, identifier characters, digits, and comment
+// text are scanned directly on the input buffer (see Input_stream
+// and scan.hpp) rather than one character at a time. Identifier and
+// integer spellings are viewed in the input buffer while scanning,
+// and copied only when they are first interned.
+//
+// Spellings are interned through the context's concurrent interning
+// table (see intern.hpp), so files can be lexed concurrently. Each
+// lexer resolves repeated spellings through its own spelling table
+// first.
+
+// Consume the current character. Spellings are taken from the input
+// buffer, so the character is not saved.
 void
 Lexer::get()
 {
-  buf_.put(cs_.get());
+  cs_.get();
 }
 
 
@@ -45,6 +62,7 @@ Lexer::scan()
     space();
 
     loc_ = cs_.location();
+    start_ = cs_.position();
     switch (lookahead()) {
     case '\0': return eof();
 
@@ -155,29 +173,31 @@ Lexer::scan()
 }
 
 
+// Diagnose an unrecognized character. If the lexer has a diagnostic
+// buffer, the error is saved there.
 void
 Lexer::error()
 {
-  lingo::error(loc_, "unrecognized character '{}'", cs_.get());
+  char c = cs_.get();
+  if (diags_)
+    diags_->put(error_diag, loc_, "unrecognized character '{}'", c);
+  else
+    lingo::error(loc_, "unrecognized character '{}'", c);
 }
 
 
 void
 Lexer::space()
 {
-  while (is_space(cs_.peek()))
-    cs_.ignore();
+  cs_.advance(scan_space(cs_.position(), cs_.limit()));
 }
 
 
-// Consume all characters through the end of line. Clear the character
-// cache before continuing.
+// Consume all characters through the end of line.
 void
 Lexer::comment()
 {
-  while (lookahead() != '\n')
-    cs_.ignore();
-  buf_.clear();
+  cs_.advance(scan_line(cs_.position(), cs_.limit()));
 }
 
 
@@ -191,9 +211,9 @@ Lexer::eof()
 Token
 Lexer::symbol()
 {
-  // Nothing to do here... we've already buffered all of
+  // Nothing to do here... we've already consumed all of
   // the characters for the symbol.
-  return on_symbol();
+  return on_symbol(String_view(start_, cs_.position() - start_));
 }
 
 
@@ -201,7 +221,7 @@ Lexer::symbol()
 void
 Lexer::digit()
 {
-  assert(is_decimal_digit(cs_.peek()));
+  lingo_assert(is_decimal_digit(cs_.peek()));
   get();
 }
 
@@ -212,25 +232,19 @@ Lexer::digit()
 void
 Lexer::letter()
 {
-  assert(is_alpha(cs_.peek()));
+  lingo_assert(is_alpha(cs_.peek()));
   get();
 }
 
 
-inline bool
-is_identifier_alpha(char c)
-{
-  return is_alpha(c) || is_decimal_digit(c) || c == '_';
-}
-
-
 Token
 Lexer::word()
 {
-  letter();
-  while (is_identifier_alpha(lookahead()))
-    get();
-  return on_word();
+  lingo_assert(is_alpha(cs_.peek()));
+  char const* first = cs_.position();
+  char const* last = scan_identifier(first + 1, cs_.limit());
+  cs_.advance(last);
+  return on_word(String_view(first, last - first));
 }
 
 
@@ -238,40 +252,64 @@ Lexer::word()
 Token
 Lexer::integer()
 {
-  digit();
-  while (is_decimal_digit(cs_.peek()))
-    digit();
-  return on_integer();
+  lingo_assert(is_decimal_digit(cs_.peek()));
+  char const* first = cs_.position();
+  char const* last = scan_digits(first + 1, cs_.limit());
+  cs_.advance(last);
+  return on_integer(String_view(first, last - first));
 }
 
 
 Token
-Lexer::on_symbol()
+Lexer::on_symbol(String_view s)
 {
-  Symbol const* sym = symbols().get(buf_.take());
+  Symbol const* sym = find(s);
+  if (!sym) {
+    sym = spellings().get(s);
+    seen_.emplace(s, sym);
+  }
   return Token(loc_, sym);
 }
 
 
+// Returns the symbol previously interned for the spelling s, or
+// nullptr if s has not been seen.
+Symbol const*
+Lexer::find(String_view s) const
+{
+  auto iter = seen_.find(s);
+  if (iter != seen_.end())
+    return iter->second;
+  return nullptr;
+}
+
+
 // Try looking up the symbol first. If there is no such
 // symbol, then this must be an identifier.
+//
+// Repeated spellings in the same file are resolved through the
+// lexer's view-keyed table without consulting the interning table.
 Token
-Lexer::on_word()
+Lexer::on_word(String_view s)
 {
-  String str = buf_.take();
-  Symbol const* sym = symbols().get(str);
-  if (!sym)
-    sym = symbols().put_identifier(identifier_tok, str);
+  Symbol const* sym = find(s);
+  if (!sym) {
+    sym = spellings().put_identifier(s);
+    seen_.emplace(s, sym);
+  }
   return Token(loc_, sym);
 }
 
 
 Token
-Lexer::on_integer()
+Lexer::on_integer(String_view s)
 {
-  String str = buf_.take();
-  int n = string_to_int<int>(str, 10);
-  Symbol* sym = symbols().put_integer(integer_tok, str, n);
+  Symbol const* sym = find(s);
+  if (!sym) {
+    int n = string_to_int<int>(String(s.begin(), s.end()), 10);
+    sym = spellings().put_integer(s, n);
+    seen_.emplace(s, sym);
+  }
   return Token(loc_, sym);
 }
 
@@ -280,7 +318,43 @@ void
 Lexer::operator()()
 {
   while (Token tok = scan())
-    ts_.put(tok);
+    ts_.put(tok, cs_.file, start_ - cs_.file.begin());
+}
+
+
+// -------------------------------------------------------------------------- //
+// Parallel lexing
+
+// Lex each input file into its own token buffer using up to n
+// threads, and then append those buffers to toks in the order
+// the files were given. Diagnostics are buffered per file and
+// emitted in the same order. Returns false if any file had errors.
+bool
+lex_files(Context& cxt, std::vector<File*> const& files, Token_buffer& toks, int n)
+{
+  std::vector<Token_buffer> bufs(files.size());
+  std::vector<Diagnostic_buffer> diags(files.size());
+  std::atomic<std::size_t> next(0);
+  auto work = [&]() {
+    for (std::size_t i = next++; i < files.size(); i = next++) {
+      Input_stream cs(*files[i]);
+      Lexer lex(cxt, cs, bufs[i], &diags[i]);
+      lex();
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (std::size_t i = 1; i < std::size_t(n) && i < files.size(); ++i)
+    pool.emplace_back(work);
+  work();
+  for (std::thread& t : pool)
+    t.join();
+
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    diags[i].emit();
+    toks.append(bufs[i]);
+  }
+  return error_count() == 0;
 }
 
 
@@ -5,11 +5,18 @@
 #define BANJO_LEXER_HPP
 
 #include "prelude.hpp"
+#include "token.hpp"
+#include "source.hpp"
+#include "intern.hpp"
+#include "diagnostics.hpp"
 
 #include <lingo/symbol.hpp>
 #include <lingo/token.hpp>
 #include <lingo/character.hpp>
 
+#include <unordered_map>
+#include <vector>
+
 
 namespace banjo
 {
@@ -17,6 +24,35 @@ namespace banjo
 struct Context;
 
 
+// A character stream that gives the lexer access to its position in
+// the input buffer, so that runs of characters can be scanned directly
+// on the buffer (see scan.hpp). The stream also refers to its file, so
+// that the locations of tokens can be rebuilt from their offsets (see
+// Token_buffer).
+struct Input_stream : Character_stream
+{
+  Input_stream(File& f)
+    : Character_stream(f), file(f)
+  { }
+
+  // Returns the current position in the input buffer.
+  char const* position() const { return first_; }
+
+  // Returns the end of the input buffer.
+  char const* limit() const { return last_; }
+
+  // Advance the stream to p, which shall be within the rest of the
+  // input buffer.
+  void advance(char const* p)
+  {
+    lingo_assert(first_ <= p && p <= last_);
+    first_ = p;
+  }
+
+  File& file; // The file being read
+};
+
+
 // The Lexer is a facility that translates sequences of
 // characters into tokens. This is primarily a callback
 // interface for the lexing function for the language.
@@ -26,8 +62,8 @@ struct Context;
 // and diagnostics into the lexer.
 struct Lexer
 {
-  Lexer(Context& cxt, Character_stream& cs, Token_stream& ts)
-    : cxt_(cxt), cs_(cs), ts_(ts)
+  Lexer(Context& cxt, Input_stream& cs, Token_buffer& ts, Diagnostic_buffer* diags = nullptr)
+    : cxt_(cxt), cs_(cs), ts_(ts), diags_(diags), start_(nullptr)
   { }
 
   void operator()();
@@ -47,23 +83,34 @@ struct Lexer
   void digit();
 
   // Semantic actions.
-  Token on_symbol();
-  Token on_word();
-  Token on_integer();
+  Token on_symbol(String_view);
+  Token on_word(String_view);
+  Token on_integer(String_view);
+
+  Symbol const* find(String_view) const;
 
   char lookahead() const;
   void get();
 
-  Symbol_table& symbols();
+  Intern_table& spellings();
 
-  Context&          cxt_;
-  Character_stream& cs_;
-  Token_stream&     ts_;
-  String_builder    buf_;
-  Location          loc_;
+  Context&           cxt_;
+  Input_stream&      cs_;
+  Token_buffer&      ts_;
+  Diagnostic_buffer* diags_; // Buffered diagnostics, if any
+  Location           loc_;   // The location of the current token
+  char const*        start_; // The start of the current token
+
+  // Maps spellings in the input to their interned symbols.
+  std::unordered_map<String_view, Symbol const*, String_view_hash> seen_;
 };
 
 
+// Lex each file into its own buffer using up to n threads, and then
+// append those buffers to toks in the order the files were given.
+bool lex_files(Context&, std::vector<File*> const&, Token_buffer&, int);
+
+
 } // namespace banjo
 
 
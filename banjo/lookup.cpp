@@ -19,28 +19,27 @@ namespace banjo
 
 
 // Returns the non-empty set of declarations for give (unqualified) id.
-// Throws an exception if no matching declarations are found.
+// Throws an exception if no matching declarations are found. The
+// result refers to the overload set bound in the scope where the
+// declarations were found.
 //
 // Lookup ends as soon as a declaration is found for the given name.
 //
 // TODO: How should we handle non-simple id's like operator-ids
 // and conversion function ids.
-Decl_list
+Overload_view
 unqualified_lookup(Context& cxt, Name const& name)
 {
-  Scope* p = &cxt.current_scope();
-  while (p) {
-    // In general, a name used in any context must be declared
-    // before it's use. Search this scope for such a declaration.
-    if (Overload_set* ovl = p->lookup(name))
-      return *ovl;
-
-    // TODO: The "advanced" search rules depend on the declaration
-    // associated with the current scope. For example, unqualified
-    // lookup within a class searches base classes.
-
-    p = p->enclosing_scope();
-  }
+  // In general, a name used in any context must be declared
+  // before it's use. Search this and each enclosing scope for such
+  // a declaration. The innermost binding of a simple id is cached
+  // in the current scope.
+  //
+  // TODO: The "advanced" search rules depend on the declaration
+  // associated with the current scope. For example, unqualified
+  // lookup within a class searches base classes.
+  if (Overload_set* ovl = cxt.current_scope().find(name))
+    return *ovl;
 
   error(cxt, "no matching declaration for '{}'", name);
   throw Lookup_error("no matching declaration");
@@ -52,7 +51,7 @@ unqualified_lookup(Context& cxt, Name const& name)
 Decl&
 simple_lookup(Context& cxt, Name const& name)
 {
-  Decl_list result = unqualified_lookup(cxt, name);
+  Overload_view result = unqualified_lookup(cxt, name);
 
   // TODO: Can we find names that are similar to name in order to support 
   // better diagnostics? As in "did you mean...?".
@@ -75,20 +74,20 @@ simple_lookup(Context& cxt, Name const& name)
 // Qualified lookup
 
 // Just search in the local scope.
-Decl_list
+Overload_view
 qualified_lookup(Context& cxt, Scope& scope, Name const& name)
 {
   if (Overload_set* ovl = scope.lookup(name))
     return *ovl;
   else
-    return {};  
+    return {};
 }
 
 
 // Perform qualified lookup. This searches the scope of the user-defined 
 // type t and its base classes for the declared name n. If lookup fails, 
 // the program is ill-formed.
-Decl_list
+Overload_view
 qualified_lookup(Context& cxt, Type& type, Name const& name)
 {
   // TODO: This probably needs to strip of all reference qualifiers,
@@ -102,7 +101,7 @@ qualified_lookup(Context& cxt, Type& type, Name const& name)
   Decl& decl = cast<Declared_type>(t1).declaration();
   
   // Start by searching this scope.
-  Decl_list decls = qualified_lookup(cxt, cxt.saved_scope(decl), name);
+  Overload_view decls = qualified_lookup(cxt, cxt.saved_scope(decl), name);
 
   // TODO: Search (all) bases for a member with the given name.
   // Note that multiple members can be found in multiple base classes.
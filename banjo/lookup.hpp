@@ -6,6 +6,7 @@
 
 #include "prelude.hpp"
 #include "language.hpp"
+#include "overload.hpp"
 
 
 namespace banjo
@@ -13,8 +14,8 @@ namespace banjo
 
 
 Decl& simple_lookup(Context&, Name const&);
-Decl_list unqualified_lookup(Context&, Name const&);
-Decl_list qualified_lookup(Context&, Type&, Name const&);
+Overload_view unqualified_lookup(Context&, Name const&);
+Overload_view qualified_lookup(Context&, Type&, Name const&);
 
 // Decl_list argument_dependent_lookup(Scope&, Expr_list&);
 
@@ -5,6 +5,7 @@
 #include "lexer.hpp"
 #include "parser.hpp"
 #include "printer.hpp"
+#include "serialization.hpp"
 
 #include "gen/llvm/generator.hpp"
 
@@ -12,7 +13,9 @@
 #include <lingo/io.hpp>
 #include <lingo/error.hpp>
 
+#include <cstdlib>
 #include <iostream>
+#include <memory>
 
 
 using namespace lingo;
@@ -28,6 +31,15 @@ struct Options
 
   String   emit    = "bano";
   File_seq inputs  = {};
+  bool     stats   = false;
+  int      jobs    = 1;
+  bool     lazy    = false;
+  String   cache   = "";
+  String   save    = "";
+  String   load    = "";
+  bool     profile = false;
+
+  Evaluation_limits limits = {};
 };
 
 
@@ -55,6 +67,116 @@ parse_emit(int& argn, int argc, char* argv[], Options& opts)
 }
 
 
+void
+parse_stats(int& argn, int argc, char* argv[], Options& opts)
+{
+  opts.stats = true;
+}
+
+
+void
+parse_jobs(int& argn, int argc, char* argv[], Options& opts)
+{
+  if (argn + 1 == argc) {
+    error("expected a number of jobs after '-j'");
+    exit(1);
+  }
+  opts.jobs = std::atoi(argv[++argn]);
+  if (opts.jobs < 1) {
+    error("invalid number of jobs '{}'", argv[argn]);
+    exit(1);
+  }
+}
+
+
+void
+parse_lazy(int& argn, int argc, char* argv[], Options& opts)
+{
+  opts.lazy = true;
+}
+
+
+// Parse the limit following the option. A limit of 0 means that the
+// resource is unlimited.
+void
+parse_limit(int& argn, int argc, char* argv[], std::size_t& n)
+{
+  char const* opt = argv[argn];
+  if (argn + 1 == argc) {
+    error("expected a limit after '{}'", opt);
+    exit(1);
+  }
+  char const* arg = argv[++argn];
+  char* end;
+  n = std::strtoull(arg, &end, 10);
+  if (*arg < '0' || *arg > '9' || *end) {
+    error("invalid limit '{}' for '{}'", arg, opt);
+    exit(1);
+  }
+}
+
+
+void
+parse_eval_steps(int& argn, int argc, char* argv[], Options& opts)
+{
+  parse_limit(argn, argc, argv, opts.limits.steps);
+}
+
+
+void
+parse_eval_depth(int& argn, int argc, char* argv[], Options& opts)
+{
+  parse_limit(argn, argc, argv, opts.limits.depth);
+}
+
+
+void
+parse_eval_memory(int& argn, int argc, char* argv[], Options& opts)
+{
+  parse_limit(argn, argc, argv, opts.limits.bytes);
+}
+
+
+void
+parse_profile_eval(int& argn, int argc, char* argv[], Options& opts)
+{
+  opts.profile = true;
+}
+
+
+void
+parse_cache(int& argn, int argc, char* argv[], Options& opts)
+{
+  if (argn + 1 == argc) {
+    error("expected a file name after '-cache'");
+    exit(1);
+  }
+  opts.cache = argv[++argn];
+}
+
+
+void
+parse_emit_ast(int& argn, int argc, char* argv[], Options& opts)
+{
+  if (argn + 1 == argc) {
+    error("expected a file name after '-emit-ast'");
+    exit(1);
+  }
+  opts.save = argv[++argn];
+}
+
+
+void
+parse_load_ast(int& argn, int argc, char* argv[], Options& opts)
+{
+  if (argn + 1 == argc) {
+    error("expected a file name after '-load-ast'");
+    exit(1);
+  }
+  opts.load = argv[++argn];
+}
+
+
 void
 parse_positional(int& argn, int argc, char* argv[], Options& opts)
 {
@@ -66,7 +188,17 @@ void
 parse_args(int argc, char* argv[], Options& opts)
 {
   static Options_map all {
-    {"-emit", parse_emit}
+    {"-emit", parse_emit},
+    {"-stats", parse_stats},
+    {"-j", parse_jobs},
+    {"-lazy", parse_lazy},
+    {"-cache", parse_cache},
+    {"-emit-ast", parse_emit_ast},
+    {"-load-ast", parse_load_ast},
+    {"-eval-steps", parse_eval_steps},
+    {"-eval-depth", parse_eval_depth},
+    {"-eval-memory", parse_eval_memory},
+    {"-profile-eval", parse_profile_eval}
   };
 
 
@@ -87,6 +219,46 @@ parse_args(int argc, char* argv[], Options& opts)
 
 
 
+// A translation saved with -emit-ast. Terms are read lazily, so the
+// file stays mapped, and the reader alive, while the translation is
+// in use.
+struct Saved_translation
+{
+  std::unique_ptr<Source_file> file;
+  std::unique_ptr<Ast_reader>  reader;
+};
+
+
+// Read a translation saved with -emit-ast into saved.
+Stmt&
+load_translation(Context& cxt, String const& file, Saved_translation& saved)
+{
+  saved.file.reset(new Source_file(file));
+  saved.reader.reset(new Ast_reader(cxt, saved.file->text()));
+  return saved.reader->translation();
+}
+
+
+// Compare the fingerprints of this translation with those saved in
+// the cache file, report the stale declarations, and update the cache.
+// Stale declarations are only reported; the whole translation is
+// still elaborated.
+void
+update_cache(Context& cxt, String const& file)
+{
+  Decl_cache prev;
+  prev.load(file);
+  Decl_cache cur = make_decl_cache(cxt.tracker);
+  std::vector<String> stale = get_stale_declarations(prev, cur);
+  std::cerr << "incremental: " << cur.size() << " declarations, "
+            << stale.size() << " stale\n";
+  for (String const& s : stale)
+    std::cerr << "  " << s << '\n';
+  if (!cur.save(file))
+    warning("could not write cache file '{}'", file);
+}
+
+
 int
 main(int argc, char* argv[])
 {
@@ -95,39 +267,81 @@ main(int argc, char* argv[])
   Options opts;
   parse_args(argc, argv, opts);
 
+  // Elaborate definitions using the same number of threads as lexing.
+  cxt.jobs = opts.jobs;
+
+  // Only elaborate function definitions that are referenced.
+  cxt.lazy = opts.lazy;
+
+  // Fingerprint declarations and report those affected by changes.
+  cxt.tracker.enabled = !opts.cache.empty();
+
+  // Limit and profile compile-time evaluation.
+  cxt.limits = opts.limits;
+  cxt.profiling = opts.profile;
+
   // Check post-configuration options.
-  if (opts.inputs.empty()) {
+  if (opts.inputs.empty() && opts.load.empty()) {
     error("no input files given");
     return -1;
   }
 
-  // Initial file processing.
-
-  // Perform character and lexical analysis.
-  Token_seq toks;
-  for (File* f : opts.inputs) {
-    Character_stream cs(*f);
-    Token_stream ts;
-    Lexer lex(cxt, cs, ts);
-
-    // Lex tokens.
-    lex();
-    if (error_count())
+  // Load a previously saved translation instead of parsing.
+  if (!opts.load.empty()) {
+    Saved_translation saved;
+    try {
+      Stmt& stmt = load_translation(cxt, opts.load, saved);
+      if (opts.emit == "banjo")
+        std::cout << stmt << '\n';
+    } catch (Translation_error& err) {
+      error("{}", err.what());
       return 1;
-    toks.splice(toks.end(), ts.buf_);
+    }
+    if (opts.stats)
+      print_statistics(std::cerr, cxt);
+    return 0;
   }
 
+  // Initial file processing.
+
+  // Perform character and lexical analysis. Tokens from all input
+  // files are appended to a single buffer. With -j N, files are
+  // lexed concurrently.
+  Token_buffer toks;
+  if (!lex_files(cxt, opts.inputs, toks, opts.jobs))
+    return 1;
+
   // Perform syntactic analysis.
-  Token_stream ts(toks);
-  Parser parse(cxt, ts);
+  Parser parse(cxt, toks);
   Stmt& stmt = parse();
 
+  if (cxt.tracker.enabled)
+    update_cache(cxt, opts.cache);
+
+  // Save the translation for later use with -load-ast.
+  if (!opts.save.empty() && !save_ast(stmt, opts.save))
+    warning("could not write AST file '{}'", opts.save);
+
   if (opts.emit == "banjo") {
     std::cout << stmt << '\n';
   }
   else if (opts.emit == "llvm") {
-    ll::Generator gen;
-    gen(stmt);
+    // Constant expressions are folded within the limits given by
+    // -eval-steps, -eval-depth, and -eval-memory.
+    ll::Generator gen(cxt);
+    try {
+      gen(stmt);
+    } catch (Evaluation_error& err) {
+      error("{}", err.what());
+      return 1;
+    }
   }
 
+  // Report memory usage and cache statistics.
+  if (opts.stats)
+    print_statistics(std::cerr, cxt);
+
+  // Report the cost of compile-time evaluation.
+  if (opts.profile)
+    print_profile(std::cerr, cxt.profile);
 }
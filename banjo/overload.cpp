@@ -62,8 +62,8 @@ can_overload(Function_decl& prev, Function_decl& given)
 {
   Function_type& t1 = prev.type();
   Function_type& t2 = given.type();
-  if (is_equivalent(t1.parameter_types(), t2.parameter_types())) {
-    if (!is_equivalent(t1.return_type(), t2.return_type())) {
+  if (is_same(t1.parameter_types(), t2.parameter_types())) {
+    if (!is_same(t1.return_type(), t2.return_type())) {
       return non_overloadable_declaration(prev, given);
     }
   }
@@ -6,34 +6,167 @@
 
 #include "language.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <unordered_set>
 
 
 namespace banjo
 {
 
+// An iterator over a sequence of declaration pointers. Dereferencing
+// the iterator yields a reference to the declaration.
+template<typename T>
+struct Overload_iterator
+{
+  using value_type        = T;
+  using reference         = T&;
+  using pointer           = T*;
+  using difference_type   = std::ptrdiff_t;
+  using iterator_category = std::forward_iterator_tag;
+
+  Overload_iterator() = default;
+
+  Overload_iterator(Decl* const* p)
+    : ptr(p)
+  { }
+
+  reference operator*() const { return **ptr; }
+  pointer  operator->() const { return *ptr; }
+
+  Overload_iterator& operator++()    { ++ptr; return *this; }
+  Overload_iterator  operator++(int) { Overload_iterator x = *this; ++ptr; return x; }
+
+  bool operator==(Overload_iterator i) const { return ptr == i.ptr; }
+  bool operator!=(Overload_iterator i) const { return ptr != i.ptr; }
+
+  Decl* const* ptr;
+};
+
+
 // Represents a set of overloaded declarations. All declarations have
 // the same name, scope, and kind, but may differ in their different
 // types and constraints.
 //
+// Almost every name has a single declaration, so the first few
+// declarations are stored inline. Larger sets are moved to the heap.
+//
 // Note that an overload set is never empty.
-struct Overload_set : Decl_list
+struct Overload_set
 {
-  using iterator       = Decl_list::iterator;
-  using const_iterator = Decl_list::const_iterator;
+  using iterator       = Overload_iterator<Decl>;
+  using const_iterator = Overload_iterator<Decl const>;
+
+  static constexpr std::size_t inline_size = 2;
 
   // Initialize the overload set with a single element.
   Overload_set(Decl& d)
-    : Decl_list {&d}
-  { }
+    : data(local), count(1), cap(inline_size)
+  {
+    local[0] = &d;
+  }
+
+  Overload_set(Overload_set const&);
+  Overload_set& operator=(Overload_set const&) = delete;
+
+  ~Overload_set();
 
   // Returns the name of the overloaded declaratin.
   Name const& name() const;
   Name&       name();
 
+  // Returns the number of declarations.
+  std::size_t size() const { return count; }
+  bool        empty() const { return count == 0; }
+
+  Decl const& front() const { return *data[0]; }
+  Decl&       front()       { return *data[0]; }
+
+  Decl const& back() const { return *data[count - 1]; }
+  Decl&       back()       { return *data[count - 1]; }
+
   // Inserts a new declaration into the overload set. The declaration
   // shall be overloadable with all previous elements of the set.
   void insert(Decl& d) { push_back(d); }
+  void push_back(Decl&);
+
+  iterator begin() { return data; }
+  iterator end()   { return data + count; }
+
+  const_iterator begin() const { return data; }
+  const_iterator end() const   { return data + count; }
+
+  Decl*       local[inline_size]; // Inline storage
+  Decl**      data;               // The declarations
+  std::size_t count;              // The number of declarations
+  std::size_t cap;                // The capacity of data
+};
+
+
+inline
+Overload_set::Overload_set(Overload_set const& x)
+  : data(local), count(0), cap(inline_size)
+{
+  for (std::size_t i = 0; i < x.count; ++i)
+    push_back(*x.data[i]);
+}
+
+
+inline
+Overload_set::~Overload_set()
+{
+  if (data != local)
+    delete [] data;
+}
+
+
+// Append d to the set, moving the declarations to the heap when the
+// inline storage is exhausted.
+inline void
+Overload_set::push_back(Decl& d)
+{
+  if (count == cap) {
+    Decl** p = new Decl*[2 * cap];
+    std::copy(data, data + count, p);
+    if (data != local)
+      delete [] data;
+    data = p;
+    cap *= 2;
+  }
+  data[count++] = &d;
+}
+
+
+// A non-owning view of the declarations found by name lookup. The
+// view is empty if no declarations were found. It refers to the set
+// rather than to its storage, so declarations added to the set after
+// lookup are visible through the view. Iterators obtained from the
+// view are invalidated when the set grows.
+struct Overload_view
+{
+  using iterator = Overload_iterator<Decl>;
+
+  Overload_view()
+    : ovl(nullptr)
+  { }
+
+  Overload_view(Overload_set& ovl)
+    : ovl(&ovl)
+  { }
+
+  std::size_t size() const  { return ovl ? ovl->count : 0; }
+  bool        empty() const { return size() == 0; }
+
+  Decl& front() const { return ovl->front(); }
+  Decl& back() const  { return ovl->back(); }
+
+  iterator begin() const { return ovl ? ovl->begin() : iterator(nullptr); }
+  iterator end() const   { return ovl ? ovl->end() : iterator(nullptr); }
+
+  // Returns the overload set, or nullptr if the view is empty.
+  Overload_set* set() const { return ovl; }
+
+  Overload_set* ovl;
 };
 
 
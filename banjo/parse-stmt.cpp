@@ -218,6 +218,20 @@ Parser::expression_statement()
 }
 
 
+// Record the hash of the tokens of a declaration statement in the
+// translation scope, starting at the given position.
+void
+Parser::track_declaration(Stmt& s, Token_buffer::Position first)
+{
+  if (Declaration_stmt* d = as<Declaration_stmt>(&s)) {
+    std::uint64_t h = 0;
+    for (Token_buffer::Position p = first; p != tokens.position(); ++p)
+      h = h * 31 + hash_spelling(tokens.symbol(p).spelling());
+    cxt.tracker.declare(d->declaration(), h);
+  }
+}
+
+
 // Parse a sequence of statements.
 //
 //    statement-seq:
@@ -230,9 +244,13 @@ Stmt_list
 Parser::statement_seq()
 {
   // First pass: collect declarations
+  bool track = cxt.tracker.enabled && &cxt.current_scope() == state.translation;
   Stmt_list ss;
   do {
+    Token_buffer::Position first = tokens.position();
     Stmt& s = statement();
+    if (track)
+      track_declaration(s, first);
     ss.push_back(s);
   } while (!is_eof() && next_token_is_not(rbrace_tok));
   on_statement_seq(ss);
@@ -17,7 +17,7 @@ namespace
 // stream is at the end of input, then the spelling will
 // reflect that state.
 String const&
-token_spelling(Token_stream& ts)
+token_spelling(Token_buffer& ts)
 {
   static String end = "end-of-input";
   if (ts.eof())
@@ -41,7 +41,7 @@ Parser::symbols()
 bool
 Parser::is_eof() const
 {
-  return !peek();
+  return tokens.eof();
 }
 
 
@@ -57,7 +57,7 @@ Parser::peek() const
 Token_kind
 Parser::lookahead() const
 {
-  return Token_kind(peek().kind());
+  return tokens.kind();
 }
 
 
@@ -65,7 +65,7 @@ Parser::lookahead() const
 Token_kind
 Parser::lookahead(int n) const
 {
-  return Token_kind(tokens.peek(n).kind());
+  return tokens.kind(n);
 }
 
 
@@ -306,9 +306,15 @@ Parser::translation()
   // TODO: We should enter the global scope and not create a temporary
   // one.
   Enter_scope scope(cxt);
+  state.translation = &cxt.current_scope();
 
   Stmt_list ss = statement_seq();
-  return on_translation_statement(std::move(ss));
+  Stmt& s = on_translation_statement(std::move(ss));
+
+  // Definitions that were never referenced are left unparsed. Their
+  // scope ends here.
+  cxt.deferred.clear();
+  return s;
 }
 
 
@@ -16,7 +16,7 @@ namespace banjo
 
 // Maintains a stack of braces. Note that "braces" is meant to imply
 // any kind of bracketing characters.
-struct Braces : Token_seq
+struct Braces : std::vector<Token>
 {
   void open(Token tok) { push_back(tok); }
   void close()         { pop_back(); }
@@ -30,7 +30,7 @@ struct Parser
 {
   using Specs = Specifier_set; // For brevity
 
-  Parser(Context& cxt, Token_stream& ts)
+  Parser(Context& cxt, Token_buffer& ts)
     : cxt(cxt), build(cxt), tokens(ts), state()
   { }
 
@@ -122,6 +122,7 @@ struct Parser
   Stmt& declaration_statement();
   Stmt& expression_statement();
   Stmt_list statement_seq();
+  void track_declaration(Stmt&, Token_buffer::Position);
 
   // Declarations
   Name& declarator();
@@ -215,6 +216,8 @@ struct Parser
 
   // Definition elaboration
   void elaborate_definitions(Stmt_list&);
+  void elaborate_definitions_concurrently(Stmt_list&);
+  bool is_deferred_definition(Stmt&);
   void elaborate_definition(Stmt&);
   void elaborate_definition(Decl&);
   void elaborate_super_initializer(Super_decl&);
@@ -424,11 +427,12 @@ struct Parser
   struct State
   {
     State()
-      : braces(), specs()
+      : braces(), specs(), translation(nullptr)
     { }
 
     Braces  braces;
     Specs   specs;
+    Scope*  translation; // The scope of the translation unit
 
     Decl_list implicit_parms; // Implicit template parameters
   };
@@ -437,7 +441,7 @@ struct Parser
 
   Context&      cxt;
   Builder       build;
-  Token_stream& tokens;
+  Token_buffer& tokens;
   State         state;
 };
 
@@ -479,7 +483,7 @@ Parser::take_decl_specs()
 // an explicit indication of failure?
 struct Trial_parser
 {
-  using Position = Token_stream::Position;
+  using Position = Token_buffer::Position;
   using State = Parser::State;
 
   Trial_parser(Parser& p)
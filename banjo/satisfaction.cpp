@@ -8,27 +8,92 @@
 #include "builder.hpp"
 #include "printer.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 
 namespace banjo
 {
 
+using Name_list = std::vector<Name const*>;
+
+
+static bool is_satisfied(Context&, Cons&, Name_list&);
+
+
+// -------------------------------------------------------------------------- //
+// Dependencies
+//
+// The result of satisfaction depends on the declarations named by a
+// constraint. For a class type, this includes the class's members, so
+// the result also depends on the name of the class (see declare()).
+
+static void collect_names(Term const&, Name_list&);
+
+
+static void
+collect_names(Type const& t, Name_list& ns)
+{
+  if (Declared_type const* d = as<Declared_type>(&t))
+    ns.push_back(&d->declaration().name());
+  else if (Unary_type const* u = as<Unary_type>(&t))
+    collect_names(u->type(), ns);
+}
+
+
+static void
+collect_names(Expr const& e, Name_list& ns)
+{
+  if (Decl_expr const* d = as<Decl_expr>(&e)) {
+    ns.push_back(&d->declaration().name());
+  } else if (Call_expr const* c = as<Call_expr>(&e)) {
+    collect_names(c->function(), ns);
+    for (Expr const& a : c->arguments())
+      collect_names(a, ns);
+  } else if (Unary_expr const* u = as<Unary_expr>(&e)) {
+    collect_names(u->operand(), ns);
+  } else if (Binary_expr const* b = as<Binary_expr>(&e)) {
+    collect_names(b->left(), ns);
+    collect_names(b->right(), ns);
+  } else if (Conv const* c = as<Conv>(&e)) {
+    collect_names(c->source(), ns);
+  }
+  collect_names(e.type(), ns);
+}
+
+
+static void
+collect_names(Term const& t, Name_list& ns)
+{
+  if (Type const* t1 = as<Type>(&t))
+    collect_names(*t1, ns);
+  else if (Expr const* e = as<Expr>(&t))
+    collect_names(*e, ns);
+}
+
+
+// -------------------------------------------------------------------------- //
+// Satisfaction
+
 // To satisfy a concept check, we must instantiate that
 // concept with the given arguments.
 inline bool
-satisfy_concept(Context& cxt, Concept_cons& c)
+satisfy_concept(Context& cxt, Concept_cons& c, Name_list& ns)
 {
-  return is_satisfied(cxt, expand(cxt, c));
+  ns.push_back(&c.declaration().name());
+  for (Term const& t : c.arguments())
+    collect_names(t, ns);
+  return is_satisfied(cxt, expand(cxt, c), ns);
 }
 
 
 // A predicate constraint is satisfied if its expression
 // evaluates to true.
 inline bool
-satisfy_predicate(Context& cxt, Predicate_cons& p)
+satisfy_predicate(Context& cxt, Predicate_cons& p, Name_list& ns)
 {
-  Value v = evaluate(p.expression());
+  collect_names(p.expression(), ns);
+  Value v = evaluate(cxt, p.expression());
   return v.get_boolean();
 }
 
@@ -37,37 +102,65 @@ satisfy_predicate(Context& cxt, Predicate_cons& p)
 // The right operand is not evaluated if the left operand is
 // not satisfied.
 inline bool
-satisfy_conjunction(Context& cxt, Conjunction_cons& c)
+satisfy_conjunction(Context& cxt, Conjunction_cons& c, Name_list& ns)
 {
-  return is_satisfied(cxt, c.left())
-      && is_satisfied(cxt, c.right());
+  return is_satisfied(cxt, c.left(), ns)
+      && is_satisfied(cxt, c.right(), ns);
 }
 
 
 // A disjunction is satsifed iff either operand is satisfied. The
 // right operand is not evaluated if the left operand is satisfied.
 inline bool
-satisfy_disjunction(Context& cxt, Disjunction_cons& c)
+satisfy_disjunction(Context& cxt, Disjunction_cons& c, Name_list& ns)
 {
-  return is_satisfied(cxt, c.left())
-      || is_satisfied(cxt, c.right());
+  return is_satisfied(cxt, c.left(), ns)
+      || is_satisfied(cxt, c.right(), ns);
 }
 
 
-// Determine if a constraint c is satisfied.
-bool
-is_satisfied(Context& cxt, Cons& c)
+// Determine if a constraint c is satisfied. The names on which the
+// result depends are added to ns.
+static bool
+satisfy(Context& cxt, Cons& c, Name_list& ns)
 {
   struct fn
   {
-    Context&      cxt;
+    Context&   cxt;
+    Name_list& ns;
     bool operator()(Cons& c)             { banjo_unhandled_case(c); }
-    bool operator()(Concept_cons& c)     { return satisfy_concept(cxt, c); }
-    bool operator()(Predicate_cons& c)   { return satisfy_predicate(cxt, c); }
-    bool operator()(Conjunction_cons& c) { return satisfy_conjunction(cxt, c); }
-    bool operator()(Disjunction_cons& c) { return satisfy_disjunction(cxt, c); }
+    bool operator()(Concept_cons& c)     { return satisfy_concept(cxt, c, ns); }
+    bool operator()(Predicate_cons& c)   { return satisfy_predicate(cxt, c, ns); }
+    bool operator()(Conjunction_cons& c) { return satisfy_conjunction(cxt, c, ns); }
+    bool operator()(Disjunction_cons& c) { return satisfy_disjunction(cxt, c, ns); }
   };
-  return apply(c, fn{cxt});
+  return apply(c, fn{cxt, ns});
+}
+
+
+// Determine if a constraint c is satisfied, adding the names on which
+// the result depends to ns. Constraints are canonical, so the result
+// is cached in the context. Cached results are discarded when new
+// declarations could change them (see declare()).
+static bool
+is_satisfied(Context& cxt, Cons& c, Name_list& ns)
+{
+  Satisfaction s;
+  if (!cxt.satisfied.find(&c, s)) {
+    s.result = satisfy(cxt, c, s.names);
+    cxt.satisfied.save(&c, s);
+  }
+  ns.insert(ns.end(), s.names.begin(), s.names.end());
+  return s.result;
+}
+
+
+// Determine if a constraint c is satisfied.
+bool
+is_satisfied(Context& cxt, Cons& c)
+{
+  Name_list ns;
+  return is_satisfied(cxt, c, ns);
 }
 
 
@@ -82,4 +175,45 @@ is_satisfied(Context& cxt, Expr& e)
 }
 
 
+// -------------------------------------------------------------------------- //
+// Satisfaction cache
+
+// Save the result of satisfying c, and index it by the names that it
+// depends on.
+void
+Satisfaction_cache::save(Cons const* c, Satisfaction const& s)
+{
+  std::lock_guard<std::mutex> lock(sync);
+  Satisfaction& s1 = map[c] = s;
+  std::sort(s1.names.begin(), s1.names.end());
+  s1.names.erase(std::unique(s1.names.begin(), s1.names.end()), s1.names.end());
+  for (Name const* n : s1.names)
+    users[n].push_back(c);
+}
+
+
+// Discard the results that depend on the name n.
+void
+Satisfaction_cache::invalidate(Name const& n)
+{
+  std::lock_guard<std::mutex> lock(sync);
+  auto iter = users.find(&n);
+  if (iter == users.end())
+    return;
+  for (Cons const* c : iter->second)
+    map.erase(c);
+  users.erase(iter);
+}
+
+
+// Discard all results.
+void
+Satisfaction_cache::clear()
+{
+  std::lock_guard<std::mutex> lock(sync);
+  map.clear();
+  users.clear();
+}
+
+
 } // namespace banjo
@@ -0,0 +1,276 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "scan.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#  define BANJO_SCAN_X86 1
+#endif
+
+
+namespace banjo
+{
+
+// -------------------------------------------------------------------------- //
+// Scalar scanners
+
+namespace
+{
+
+inline bool
+is_space_char(char c)
+{
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+
+inline bool
+is_identifier_char(char c)
+{
+  return (c >= 'a' && c <= 'z')
+      || (c >= 'A' && c <= 'Z')
+      || (c >= '0' && c <= '9')
+      || c == '_';
+}
+
+
+inline bool
+is_digit_char(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+
+char const*
+scalar_space(char const* first, char const* last)
+{
+  while (first != last && is_space_char(*first))
+    ++first;
+  return first;
+}
+
+
+char const*
+scalar_identifier(char const* first, char const* last)
+{
+  while (first != last && is_identifier_char(*first))
+    ++first;
+  return first;
+}
+
+
+char const*
+scalar_digits(char const* first, char const* last)
+{
+  while (first != last && is_digit_char(*first))
+    ++first;
+  return first;
+}
+
+
+char const*
+scalar_line(char const* first, char const* last)
+{
+  while (first != last && *first != '\n')
+    ++first;
+  return first;
+}
+
+
+Scanner_set const scalar_scanners = {
+  "scalar",
+  scalar_space,
+  scalar_identifier,
+  scalar_digits,
+  scalar_line
+};
+
+
+// -------------------------------------------------------------------------- //
+// SSE2 scanners
+//
+// Each block of 16 characters is classified into a bit mask of the
+// characters in the class. The run ends at the first zero bit. The
+// tail of the input is handled by the scalar scanner.
+//
+// Note that comparisons are signed, so characters outside the ASCII
+// range are never in any class.
+
+#if BANJO_SCAN_X86
+
+__attribute__((target("sse2"))) inline __m128i
+sse2_in_range(__m128i c, char lo, char hi)
+{
+  return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(lo - 1)),
+                       _mm_cmplt_epi8(c, _mm_set1_epi8(hi + 1)));
+}
+
+
+__attribute__((target("sse2"))) inline __m128i
+sse2_space(__m128i c)
+{
+  return _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')),
+                      sse2_in_range(c, '\t', '\r'));
+}
+
+
+__attribute__((target("sse2"))) inline __m128i
+sse2_identifier(__m128i c)
+{
+  __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+  __m128i alpha = sse2_in_range(lower, 'a', 'z');
+  __m128i digit = sse2_in_range(c, '0', '9');
+  __m128i under = _mm_cmpeq_epi8(c, _mm_set1_epi8('_'));
+  return _mm_or_si128(_mm_or_si128(alpha, digit), under);
+}
+
+
+__attribute__((target("sse2"))) inline __m128i
+sse2_digits(__m128i c)
+{
+  return sse2_in_range(c, '0', '9');
+}
+
+
+__attribute__((target("sse2"))) inline __m128i
+sse2_not_newline(__m128i c)
+{
+  return _mm_xor_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('\n')),
+                       _mm_set1_epi8(-1));
+}
+
+
+// Scan the longest run of characters in the class computed by F,
+// finishing with the scalar scanner S.
+template<__m128i (*F)(__m128i), char const* (*S)(char const*, char const*)>
+__attribute__((target("sse2"))) char const*
+sse2_scan(char const* first, char const* last)
+{
+  while (last - first >= 16) {
+    __m128i c = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+    unsigned m = ~unsigned(_mm_movemask_epi8(F(c))) & 0xffff;
+    if (m)
+      return first + __builtin_ctz(m);
+    first += 16;
+  }
+  return S(first, last);
+}
+
+
+Scanner_set const sse2_scanners = {
+  "sse2",
+  sse2_scan<sse2_space, scalar_space>,
+  sse2_scan<sse2_identifier, scalar_identifier>,
+  sse2_scan<sse2_digits, scalar_digits>,
+  sse2_scan<sse2_not_newline, scalar_line>
+};
+
+
+// -------------------------------------------------------------------------- //
+// AVX2 scanners
+//
+// These are the same as the SSE2 scanners, but classify blocks of
+// 32 characters.
+
+__attribute__((target("avx2"))) inline __m256i
+avx2_in_range(__m256i c, char lo, char hi)
+{
+  return _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8(lo - 1)),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), c));
+}
+
+
+__attribute__((target("avx2"))) inline __m256i
+avx2_space(__m256i c)
+{
+  return _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')),
+                         avx2_in_range(c, '\t', '\r'));
+}
+
+
+__attribute__((target("avx2"))) inline __m256i
+avx2_identifier(__m256i c)
+{
+  __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+  __m256i alpha = avx2_in_range(lower, 'a', 'z');
+  __m256i digit = avx2_in_range(c, '0', '9');
+  __m256i under = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_'));
+  return _mm256_or_si256(_mm256_or_si256(alpha, digit), under);
+}
+
+
+__attribute__((target("avx2"))) inline __m256i
+avx2_digits(__m256i c)
+{
+  return avx2_in_range(c, '0', '9');
+}
+
+
+__attribute__((target("avx2"))) inline __m256i
+avx2_not_newline(__m256i c)
+{
+  return _mm256_xor_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n')),
+                          _mm256_set1_epi8(-1));
+}
+
+
+template<__m256i (*F)(__m256i), char const* (*S)(char const*, char const*)>
+__attribute__((target("avx2"))) char const*
+avx2_scan(char const* first, char const* last)
+{
+  while (last - first >= 32) {
+    __m256i c = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first));
+    unsigned m = ~unsigned(_mm256_movemask_epi8(F(c)));
+    if (m)
+      return first + __builtin_ctz(m);
+    first += 32;
+  }
+  return S(first, last);
+}
+
+
+Scanner_set const avx2_scanners = {
+  "avx2",
+  avx2_scan<avx2_space, sse2_scan<sse2_space, scalar_space>>,
+  avx2_scan<avx2_identifier, sse2_scan<sse2_identifier, scalar_identifier>>,
+  avx2_scan<avx2_digits, sse2_scan<sse2_digits, scalar_digits>>,
+  avx2_scan<avx2_not_newline, sse2_scan<sse2_not_newline, scalar_line>>
+};
+
+#endif
+
+
+// Select the best scanners for the host processor.
+Scanner_set const&
+select_scanners()
+{
+#if BANJO_SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return avx2_scanners;
+  if (__builtin_cpu_supports("sse2"))
+    return sse2_scanners;
+#endif
+  return scalar_scanners;
+}
+
+} // namespace
+
+
+Scanner_set const&
+get_scanners()
+{
+  static Scanner_set const& s = select_scanners();
+  return s;
+}
+
+
+Scanner_set const&
+get_scalar_scanners()
+{
+  return scalar_scanners;
+}
+
+
+} // namespace banjo
@@ -0,0 +1,77 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_SCAN_HPP
+#define BANJO_SCAN_HPP
+
+// This module provides fast scanners for the runs of characters that
+// dominate lexical analysis: whitespace, identifiers, digits, and the
+// text of line comments. Each scanner returns a pointer past the
+// longest prefix of [first, last) in its character class.
+//
+// The scanners use AVX2 or SSE2 when available, with a scalar
+// fallback. The implementation is selected once, on first use.
+
+#include <cstddef>
+
+
+namespace banjo
+{
+
+// The set of scanners for one instruction set.
+struct Scanner_set
+{
+  char const* name;
+  char const* (*space)(char const*, char const*);
+  char const* (*identifier)(char const*, char const*);
+  char const* (*digits)(char const*, char const*);
+  char const* (*line)(char const*, char const*);
+};
+
+
+// Returns the scanners best suited to the host processor.
+Scanner_set const& get_scanners();
+
+// Returns the portable scalar scanners.
+Scanner_set const& get_scalar_scanners();
+
+
+// Returns a pointer past the whitespace at the start of [first, last).
+inline char const*
+scan_space(char const* first, char const* last)
+{
+  return get_scanners().space(first, last);
+}
+
+
+// Returns a pointer past the identifier characters (letters, digits
+// and underscores) at the start of [first, last).
+inline char const*
+scan_identifier(char const* first, char const* last)
+{
+  return get_scanners().identifier(first, last);
+}
+
+
+// Returns a pointer past the decimal digits at the start of
+// [first, last).
+inline char const*
+scan_digits(char const* first, char const* last)
+{
+  return get_scanners().digits(first, last);
+}
+
+
+// Returns a pointer to the first newline in [first, last), or last
+// if there is none.
+inline char const*
+scan_line(char const* first, char const* last)
+{
+  return get_scanners().line(first, last);
+}
+
+
+} // namespace banjo
+
+
+#endif
@@ -3,21 +3,140 @@
 
 #include "scope.hpp"
 #include "ast.hpp"
+#include "context.hpp"
 
 
 namespace banjo
 {
 
-// For convenience.
-using Binding = Scope::Binding;
+constexpr std::size_t Scope::generation_count;
+std::atomic<std::size_t> Scope::generations[Scope::generation_count];
+
+
+Local_state const*
+current_worker()
+{
+  return Context::worker;
+}
+
+
+constexpr std::size_t Binding_table::min_size;
+
+
+// Double the number of slots and reinsert the occupied entries. The
+// first insertion allocates the minimum number of slots.
+void
+Binding_table::grow()
+{
+  std::vector<Entry> old(std::max(slots.size() * 2, min_size));
+  old.swap(slots);
+  std::size_t mask = slots.size() - 1;
+  for (Entry& e : old) {
+    if (!e.sym)
+      continue;
+    std::size_t i = slot_index(e.sym, slots.size());
+    while (slots[i].sym)
+      i = (i + 1) & mask;
+    slots[i] = e;
+  }
+}
 
 
 // Register a name binding for the declaration `d`.
-Binding&
+Overload_set&
 Scope::bind(Decl& d)
 {
   return bind(d.name(), d);
 }
 
 
+// Bind n to `d` in this scope.
+//
+// Note that the addition of declarations to an overload set
+// must be handled by semantic rules.
+//
+// If scopes have been nested in this one, they may have cached a
+// binding of n in an enclosing scope, so the generation of n is
+// advanced to invalidate those entries. Bindings in the outermost
+// scope never hide another binding. Only simple ids are cached.
+Overload_set&
+Scope::bind(Name const& n, Decl& d)
+{
+  lingo_assert(count(n) == 0);
+  if (Simple_id const* id = as<Simple_id>(&n)) {
+    if (parent && nested.load(std::memory_order_relaxed))
+      ++generation(&id->symbol());
+    sets.emplace_front(d);
+    Binding_table::Entry& e = table.insert(&id->symbol());
+    e.ovl = &sets.front();
+    e.local = true;
+    return sets.front();
+  }
+  auto ins = names.insert({&n, {d}});
+  return ins.first->second;
+}
+
+
+// Returns the binding for n, if any.
+Overload_set const*
+Scope::lookup(Name const& n) const
+{
+  return const_cast<Scope*>(this)->lookup(n);
+}
+
+
+Overload_set*
+Scope::lookup(Name const& n)
+{
+  if (Simple_id const* id = as<Simple_id>(&n)) {
+    Binding_table::Entry* e = table.find(&id->symbol());
+    return e && e->local ? e->ovl : nullptr;
+  }
+  auto iter = names.find(&n);
+  if (iter != names.end())
+    return &iter->second;
+  else
+    return nullptr;
+}
+
+
+// Search this scope and then each enclosing scope for a binding of
+// n. For simple ids, the result is cached in this scope until the
+// generation of the symbol changes. Only the scope in which the search starts is
+// updated, and only if it is private to the current thread. Shared
+// scopes are only read while workers are active.
+Overload_set*
+Scope::find(Name const& n)
+{
+  Simple_id const* id = as<Simple_id>(&n);
+  if (!id) {
+    for (Scope* p = this; p; p = p->parent) {
+      if (Overload_set* ovl = p->lookup(n))
+        return ovl;
+    }
+    return nullptr;
+  }
+
+  Symbol const* sym = &id->symbol();
+  std::size_t gen = generation(sym).load(std::memory_order_relaxed);
+  if (Binding_table::Entry* e = table.find(sym)) {
+    if (e->local || e->gen == gen)
+      return e->ovl;
+  }
+
+  Overload_set* ovl = nullptr;
+  for (Scope* p = parent; p && !ovl; p = p->parent) {
+    Binding_table::Entry* e = p->table.find(sym);
+    if (e && e->local)
+      ovl = e->ovl;
+  }
+  if (ovl && parent && is_private()) {
+    Binding_table::Entry& e = table.insert(sym);
+    e.ovl = ovl;
+    e.gen = gen;
+  }
+  return ovl;
+}
+
+
 } // namespace banjo
@@ -8,10 +8,24 @@
 #include "language.hpp"
 #include "overload.hpp"
 
+#include <atomic>
+#include <cstdint>
+#include <forward_list>
+#include <vector>
+
 
 namespace banjo
 {
 
+struct Local_state;
+
+
+// Returns the state of the current worker thread, or nullptr if
+// definitions are not being elaborated concurrently (see
+// Context::worker).
+Local_state const* current_worker();
+
+
 // -------------------------------------------------------------------------- //
 // Scope definitions
 
@@ -20,34 +34,140 @@ namespace banjo
 using Name_map = std::unordered_map<Name const*, Overload_set, Name_hash, Name_eq>;
 
 
+// Holds the overload sets bound in a binding table. Sets do not move
+// when others are added, and an empty list does not allocate.
+using Overload_list = std::forward_list<Overload_set>;
+
+
+// A flat, open-addressed hash table that maps symbols to overload
+// sets. Keys are compared by address, which is sufficient because
+// symbols are interned. Slots are allocated on the first insertion,
+// so scopes that bind nothing do not allocate.
+//
+// An entry is either a binding in the owning scope or the cached
+// result of an unqualified lookup through the enclosing scopes. A
+// cached entry is valid only as long as the generation of its symbol
+// in which it was found (see Scope::generation).
+struct Binding_table
+{
+  struct Entry
+  {
+    Symbol const* sym;   // The key, or null if the slot is empty
+    Overload_set* ovl;   // The innermost binding of sym
+    std::size_t   gen;   // The generation of a cached entry
+    bool          local; // True if sym is bound in this scope
+  };
+
+  static constexpr std::size_t min_size = 8;
+
+  Binding_table()
+    : count(0)
+  { }
+
+  Entry* find(Symbol const*);
+  Entry& insert(Symbol const*);
+
+  std::size_t size() const { return count; }
+
+  void grow();
+
+  std::vector<Entry> slots; // A power of 2 number of slots
+  std::size_t        count; // The number of occupied slots
+};
+
+
+// Returns the slot index for sym in a table of n slots.
+inline std::size_t
+slot_index(Symbol const* sym, std::size_t n)
+{
+  std::uint64_t h = reinterpret_cast<std::uintptr_t>(sym) >> 3;
+  return (h * 0x9e3779b97f4a7c15ull >> 32) & (n - 1);
+}
+
+
+// Returns the entry for sym, or nullptr if there is none.
+inline Binding_table::Entry*
+Binding_table::find(Symbol const* sym)
+{
+  if (slots.empty())
+    return nullptr;
+  std::size_t mask = slots.size() - 1;
+  for (std::size_t i = slot_index(sym, slots.size()); ; i = (i + 1) & mask) {
+    Entry& e = slots[i];
+    if (e.sym == sym)
+      return &e;
+    if (!e.sym)
+      return nullptr;
+  }
+}
+
+
+// Returns the entry for sym, creating an empty one if needed. The
+// reference is invalidated by the next insertion.
+inline Binding_table::Entry&
+Binding_table::insert(Symbol const* sym)
+{
+  if (4 * (count + 1) > 3 * slots.size())
+    grow();
+  std::size_t mask = slots.size() - 1;
+  for (std::size_t i = slot_index(sym, slots.size()); ; i = (i + 1) & mask) {
+    Entry& e = slots[i];
+    if (e.sym == sym)
+      return e;
+    if (!e.sym) {
+      ++count;
+      e = {sym, nullptr, 0, false};
+      return e;
+    }
+  }
+}
+
+
 // A scope defines a maximal lexical region of text where an
 // entity may be referred to without qualification. A scope can
 // be (but is not always) associated with a declaration.
 //
 // The scope class also defines a region of text where a dependent
 // expression may occur.
+//
+// Simple ids are bound by symbol in a flat table, which also caches
+// the innermost binding of each symbol found through the enclosing
+// scopes. Nested lookups of the same name are then a single probe.
+// Other names are bound in a map keyed on their structure.
+//
+// While definitions are elaborated concurrently, scopes created before
+// the workers started (e.g., the translation scope) are shared between
+// them. Lookups are cached only in scopes created by the current
+// worker, or when there are no workers.
 struct Scope
 {
-  using Binding = Name_map::value_type;
+  // Construct the outermost scope.
+  Scope()
+    : parent(nullptr), decl(nullptr), owner(current_worker()), nested(false)
+  { }
 
   // Construct a new scope with the given parent. This is
   // used to create scopes that are not affiliated with a
   // declaration.
   Scope(Scope& p)
-    : parent(&p), decl(nullptr)
-  { }
+    : parent(&p), decl(nullptr), owner(current_worker()), nested(false)
+  {
+    p.nest();
+  }
 
   // Construct a scope for the given declaration, but with
   // no enclosing scope. 
   Scope(Decl& d)
-    : parent(nullptr), decl(&d)
+    : parent(nullptr), decl(&d), owner(current_worker()), nested(false)
   { }
 
   // Construct a scope having the given parent and affiliated with
   // the declaration.
   Scope(Scope& p, Decl& d)
-    : parent(&p), decl(&d)
-  { }
+    : parent(&p), decl(&d), owner(current_worker()), nested(false)
+  {
+    p.nest();
+  }
 
   virtual ~Scope() { }
 
@@ -66,59 +186,58 @@ struct Scope
   // is undefined if a name binding already exists.
   //
   // TODO: Assert that `n` is a form of simple id.
-  Binding& bind(Decl& d);
-  Binding& bind(Name const&, Decl&);
+  Overload_set& bind(Decl& d);
+  Overload_set& bind(Name const&, Decl&);
 
-  // Return the binding for the given symbol, or nullptr
-  // if no such binding exists.
+  // Return the binding for the given name in this scope, or
+  // nullptr if no such binding exists.
   Overload_set const* lookup(Name const& n) const;
   Overload_set*       lookup(Name const& n);
 
-  // Returns 1 if the name is bound and 0 otherwise.
-  std::size_t count(Name const& n) const { return names.count(&n); }
+  // Return the innermost binding for the given name in this
+  // scope or its enclosing scopes, or nullptr if no such binding
+  // exists.
+  Overload_set* find(Name const& n);
 
-  Scope*   parent;
-  Decl*    decl;
-  Name_map names;
+  // Returns 1 if the name is bound and 0 otherwise.
+  std::size_t count(Name const& n) const { return lookup(n) != nullptr; }
+
+  // Returns true if the current thread may cache lookups in this
+  // scope.
+  bool is_private() const { return owner == current_worker(); }
+
+  // Record that a scope has been nested in this one. The flag is
+  // only written once, since shared scopes are nested concurrently.
+  void nest()
+  {
+    if (!nested.load(std::memory_order_relaxed))
+      nested.store(true, std::memory_order_relaxed);
+  }
+
+  Scope*                   parent;
+  Decl*                    decl;
+  Local_state const*       owner;  // The worker that created the scope, if any
+  Binding_table            table;  // Bindings of simple ids
+  Name_map                 names;  // Bindings of other names
+  Overload_list            sets;   // Overload sets in the table
+  std::atomic<bool>        nested; // True if scopes have been nested in this one
+
+  // Generations of symbols. The generation of a symbol is incremented
+  // when it is bound in a scope that may have nested scopes, which may
+  // have cached a binding that the new one hides. Symbols are hashed
+  // onto a fixed number of counters, so binding a symbol invalidates
+  // only the cached lookups of symbols that share its counter.
+  static constexpr std::size_t generation_count = 1024;
+
+  static std::atomic<std::size_t>& generation(Symbol const* sym)
+  {
+    return generations[slot_index(sym, generation_count)];
+  }
+
+  static std::atomic<std::size_t> generations[generation_count];
 };
 
 
-// Bind n to `d` in this scope.
-//
-// Note that the addition of declarations to an overload set
-// must be handled by semantic rules.
-inline Scope::Binding&
-Scope::bind(Name const& n, Decl& d)
-{
-  lingo_assert(count(n) == 0);
-  auto ins = names.insert({&n, {d}});
-  return *ins.first;
-}
-
-
-// Returns the binding for n, if any.
-inline Overload_set const*
-Scope::lookup(Name const& n) const
-{
-  auto iter = names.find(&n);
-  if (iter != names.end())
-    return &iter->second;
-  else
-    return nullptr;
-}
-
-
-inline Overload_set*
-Scope::lookup(Name const& n)
-{
-  auto iter = names.find(&n);
-  if (iter != names.end())
-    return &iter->second;
-  else
-    return nullptr;
-}
-
-
 } // namespace banjo
 
 
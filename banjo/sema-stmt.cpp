@@ -102,8 +102,7 @@ Parser::on_expression_statement(Expr& d)
 Stmt&
 Parser::on_unparsed_statement(Token_seq&& toks)
 {
-  // FIXME: Use the builder.
-  return *new Unparsed_stmt(std::move(toks));
+  return cxt.make<Unparsed_stmt>(std::move(toks));
 }
 
 
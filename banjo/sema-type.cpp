@@ -130,8 +130,7 @@ Parser::on_pack_type(Type& t)
 Type&
 Parser::on_unparsed_type(Token_seq&& toks)
 {
-  // FIXME: Use a factory method.
-  return *new Unparsed_type(std::move(toks));
+  return cxt.make<Unparsed_type>(std::move(toks));
 }
 
 
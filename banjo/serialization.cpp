@@ -0,0 +1,2300 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "serialization.hpp"
+#include "ast.hpp"
+#include "context.hpp"
+#include "evaluation.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+
+
+namespace banjo
+{
+
+using Offset = Ast_writer::Offset;
+
+
+// -------------------------------------------------------------------------- //
+// Node tags
+
+namespace
+{
+
+// Every kind of node is identified by a tag. Tags are assigned in the
+// order that nodes are listed in the definition files, so adding a
+// node changes the format version.
+enum Node_tag : std::uint32_t
+{
+  no_tag,
+#define define_node(Node) Node##_tag,
+#include "ast-name.def"
+#include "ast-type.def"
+#include "ast-expr.def"
+#include "ast-req.def"
+#include "ast-stmt.def"
+#include "ast-decl.def"
+#include "ast-def.def"
+#include "ast-cons.def"
+#undef define_node
+};
+
+
+#define define_node(Node) \
+  inline Node_tag node_tag(Node const&) { return Node##_tag; }
+#include "ast-name.def"
+#include "ast-type.def"
+#include "ast-expr.def"
+#include "ast-req.def"
+#include "ast-stmt.def"
+#include "ast-decl.def"
+#include "ast-def.def"
+#include "ast-cons.def"
+#undef define_node
+
+
+// The file starts with these bytes, followed by the version.
+char const magic[8] = {'b', 'a', 'n', 'j', 'o', 'a', 's', 't'};
+std::uint32_t const version = 1;
+
+// The offsets of header fields.
+Offset const version_field = 8;
+Offset const root_field    = 12;
+Offset const index_field   = 16;
+Offset const symtab_field  = 20;
+Offset const header_size   = 24;
+
+
+// Encode a word in little-endian order.
+inline void
+encode(char* p, std::uint32_t w)
+{
+  p[0] = char(w);
+  p[1] = char(w >> 8);
+  p[2] = char(w >> 16);
+  p[3] = char(w >> 24);
+}
+
+
+// Decode a word in little-endian order.
+inline std::uint32_t
+decode(char const* p)
+{
+  unsigned char const* q = reinterpret_cast<unsigned char const*>(p);
+  return std::uint32_t(q[0])
+       | std::uint32_t(q[1]) << 8
+       | std::uint32_t(q[2]) << 16
+       | std::uint32_t(q[3]) << 24;
+}
+
+
+// Returns the number of bytes used by a string of n characters. Strings
+// are padded to a word boundary.
+inline std::uint32_t
+padded(std::uint32_t n)
+{
+  return (n + 3) & ~3u;
+}
+
+} // namespace
+
+
+// -------------------------------------------------------------------------- //
+// Writing
+
+// Append a word to the buffer and returns its offset.
+Offset
+Ast_writer::put(std::uint32_t w)
+{
+  Offset off = buf.size();
+  buf.resize(off + 4);
+  encode(&buf[off], w);
+  return off;
+}
+
+
+// Append a reference to t. The offset is patched once t has been
+// written. A null reference is written as 0.
+void
+Ast_writer::put_ref(Term const* t)
+{
+  Offset off = put(0);
+  if (t)
+    fixups.emplace_back(off, t);
+}
+
+
+// Append the index of the symbol in the symbol table.
+void
+Ast_writer::put_symbol(Symbol const& sym)
+{
+  auto iter = symbols.find(&sym);
+  if (iter == symbols.end()) {
+    iter = symbols.emplace(&sym, symtab.size()).first;
+    symtab.push_back(&sym);
+  }
+  put(iter->second);
+}
+
+
+// Append the length of the string and its characters.
+void
+Ast_writer::put_string(String const& s)
+{
+  put(s.size());
+  Offset off = buf.size();
+  buf.resize(off + padded(s.size()));
+  std::copy(s.begin(), s.end(), buf.begin() + off);
+}
+
+
+// Append a sequence of tokens as the indexes of their symbols.
+void
+Ast_writer::put_tokens(Token_seq const& toks)
+{
+  put(toks.size());
+  for (Token const& tok : toks)
+    put_symbol(*tok.symbol());
+}
+
+
+void
+Ast_writer::put_index(Index x)
+{
+  put(x.depth());
+  put(x.offset());
+}
+
+
+// Overwrite the word at the given offset.
+void
+Ast_writer::patch(Offset off, std::uint32_t w)
+{
+  encode(&buf[off], w);
+}
+
+
+namespace
+{
+
+// Names
+
+inline void
+write_fields(Ast_writer& w, Simple_id const& n)
+{
+  w.put_symbol(n.symbol());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Global_id const& n)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Placeholder_id const& n)
+{
+  w.put(n.number());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Operator_id const& n)
+{
+  w.put(n.kind());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Conversion_id const& n)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Literal_id const& n)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Destructor_id const& n)
+{
+  w.put_ref(n.first);
+}
+
+
+inline void
+write_fields(Ast_writer& w, Template_id const& n)
+{
+  w.put_ref(n.decl);
+  w.put_list(n.arguments());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Concept_id const& n)
+{
+  w.put_ref(n.decl);
+  w.put_list(n.arguments());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Qualified_id const& n)
+{
+  w.put_ref(n.decl);
+  w.put_ref(n.id);
+}
+
+
+// Types
+
+inline void
+write_fields(Ast_writer& w, Void_type const& t)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Boolean_type const& t)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Byte_type const& t)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Integer_type const& t)
+{
+  w.put(t.sign());
+  w.put(t.precision());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Float_type const& t)
+{
+  w.put(t.precision());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Function_type const& t)
+{
+  w.put_list(t.parameter_types());
+  w.put_ref(t.return_type());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Unary_type const& t)
+{
+  w.put_ref(t.type());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Qualified_type const& t)
+{
+  w.put_ref(t.type());
+  w.put(t.qualifiers());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Array_type const& t)
+{
+  w.put_ref(t.type());
+  w.put_ref(t.extent());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Dynarray_type const& t)
+{
+  w.put_ref(t.type());
+  w.put_ref(t.extent());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Tuple_type const& t)
+{
+  w.put_list(t.type_list());
+}
+
+
+// Note that the parameter and return types of coroutine types are
+// never assigned, so only the declaration is saved.
+inline void
+write_fields(Ast_writer& w, Declared_type const& t)
+{
+  w.put_ref(t.decl_);
+}
+
+
+// A decltype type does not record its operand, and the builder cannot
+// create one (see get_decltype_type), so it could not be read back as
+// a canonical type.
+inline void
+write_fields(Ast_writer& w, Decltype_type const& t)
+{
+  throw Limitation_error("cannot serialize decltype types");
+}
+
+
+inline void
+write_fields(Ast_writer& w, Type_type const& t)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Unparsed_type const& t)
+{
+  w.put_tokens(t.tokens());
+}
+
+
+// Expressions
+//
+// The type of every expression is written first. It may be null.
+
+inline void
+write_fields(Ast_writer& w, Boolean_expr const& e)
+{
+  w.put_ref(e.type_);
+  w.put(e.value());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Integer_expr const& e)
+{
+  Integer_type const* t = as<Integer_type>(e.type_);
+  bool sign = t ? t->is_signed() : true;
+  w.put_ref(e.type_);
+  w.put_string(e.value().impl().toString(10, sign));
+}
+
+
+inline void
+write_fields(Ast_writer& w, Real_expr const& e)
+{
+  throw Limitation_error("cannot serialize real literals");
+}
+
+
+inline void
+write_fields(Ast_writer& w, Tuple_expr const& e)
+{
+  w.put_ref(e.type_);
+  w.put_list(e.elements());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Decl_expr const& e)
+{
+  w.put_ref(e.type_);
+  w.put_ref(e.id());
+  w.put_ref(e.declaration());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Overload_expr const& e)
+{
+  w.put_ref(e.type_);
+  w.put_ref(e.id());
+  w.put_list(e.declarations());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Dot_expr const& e)
+{
+  w.put_ref(e.type_);
+  w.put_ref(e.object());
+  w.put_ref(e.member());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Nested_decl_expr const& e)
+{
+  w.put_ref(e.type_);
+  w.put_ref(e.object());
+  w.put_ref(e.member());
+  w.put_ref(e.declaration());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Unary_expr const& e)
+{
+  w.put_ref(e.type_);
+  w.put_ref(e.operand());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Binary_expr const& e)
+{
+  w.put_ref(e.type_);
+  w.put_ref(e.left());
+  w.put_ref(e.right());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Call_expr const& e)
+{
+  w.put_ref(e.type_);
+  w.put_ref(e.function());
+  w.put_list(e.arguments());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Check_expr const& e)
+{
+  w.put_ref(e.type_);
+  w.put_ref(e.con);
+  w.put_list(e.arguments());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Requires_expr const& e)
+{
+  w.put_ref(e.type_);
+  w.put_list(e.template_parameters());
+  w.put_list(e.normal_parameters());
+  w.put_list(e.requirements());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Synthetic_expr const& e)
+{
+  w.put_ref(e.type_);
+  w.put_ref(e.declaration());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Unparsed_expr const& e)
+{
+  w.put_ref(e.type_);
+  w.put_tokens(e.tokens());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Conv const& e)
+{
+  w.put_ref(e.type_);
+  w.put_ref(e.source());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Trivial_init const& e)
+{
+  w.put_ref(e.type_);
+}
+
+
+inline void
+write_fields(Ast_writer& w, Copy_init const& e)
+{
+  w.put_ref(e.type_);
+  w.put_ref(e.expression());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Bind_init const& e)
+{
+  w.put_ref(e.type_);
+  w.put_ref(e.expression());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Direct_init const& e)
+{
+  w.put_ref(e.type_);
+  w.put_ref(e.consructor());
+  w.put_list(e.arguments());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Aggregate_init const& e)
+{
+  w.put_ref(e.type_);
+  w.put_list(e.initializers());
+}
+
+
+// Requirements
+
+inline void
+write_fields(Ast_writer& w, Type_req const& r)
+{
+  w.put_ref(r.type());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Syntactic_req const& r)
+{
+  w.put_ref(r.expression());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Semantic_req const& r)
+{
+  w.put_ref(r.decl);
+}
+
+
+inline void
+write_fields(Ast_writer& w, Expression_req const& r)
+{
+  w.put_ref(r.expr);
+}
+
+
+inline void
+write_fields(Ast_writer& w, Basic_req const& r)
+{
+  w.put_ref(r.expression());
+  w.put_ref(r.type());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Conversion_req const& r)
+{
+  w.put_ref(r.expression());
+  w.put_ref(r.type());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Deduction_req const& r)
+{
+  w.put_ref(r.expr);
+  w.put_ref(r.ty);
+}
+
+
+// Statements
+
+inline void
+write_fields(Ast_writer& w, Empty_stmt const& s)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Multiple_stmt const& s)
+{
+  w.put_list(s.statements());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Expression_stmt const& s)
+{
+  w.put_ref(s.expression());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Declaration_stmt const& s)
+{
+  w.put_ref(s.declaration());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Return_stmt const& s)
+{
+  w.put_ref(s.expression());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Yield_stmt const& s)
+{
+  w.put_ref(s.expression());
+}
+
+
+inline void
+write_fields(Ast_writer& w, If_then_stmt const& s)
+{
+  w.put_ref(s.condition());
+  w.put_ref(s.true_branch());
+}
+
+
+inline void
+write_fields(Ast_writer& w, If_else_stmt const& s)
+{
+  w.put_ref(s.condition());
+  w.put_ref(s.true_branch());
+  w.put_ref(s.false_branch());
+}
+
+
+inline void
+write_fields(Ast_writer& w, While_stmt const& s)
+{
+  w.put_ref(s.condition());
+  w.put_ref(s.body());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Break_stmt const& s)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Continue_stmt const& s)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Unparsed_stmt const& s)
+{
+  w.put_tokens(s.tokens());
+}
+
+
+// Declarations
+//
+// Every declaration starts with its context, name, type, and
+// specifiers. The context and type may be null.
+
+inline void
+write_header(Ast_writer& w, Decl const& d)
+{
+  w.put_ref(d.cxt_);
+  w.put_ref(d.name_);
+  w.put_ref(d.type_);
+  w.put(d.specifiers());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Super_decl const& d)
+{
+  write_header(w, d);
+  w.put_ref(d.type());
+  w.put_ref(d.initializer());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Variable_decl const& d)
+{
+  write_header(w, d);
+  w.put_ref(d.initializer());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Function_decl const& d)
+{
+  write_header(w, d);
+  w.put_list(d.parameters());
+  w.put_ref(d.definition());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Class_decl const& d)
+{
+  write_header(w, d);
+  w.put_list(d.bases_);
+  w.put_list(d.derivatives_);
+  w.put_ref(d.definition());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Coroutine_decl const& d)
+{
+  write_header(w, d);
+  w.put_list(d.parameters());
+  w.put_ref(d.return_type());
+  w.put_ref(d.definition());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Concept_decl const& d)
+{
+  write_header(w, d);
+  w.put_list(d.parameters());
+  w.put_ref(d.def);
+}
+
+
+inline void
+write_fields(Ast_writer& w, Template_decl const& d)
+{
+  write_header(w, d);
+  w.put_list(d.parameters());
+  w.put_ref(d.parameterized_declaration());
+  w.put_ref(d.cons);
+}
+
+
+inline void
+write_fields(Ast_writer& w, Object_parm const& d)
+{
+  write_header(w, d);
+  w.put_index(d.index());
+  w.put_ref(d.init_);
+}
+
+
+inline void
+write_fields(Ast_writer& w, Value_parm const& d)
+{
+  write_header(w, d);
+  w.put_index(d.index());
+  w.put_ref(d.init_);
+}
+
+
+inline void
+write_fields(Ast_writer& w, Type_parm const& d)
+{
+  write_header(w, d);
+  w.put_index(d.index());
+  w.put_ref(d.def);
+}
+
+
+inline void
+write_fields(Ast_writer& w, Template_parm const& d)
+{
+  write_header(w, d);
+  w.put_index(d.index());
+  w.put_ref(d.temp);
+  w.put_ref(d.def);
+}
+
+
+// Definitions
+
+inline void
+write_fields(Ast_writer& w, Empty_def const& d)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Defaulted_def const& d)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Deleted_def const& d)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Expression_def const& d)
+{
+  w.put_ref(d.expression());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Function_def const& d)
+{
+  w.put_ref(d.statement());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Class_def const& d)
+{
+  w.put_ref(d.body());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Concept_def const& d)
+{
+  w.put_list(d.requirements());
+}
+
+
+// Constraints
+
+inline void
+write_fields(Ast_writer& w, Concept_cons const& c)
+{
+  w.put_ref(c.decl);
+  w.put_list(c.arguments());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Predicate_cons const& c)
+{
+  w.put_ref(c.expression());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Expression_cons const& c)
+{
+  w.put_ref(c.expression());
+  w.put_ref(c.type());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Type_cons const& c)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Conversion_cons const& c)
+{
+  w.put_ref(c.expression());
+  w.put_ref(c.type());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Deduction_cons const& c)
+{ }
+
+
+inline void
+write_fields(Ast_writer& w, Parameterized_cons const& c)
+{
+  w.put_list(c.variables());
+  w.put_ref(c.constraint());
+}
+
+
+inline void
+write_fields(Ast_writer& w, Binary_cons const& c)
+{
+  w.put_ref(c.left());
+  w.put_ref(c.right());
+}
+
+
+// Writes the tag and fields of a node.
+struct Write_node
+{
+  template<typename T>
+  void operator()(T const& t)
+  {
+    w.put(node_tag(t));
+    write_fields(w, t);
+  }
+
+  Ast_writer& w;
+};
+
+
+void
+write_node(Ast_writer& w, Term const& t)
+{
+  Write_node f{w};
+  if (Name const* n = as<Name>(&t))
+    return apply(*n, f);
+  if (Type const* ty = as<Type>(&t))
+    return apply(*ty, f);
+  if (Expr const* e = as<Expr>(&t))
+    return apply(*e, f);
+  if (Req const* r = as<Req>(&t))
+    return apply(*r, f);
+  if (Stmt const* s = as<Stmt>(&t))
+    return apply(*s, f);
+  if (Decl const* d = as<Decl>(&t))
+    return apply(*d, f);
+  if (Def const* d = as<Def>(&t))
+    return apply(*d, f);
+  if (Cons const* c = as<Cons>(&t))
+    return apply(*c, f);
+  lingo_unreachable();
+}
+
+} // namespace
+
+
+// Returns the offset of the record for t, writing the record if
+// needed. References within the record are resolved later.
+Offset
+Ast_writer::record(Term const& t)
+{
+  auto iter = offsets.find(&t);
+  if (iter != offsets.end())
+    return iter->second;
+  Offset off = buf.size();
+  offsets.emplace(&t, off);
+  write_node(*this, t);
+  return off;
+}
+
+
+// Returns the serialized form of the translation s.
+String
+Ast_writer::operator()(Stmt const& s)
+{
+  buf.assign(magic, sizeof(magic));
+  put(version);
+  put(0);
+  put(0);
+  put(0);
+
+  // Write the translation and every term reachable from it. Each
+  // record is written once, so shared terms (e.g., canonical types)
+  // are not duplicated.
+  patch(root_field, record(s));
+  while (!fixups.empty()) {
+    std::pair<Offset, Term const*> f = fixups.back();
+    fixups.pop_back();
+    patch(f.first, record(*f.second) - f.first);
+  }
+
+  // Index the top-level declarations with simple names.
+  std::vector<Decl const*> decls;
+  if (Multiple_stmt const* m = as<Multiple_stmt>(&s)) {
+    for (Stmt const& s1 : m->statements()) {
+      if (Declaration_stmt const* d = as<Declaration_stmt>(&s1))
+        if (is<Simple_id>(&d->declaration().name()))
+          decls.push_back(&d->declaration());
+    }
+  }
+  patch(index_field, put(decls.size()));
+  for (Decl const* d : decls) {
+    put_symbol(cast<Simple_id>(d->name()).symbol());
+    put(offsets.at(d));
+  }
+
+  // Write the symbol table as a list of offsets to strings.
+  patch(symtab_field, put(symtab.size()));
+  Offset first = buf.size();
+  for (std::size_t i = 0; i < symtab.size(); ++i)
+    put(0);
+  for (std::size_t i = 0; i < symtab.size(); ++i) {
+    patch(first + 4 * i, buf.size());
+    put_string(symtab[i]->spelling());
+  }
+
+  return std::move(buf);
+}
+
+
+// Returns the serialized form of the translation s.
+String
+save_ast(Stmt const& s)
+{
+  Ast_writer w;
+  return w(s);
+}
+
+
+// Save the serialized form of the translation s to the given file.
+// Returns false if the file cannot be written.
+bool
+save_ast(Stmt const& s, String const& path)
+{
+  String buf = save_ast(s);
+  std::ofstream os(path, std::ios::binary);
+  os.write(buf.data(), buf.size());
+  return bool(os);
+}
+
+
+// -------------------------------------------------------------------------- //
+// Reading
+
+// Initialize the reader, checking the header of the buffer.
+Ast_reader::Ast_reader(Context& c, String_view b)
+  : cxt(c), buf(b)
+{
+  if (buf.size() < header_size || !std::equal(magic, magic + 8, buf.begin()))
+    throw Translation_error("input is not a serialized AST");
+  if (buf.size() % 4)
+    throw Translation_error("malformed AST: truncated to {} bytes", buf.size());
+  if (word(version_field) != version)
+    throw Translation_error("unsupported AST version {}", word(version_field));
+  root = word(root_field);
+  index = word(index_field);
+  symtab = word(symtab_field);
+  syms.resize(word(symtab));
+}
+
+
+// Returns the word at the given offset.
+std::uint32_t
+Ast_reader::word(Offset off) const
+{
+  if (off > buf.size() || buf.size() - off < 4 || off % 4)
+    throw Translation_error("malformed AST: offset {} is out of bounds", off);
+  return decode(buf.begin() + off);
+}
+
+
+// Returns the offset referred to by the reference at the given
+// offset, or 0 if the reference is null.
+Ast_reader::Offset
+Ast_reader::target(Offset off) const
+{
+  std::uint32_t rel = word(off);
+  return rel ? off + rel : 0;
+}
+
+
+// Returns the string at the given offset.
+String
+Ast_reader::string(Offset off) const
+{
+  std::uint32_t n = word(off);
+  if (buf.size() - off - 4 < n)
+    throw Translation_error("malformed AST: string at offset {} is out of bounds", off);
+  char const* p = buf.begin() + off + 4;
+  return String(p, p + n);
+}
+
+
+// Returns the value of the integer spelled by s.
+static int
+integer(String const& s)
+{
+  char* end;
+  errno = 0;
+  long n = std::strtol(s.c_str(), &end, 10);
+  if (*end || errno == ERANGE || n < INT_MIN || n > INT_MAX)
+    throw Translation_error("malformed AST: invalid integer '{}'", s);
+  return n;
+}
+
+
+// Returns the n-th symbol in the symbol table. Spellings are interned
+// the first time they are read. Spellings that are not already known
+// are integers or identifiers.
+Symbol const&
+Ast_reader::symbol(std::uint32_t n)
+{
+  if (n >= syms.size())
+    throw Translation_error("malformed AST: symbol {} is out of bounds", n);
+  if (!syms[n]) {
+    String s = string(word(symtab + 4 + 4 * n));
+    Intern_table& tab = cxt.spellings();
+    Symbol const* sym = tab.get(s);
+    if (!sym && !s.empty() && std::isdigit((unsigned char)s[0]))
+      sym = tab.put_integer(s, integer(s));
+    else if (!sym)
+      sym = tab.put_identifier(s);
+    syms[n] = sym;
+  }
+  return *syms[n];
+}
+
+
+// Returns the term at the given offset, reading it if needed.
+Term&
+Ast_reader::node(Offset off)
+{
+  auto iter = nodes.find(off);
+  if (iter != nodes.end())
+    return *iter->second;
+
+  // Only declarations can be referred to before they are read.
+  if (std::find(active.begin(), active.end(), off) != active.end())
+    throw Translation_error("malformed AST: cyclic reference at offset {}", off);
+
+  active.push_back(off);
+  Term& t = read(off);
+  active.pop_back();
+  nodes[off] = &t;
+  return t;
+}
+
+
+// Read the fields that were deferred while reading terms. Frames are
+// not serialized, so they are allocated once the definitions of the
+// functions read have been linked.
+void
+Ast_reader::link()
+{
+  while (!pending.empty()) {
+    std::function<void()> f = std::move(pending.back());
+    pending.pop_back();
+    f();
+  }
+  for (Function_decl* f : frames)
+    allocate_frame(*f);
+  frames.clear();
+}
+
+
+// Returns the translation.
+Stmt&
+Ast_reader::translation()
+{
+  Stmt& s = get<Stmt>(root);
+  link();
+  return s;
+}
+
+
+// Returns the top-level declaration with the given name.
+Decl*
+Ast_reader::declaration(Symbol const& sym)
+{
+  std::uint32_t n = word(index);
+  for (std::uint32_t i = 0; i < n; ++i) {
+    Offset entry = index + 4 + 8 * i;
+    if (&symbol(word(entry)) == &sym) {
+      Decl& d = get<Decl>(word(entry + 4));
+      link();
+      return &d;
+    }
+  }
+  return nullptr;
+}
+
+
+namespace
+{
+
+// A cursor reads the fields of a record in order.
+struct Cursor
+{
+  Cursor(Ast_reader& r, Offset off)
+    : r(r), cxt(r.cxt), start(off), pos(off)
+  { }
+
+  std::uint32_t get();
+  Offset        ref();
+  Symbol const& symbol() { return r.symbol(get()); }
+  String        string();
+  Token_seq     tokens();
+  Index         index();
+  void          skip_list();
+
+  template<typename T>
+  T& node() { return r.get<T>(ref()); }
+
+  template<typename T>
+  T* node_opt() { return r.get_opt<T>(ref()); }
+
+  template<typename T>
+  List<T> list();
+
+  template<typename T, typename... Args>
+  T& make(Args&&... args) { return cxt.make<T>(std::forward<Args>(args)...); }
+
+  // Register the declaration so that it can be referred to by the
+  // terms that are read after it.
+  void declare(Decl& d) { r.nodes[start] = &d; }
+
+  Ast_reader& r;
+  Context&    cxt;
+  Offset      start;
+  Offset      pos;
+};
+
+
+inline std::uint32_t
+Cursor::get()
+{
+  std::uint32_t w = r.word(pos);
+  pos += 4;
+  return w;
+}
+
+
+inline Offset
+Cursor::ref()
+{
+  Offset off = r.target(pos);
+  pos += 4;
+  return off;
+}
+
+
+inline String
+Cursor::string()
+{
+  String s = r.string(pos);
+  pos += 4 + padded(s.size());
+  return s;
+}
+
+
+Token_seq
+Cursor::tokens()
+{
+  std::uint32_t n = get();
+  Token_seq toks;
+  for (std::uint32_t i = 0; i < n; ++i)
+    toks.push_back(Token(Location(), &symbol()));
+  return toks;
+}
+
+
+inline Index
+Cursor::index()
+{
+  int d = get();
+  int o = get();
+  return Index(d, o);
+}
+
+
+inline void
+Cursor::skip_list()
+{
+  std::uint32_t n = get();
+  pos += 4 * n;
+}
+
+
+template<typename T>
+List<T>
+Cursor::list()
+{
+  std::uint32_t n = get();
+  List<T> list;
+  for (std::uint32_t i = 0; i < n; ++i)
+    list.push_back(node<T>());
+  return list;
+}
+
+
+// Read the reference into p after the current term has been read.
+template<typename T>
+void
+defer(Cursor& c, T*& p)
+{
+  Offset off = c.ref();
+  Ast_reader& r = c.r;
+  p = nullptr;
+  if (off)
+    r.defer([&r, &p, off]() { p = &r.get<T>(off); });
+}
+
+
+// Read the list into l after the current term has been read.
+template<typename T>
+void
+defer(Cursor& c, List<T>& l)
+{
+  Offset off = c.pos;
+  Ast_reader& r = c.r;
+  c.skip_list();
+  r.defer([&r, &l, off]() {
+    Cursor c(r, off);
+    l = c.list<T>();
+  });
+}
+
+
+// The reader is selected by the (static) type of the node, which
+// is passed as a null pointer. When a group of nodes is read in the
+// same way, the reader takes a pointer to their common base.
+
+// Names
+
+template<typename T>
+T&
+read_term(Cursor& c, Simple_id*)
+{
+  return c.cxt.get_id(c.symbol());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Global_id*)
+{
+  return c.cxt.get_global_id();
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Placeholder_id*)
+{
+  int n = c.get();
+  return c.make<Placeholder_id>(n);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Operator_id*)
+{
+  return c.cxt.get_id(Operator_kind(c.get()));
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Conversion_id*)
+{
+  return c.make<Conversion_id>();
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Literal_id*)
+{
+  return c.make<Literal_id>();
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Destructor_id*)
+{
+  Destructor_id& n = c.make<Destructor_id>();
+  n.first = &c.node<Type>();
+  return n;
+}
+
+
+// Template-ids and concept-ids.
+template<typename T>
+T&
+read_term(Cursor& c, Name*)
+{
+  Decl& d = c.node<Decl>();
+  Term_list args = c.list<Term>();
+  return c.make<T>(d, args);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Qualified_id*)
+{
+  Decl& d = c.node<Decl>();
+  Name& n = c.node<Name>();
+  return c.make<Qualified_id>(d, n);
+}
+
+
+// Types
+//
+// Types are rebuilt through the builder so that they are canonical.
+
+template<typename T>
+T&
+read_term(Cursor& c, Void_type*)
+{
+  return c.cxt.get_void_type();
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Boolean_type*)
+{
+  return c.cxt.get_bool_type();
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Byte_type*)
+{
+  return c.cxt.get_byte_type();
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Integer_type*)
+{
+  bool s = c.get();
+  int p = c.get();
+  return c.cxt.get_integer_type(s, p);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Float_type*)
+{
+  return c.cxt.get_float_type(c.get());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Function_type*)
+{
+  Type_list ps = c.list<Type>();
+  Type& r = c.node<Type>();
+  return c.cxt.get_function_type(ps, r);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Qualified_type*)
+{
+  Type& t = c.node<Type>();
+  Qualifier_set q = Qualifier_set(c.get());
+  return c.cxt.get_qualified_type(t, q);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Pointer_type*)
+{
+  return c.cxt.get_pointer_type(c.node<Type>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Reference_type*)
+{
+  return c.cxt.get_reference_type(c.node<Type>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Slice_type*)
+{
+  return c.cxt.get_slice_type(c.node<Type>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Pack_type*)
+{
+  return c.cxt.get_pack_type(c.node<Type>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Array_type*)
+{
+  Type& t = c.node<Type>();
+  Expr& e = c.node<Expr>();
+  return c.cxt.get_array_type(t, e);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Dynarray_type*)
+{
+  Type& t = c.node<Type>();
+  Expr& e = c.node<Expr>();
+  return c.cxt.get_dynarray_type(t, e);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Tuple_type*)
+{
+  return c.cxt.get_tuple_type(c.list<Type>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Class_type*)
+{
+  return c.cxt.get_class_type(c.node<Type_decl>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Typename_type*)
+{
+  return c.cxt.get_typename_type(c.node<Type_decl>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Coroutine_type*)
+{
+  return c.cxt.get_coroutine_type(c.node<Type_decl>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Auto_type*)
+{
+  return c.cxt.get_auto_type(c.node<Type_decl>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Synthetic_type*)
+{
+  return c.cxt.synthesize_type(c.node<Decl>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Decltype_type*)
+{
+  throw Limitation_error("cannot read decltype types");
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Type_type*)
+{
+  return c.cxt.get_type_type();
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Unparsed_type*)
+{
+  return c.make<Unparsed_type>(c.tokens());
+}
+
+
+// Expressions
+
+template<typename T>
+T&
+read_term(Cursor& c, Boolean_expr*)
+{
+  Type& t = c.node<Type>();
+  bool b = c.get();
+  return c.make<Boolean_expr>(t, b);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Integer_expr*)
+{
+  Type& t = c.node<Type>();
+  Integer n = c.string();
+  return c.make<Integer_expr>(t, n);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Real_expr*)
+{
+  throw Limitation_error("cannot read real literals");
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Tuple_expr*)
+{
+  Type& t = c.node<Type>();
+  Expr_list es = c.list<Expr>();
+  return c.make<Tuple_expr>(t, es);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Decl_expr*)
+{
+  Type& t = c.node<Type>();
+  Name& n = c.node<Name>();
+  Decl& d = c.node<Decl>();
+  return c.make<T>(t, n, d);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Overload_expr*)
+{
+  Type* t = c.node_opt<Type>();
+  Name& n = c.node<Name>();
+  Decl_list ds = c.list<Decl>();
+  if (ds.empty())
+    throw Translation_error("malformed AST: empty overload set");
+  Overload_set& ovl = c.make<Overload_set>(ds.front());
+  for (auto iter = ++ds.begin(); iter != ds.end(); ++iter)
+    ovl.insert(*iter);
+  Overload_expr& e = c.make<Overload_expr>(n, ovl);
+  e.type_ = t;
+  return e;
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Member_expr*)
+{
+  Type* t = c.node_opt<Type>();
+  Expr& e = c.node<Expr>();
+  Name& n = c.node<Name>();
+  Member_expr& m = c.make<Member_expr>(e, n);
+  m.type_ = t;
+  return m;
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Nested_decl_expr*)
+{
+  Type& t = c.node<Type>();
+  Expr& e = c.node<Expr>();
+  Name& n = c.node<Name>();
+  Decl& d = c.node<Decl>();
+  return c.make<T>(t, e, n, d);
+}
+
+
+// Unary expressions and conversions.
+template<typename T>
+T&
+read_term(Cursor& c, Expr*)
+{
+  Type& t = c.node<Type>();
+  Expr& e = c.node<Expr>();
+  return c.make<T>(t, e);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Binary_expr*)
+{
+  Type& t = c.node<Type>();
+  Expr& e1 = c.node<Expr>();
+  Expr& e2 = c.node<Expr>();
+  return c.make<T>(t, e1, e2);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Call_expr*)
+{
+  Type& t = c.node<Type>();
+  Expr& f = c.node<Expr>();
+  Expr_list args = c.list<Expr>();
+  return c.make<Call_expr>(t, f, args);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Check_expr*)
+{
+  Type& t = c.node<Type>();
+  Decl& d = c.node<Decl>();
+  Term_list args = c.list<Term>();
+  return c.make<Check_expr>(t, d, args);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Requires_expr*)
+{
+  Type& t = c.node<Type>();
+  Decl_list tps = c.list<Decl>();
+  Decl_list nps = c.list<Decl>();
+  Req_list rs = c.list<Req>();
+  return c.make<Requires_expr>(t, tps, nps, rs);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Synthetic_expr*)
+{
+  Type& t = c.node<Type>();
+  Decl& d = c.node<Decl>();
+  return c.make<Synthetic_expr>(t, d);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Unparsed_expr*)
+{
+  Type* t = c.node_opt<Type>();
+  Unparsed_expr& e = c.make<Unparsed_expr>(c.tokens());
+  e.type_ = t;
+  return e;
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Trivial_init*)
+{
+  return c.make<Trivial_init>(c.node<Type>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Direct_init*)
+{
+  Type& t = c.node<Type>();
+  Decl& d = c.node<Decl>();
+  Expr_list args = c.list<Expr>();
+  return c.make<Direct_init>(t, d, args);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Aggregate_init*)
+{
+  Type& t = c.node<Type>();
+  Expr_list es = c.list<Expr>();
+  return c.make<Aggregate_init>(t, es);
+}
+
+
+// Requirements
+
+template<typename T>
+T&
+read_term(Cursor& c, Type_req*)
+{
+  return c.make<Type_req>(c.node<Type>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Syntactic_req*)
+{
+  return c.make<Syntactic_req>(c.node<Expr>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Semantic_req*)
+{
+  Semantic_req& r = c.make<Semantic_req>();
+  r.decl = &c.node<Decl>();
+  return r;
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Expression_req*)
+{
+  Expression_req& r = c.make<Expression_req>();
+  r.expr = &c.node<Expr>();
+  return r;
+}
+
+
+// Basic and conversion requirements.
+template<typename T>
+T&
+read_term(Cursor& c, Req*)
+{
+  Expr& e = c.node<Expr>();
+  Type& t = c.node<Type>();
+  return c.make<T>(e, t);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Deduction_req*)
+{
+  Deduction_req& r = c.make<Deduction_req>();
+  r.expr = &c.node<Expr>();
+  r.ty = &c.node<Type>();
+  return r;
+}
+
+
+// Statements
+
+// Empty, break, and continue statements.
+template<typename T>
+T&
+read_term(Cursor& c, Stmt*)
+{
+  return c.make<T>();
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Multiple_stmt*)
+{
+  Stmt_list ss = c.list<Stmt>();
+  return c.make<T>(std::move(ss));
+}
+
+
+// Expression, return, and yield statements.
+template<typename T>
+T&
+read_term(Cursor& c, Expression_stmt*)
+{
+  return c.make<T>(c.node<Expr>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Return_stmt*)
+{
+  return c.make<T>(c.node<Expr>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Yield_stmt*)
+{
+  return c.make<T>(c.node<Expr>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Declaration_stmt*)
+{
+  return c.make<Declaration_stmt>(c.node<Decl>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, If_then_stmt*)
+{
+  Expr& e = c.node<Expr>();
+  Stmt& s = c.node<Stmt>();
+  return c.make<If_then_stmt>(e, s);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, If_else_stmt*)
+{
+  Expr& e = c.node<Expr>();
+  Stmt& s1 = c.node<Stmt>();
+  Stmt& s2 = c.node<Stmt>();
+  return c.make<If_else_stmt>(e, s1, s2);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, While_stmt*)
+{
+  Expr& e = c.node<Expr>();
+  Stmt& s = c.node<Stmt>();
+  return c.make<While_stmt>(e, s);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Unparsed_stmt*)
+{
+  return c.make<Unparsed_stmt>(c.tokens());
+}
+
+
+// Declarations
+//
+// The name, type, parameters, and (for templates) the pattern of a
+// declaration are read before it is constructed. The declaration is
+// then registered, so that the remaining fields (its context,
+// definition, constraints, and default arguments) can refer to it.
+// Those fields are deferred.
+
+// The fields common to all declarations.
+struct Decl_header
+{
+  Offset        cxt;
+  Name*         name;
+  Type*         type;
+  Specifier_set spec;
+};
+
+
+Decl_header
+read_header(Cursor& c)
+{
+  Decl_header h;
+  h.cxt = c.ref();
+  h.name = &c.node<Name>();
+  h.type = c.node_opt<Type>();
+  h.spec = Specifier_set(c.get());
+  return h;
+}
+
+
+// Register the declaration and assign its common fields.
+template<typename T>
+T&
+declare_header(Cursor& c, T& d, Decl_header const& h)
+{
+  c.declare(d);
+  d.name_ = h.name;
+  d.type_ = h.type;
+  d.spec_ = h.spec;
+  if (h.cxt) {
+    Ast_reader& r = c.r;
+    Offset off = h.cxt;
+    r.defer([&r, &d, off]() { d.cxt_ = &r.get<Decl>(off); });
+  }
+  return d;
+}
+
+
+// Returns the type of the declaration, which must not be null.
+inline Type&
+header_type(Decl_header const& h)
+{
+  if (!h.type)
+    throw Translation_error("malformed AST: untyped declaration");
+  return *h.type;
+}
+
+
+// A placeholder for deferred definitions.
+Empty_def placeholder;
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Super_decl*)
+{
+  Decl_header h = read_header(c);
+  Type& t = c.node<Type>();
+  Super_decl& d = declare_header(c, c.make<Super_decl>(*h.name, t, placeholder), h);
+  defer(c, d.def_);
+  return d;
+}
+
+
+// Variables and fields.
+template<typename T>
+T&
+read_term(Cursor& c, Variable_decl*)
+{
+  Decl_header h = read_header(c);
+  T& d = declare_header(c, c.make<T>(*h.name, header_type(h), placeholder), h);
+  defer(c, d.def_);
+  return d;
+}
+
+
+// Functions and methods.
+template<typename T>
+T&
+read_term(Cursor& c, Function_decl*)
+{
+  Decl_header h = read_header(c);
+  Decl_list ps = c.list<Decl>();
+  T& d = declare_header(c, c.make<T>(*h.name, header_type(h), ps, placeholder), h);
+  d.constr_ = nullptr;
+  defer(c, d.def_);
+  c.r.frames.push_back(&d);
+  return d;
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Class_decl*)
+{
+  Decl_header h = read_header(c);
+  Class_decl& d = declare_header(c, c.make<Class_decl>(*h.name, header_type(h), placeholder), h);
+  d.kind_ = h.type;
+  defer(c, d.bases_);
+  defer(c, d.derivatives_);
+  defer(c, d.def_);
+  return d;
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Coroutine_decl*)
+{
+  Decl_header h = read_header(c);
+  Decl_list ps = c.list<Decl>();
+  Type& r = c.node<Type>();
+  Coroutine_decl& d = declare_header(c, c.make<Coroutine_decl>(*h.name, r, ps, placeholder), h);
+  defer(c, d.def_);
+  return d;
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Concept_decl*)
+{
+  Decl_header h = read_header(c);
+  Decl_list ps = c.list<Decl>();
+  Concept_decl& d = declare_header(c, c.make<Concept_decl>(*h.name, ps), h);
+  defer(c, d.def);
+  return d;
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Template_decl*)
+{
+  Decl_header h = read_header(c);
+  Decl_list ps = c.list<Decl>();
+  Decl& p = c.node<Decl>();
+  Template_decl& d = declare_header(c, c.make<Template_decl>(ps, p), h);
+  defer(c, d.cons);
+  return d;
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Object_parm*)
+{
+  Decl_header h = read_header(c);
+  Index x = c.index();
+  Object_parm& d = declare_header(c, c.make<Object_parm>(*h.name, header_type(h)), h);
+  d.index() = x;
+  defer(c, d.init_);
+  return d;
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Value_parm*)
+{
+  Decl_header h = read_header(c);
+  Index x = c.index();
+  Value_parm& d = declare_header(c, c.make<Value_parm>(x, *h.name, header_type(h)), h);
+  defer(c, d.init_);
+  return d;
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Type_parm*)
+{
+  Decl_header h = read_header(c);
+  Index x = c.index();
+  Type_parm& d = declare_header(c, c.make<Type_parm>(x, *h.name), h);
+  defer(c, d.def);
+  return d;
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Template_parm*)
+{
+  Decl_header h = read_header(c);
+  Index x = c.index();
+  Decl& t = c.node<Decl>();
+  Template_parm& d = declare_header(c, c.make<Template_parm>(*h.name, t), h);
+  d.index() = x;
+  defer(c, d.def);
+  return d;
+}
+
+
+// Definitions
+
+// Empty, defaulted, and deleted definitions.
+template<typename T>
+T&
+read_term(Cursor& c, Def*)
+{
+  return c.make<T>();
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Expression_def*)
+{
+  return c.make<Expression_def>(c.node<Expr>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Function_def*)
+{
+  return c.make<Function_def>(c.node<Stmt>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Class_def*)
+{
+  return c.make<Class_def>(c.node<Stmt>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Concept_def*)
+{
+  return c.make<Concept_def>(c.list<Req>());
+}
+
+
+// Constraints
+//
+// Constraints are rebuilt through the builder so that they are
+// canonical.
+
+template<typename T>
+T&
+read_term(Cursor& c, Concept_cons*)
+{
+  Decl& d = c.node<Decl>();
+  Term_list args = c.list<Term>();
+  return c.cxt.get_concept_constraint(d, args);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Predicate_cons*)
+{
+  return c.cxt.get_predicate_constraint(c.node<Expr>());
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Expression_cons*)
+{
+  Expr& e = c.node<Expr>();
+  Type& t = c.node<Type>();
+  return c.cxt.get_expression_constraint(e, t);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Conversion_cons*)
+{
+  Expr& e = c.node<Expr>();
+  Type& t = c.node<Type>();
+  return c.cxt.get_conversion_constraint(e, t);
+}
+
+
+// Type and deduction constraints.
+template<typename T>
+T&
+read_term(Cursor& c, Cons*)
+{
+  return c.make<T>();
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Parameterized_cons*)
+{
+  Decl_list vs = c.list<Decl>();
+  Cons& c1 = c.node<Cons>();
+  return c.cxt.get_parameterized_constraint(vs, c1);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Conjunction_cons*)
+{
+  Cons& c1 = c.node<Cons>();
+  Cons& c2 = c.node<Cons>();
+  return c.cxt.get_conjunction_constraint(c1, c2);
+}
+
+
+template<typename T>
+T&
+read_term(Cursor& c, Disjunction_cons*)
+{
+  Cons& c1 = c.node<Cons>();
+  Cons& c2 = c.node<Cons>();
+  return c.cxt.get_disjunction_constraint(c1, c2);
+}
+
+} // namespace
+
+
+// Read the term at the given offset.
+Term&
+Ast_reader::read(Offset off)
+{
+  Cursor c(*this, off);
+  switch (c.get()) {
+#define define_node(Node) \
+  case Node##_tag: return read_term<Node>(c, static_cast<Node*>(nullptr));
+#include "ast-name.def"
+#include "ast-type.def"
+#include "ast-expr.def"
+#include "ast-req.def"
+#include "ast-stmt.def"
+#include "ast-decl.def"
+#include "ast-def.def"
+#include "ast-cons.def"
+#undef define_node
+  default:
+    break;
+  }
+  throw Translation_error("malformed AST: unknown term at offset {}", off);
+}
+
+
+} // namespace banjo
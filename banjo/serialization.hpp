@@ -0,0 +1,166 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_SERIALIZATION_HPP
+#define BANJO_SERIALIZATION_HPP
+
+// This module defines a compact binary format for elaborated terms,
+// so that a translation can be saved and loaded without re-parsing.
+//
+// A serialized translation is a sequence of 32-bit words: a header,
+// the node records, an index of top-level declarations, and a symbol
+// table. Each record starts with a tag that identifies the kind of
+// node, followed by its fields. References to other records are
+// stored as offsets relative to the referring field, where 0 is a
+// null reference. Symbols are stored once, in the symbol table, and
+// referred to by index.
+//
+// The format is designed to be memory-mapped and read lazily. Terms
+// are materialized only when they are first requested, and a single
+// declaration can be loaded through the index.
+//
+// Source locations are not saved.
+
+#include "prelude.hpp"
+#include "language.hpp"
+#include "source.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+
+namespace banjo
+{
+
+struct Context;
+
+
+// Serializes a translation into a buffer of bytes.
+struct Ast_writer
+{
+  using Offset = std::uint32_t;
+
+  String operator()(Stmt const&);
+
+  Offset put(std::uint32_t);
+  void   put_ref(Term const*);
+  void   put_ref(Term const& t) { put_ref(&t); }
+  void   put_symbol(Symbol const&);
+  void   put_string(String const&);
+  void   put_tokens(Token_seq const&);
+  void   put_index(Index);
+
+  template<typename L>
+  void put_list(L const&);
+
+  Offset record(Term const&);
+  void   patch(Offset, std::uint32_t);
+
+  String                                      buf;     // The serialized bytes
+  std::unordered_map<Term const*, Offset>     offsets; // Written records
+  std::vector<std::pair<Offset, Term const*>> fixups;  // Unresolved references
+  std::unordered_map<Symbol const*, Offset>   symbols; // Symbol indexes
+  std::vector<Symbol const*>                  symtab;  // Symbols in index order
+};
+
+
+// Write a count followed by a reference to each element of the list.
+template<typename L>
+inline void
+Ast_writer::put_list(L const& list)
+{
+  put(list.size());
+  for (auto const& x : list)
+    put_ref(x);
+}
+
+
+// Reads terms from a serialized translation. The buffer must outlive
+// the reader. Terms are allocated in the context, so they outlive
+// both.
+//
+// Throws a Translation_error if the buffer is not a serialized
+// translation, or if it is malformed.
+struct Ast_reader
+{
+  using Offset = std::uint32_t;
+
+  Ast_reader(Context&, String_view);
+
+  // Returns the translation.
+  Stmt& translation();
+
+  // Returns the top-level declaration with the given name, or nullptr
+  // if there is no such declaration. Only that declaration and the
+  // terms it refers to are read.
+  Decl* declaration(Symbol const&);
+
+  // Returns the number of terms read so far.
+  std::size_t size() const { return nodes.size(); }
+
+  std::uint32_t word(Offset) const;
+  Offset        target(Offset) const;
+  Symbol const& symbol(std::uint32_t);
+  String        string(Offset) const;
+
+  Term& node(Offset);
+  Term& read(Offset);
+  void  link();
+
+  template<typename T>
+  T& get(Offset);
+
+  template<typename T>
+  T* get_opt(Offset);
+
+  // Register a field to be read after the current term. This breaks
+  // the cycles between declarations and the terms that refer to them.
+  void defer(std::function<void()> f) { pending.push_back(std::move(f)); }
+
+  Context&                           cxt;
+  String_view                        buf;     // The serialized bytes
+  Offset                             root;    // The translation
+  Offset                             index;   // Top-level declarations
+  Offset                             symtab;  // The symbol table
+  std::unordered_map<Offset, Term*>  nodes;   // Terms already read
+  std::vector<Offset>                active;  // Terms being read
+  std::vector<Symbol const*>         syms;    // Symbols already read
+  std::vector<std::function<void()>> pending; // Deferred fields
+  std::vector<Function_decl*>        frames;  // Functions to allocate
+};
+
+
+// Returns the term at the given offset, which must have type T.
+template<typename T>
+T&
+Ast_reader::get(Offset off)
+{
+  if (!off)
+    throw Translation_error("malformed AST: unexpected null reference");
+  T* p = as<T>(&node(off));
+  if (!p)
+    throw Translation_error("malformed AST: unexpected term at offset {}", off);
+  return *p;
+}
+
+
+// Returns the term at the given offset, or nullptr if the offset is
+// null.
+template<typename T>
+inline T*
+Ast_reader::get_opt(Offset off)
+{
+  return off ? &get<T>(off) : nullptr;
+}
+
+
+String save_ast(Stmt const&);
+bool   save_ast(Stmt const&, String const&);
+
+
+} // namespace banjo
+
+
+#endif
@@ -0,0 +1,59 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "source.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace banjo
+{
+
+Source_file::Source_file(String const& p)
+  : path_(p), first_(nullptr), last_(nullptr)
+{
+  int fd = ::open(p.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw Translation_error("cannot open '{}': {}", p, std::strerror(errno));
+
+  struct stat st;
+  if (::fstat(fd, &st) < 0) {
+    int err = errno;
+    ::close(fd);
+    throw Translation_error("cannot read '{}': {}", p, std::strerror(err));
+  }
+
+  // Don't try to map an empty file.
+  if (st.st_size == 0) {
+    ::close(fd);
+    return;
+  }
+
+  void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  int err = errno;
+  ::close(fd);
+  if (addr == MAP_FAILED)
+    throw Translation_error("cannot map '{}': {}", p, std::strerror(err));
+
+  // The file is lexed from front to back.
+  ::madvise(addr, st.st_size, MADV_SEQUENTIAL);
+
+  first_ = static_cast<char const*>(addr);
+  last_ = first_ + st.st_size;
+}
+
+
+Source_file::~Source_file()
+{
+  if (first_)
+    ::munmap(const_cast<char*>(first_), size());
+}
+
+
+} // namespace banjo
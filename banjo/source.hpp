@@ -0,0 +1,82 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#ifndef BANJO_SOURCE_HPP
+#define BANJO_SOURCE_HPP
+
+// This module provides read-only, memory-mapped access to files, and
+// the string views used for spellings.
+//
+// The driver maps saved translations with Source_file (see -load-ast).
+// Source files are still read through lingo::File, since tokens and
+// diagnostics locate text in lingo's buffers. While scanning, the
+// lexer views spellings in that buffer instead of copying them, but a
+// spelling is copied into the symbol table when it is first interned.
+
+#include "prelude.hpp"
+
+#include <cstdint>
+
+#include <boost/utility/string_ref.hpp>
+
+
+namespace banjo
+{
+
+// A non-owning view of a sequence of characters.
+using String_view = boost::string_ref;
+
+
+// Returns the 64-bit FNV-1a hash of the characters in s.
+inline std::uint64_t
+hash_spelling(String_view s)
+{
+  std::uint64_t h = 14695981039346656037ull;
+  for (char c : s) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+
+// Hash function for string views.
+struct String_view_hash
+{
+  std::size_t operator()(String_view s) const { return hash_spelling(s); }
+};
+
+
+// A source file mapped into memory. The text of the file is
+// available through begin() and end() for the lifetime of the
+// object. Empty files are not mapped.
+//
+// Construction throws a Translation_error if the file cannot be
+// opened or mapped.
+struct Source_file
+{
+  explicit Source_file(String const&);
+  ~Source_file();
+
+  Source_file(Source_file const&) = delete;
+  Source_file& operator=(Source_file const&) = delete;
+
+  String const& path() const { return path_; }
+
+  char const* begin() const { return first_; }
+  char const* end() const   { return last_; }
+
+  std::size_t size() const { return last_ - first_; }
+
+  String_view text() const { return String_view(first_, size()); }
+
+  String      path_;
+  char const* first_;
+  char const* last_;
+};
+
+
+} // namespace banjo
+
+
+#endif
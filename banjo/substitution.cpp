@@ -98,7 +98,7 @@ Type& substitute_type(Context&, Pointer_type&, Substitution&);
 Type& substitute_type(Context&, Array_type&, Substitution&);
 Type& substitute_type(Context&, Tuple_type&, Substitution&);
 Type& substitute_type(Context&, Dynarray_type&, Substitution&);
-Type& substitute_type(Context&, Sequence_type&, Substitution&);
+Type& substitute_type(Context&, Slice_type&, Substitution&);
 Type& substitute_type(Context&, Typename_type&, Substitution&);
 
 
@@ -115,7 +115,6 @@ substitute(Context& cxt, Type& t, Substitution& sub)
 
     Type& operator()(Auto_type& t)      { lingo_unreachable(); }
     Type& operator()(Decltype_type& t)  { lingo_unreachable(); }
-    Type& operator()(Declauto_type& t)  { lingo_unreachable(); }
 
     // Recrusively substitute through compound types.
     Type& operator()(Function_type& t)  { return substitute_type(cxt, t, sub); }
@@ -125,7 +124,7 @@ substitute(Context& cxt, Type& t, Substitution& sub)
     Type& operator()(Array_type& t)     { return substitute_type(cxt, t, sub); }
     Type& operator()(Tuple_type& t)     { return substitute_type(cxt, t, sub); }
     Type& operator()(Dynarray_type& t)  { return substitute_type(cxt, t, sub); }
-    Type& operator()(Sequence_type& t)  { return substitute_type(cxt, t, sub); }
+    Type& operator()(Slice_type& t)     { return substitute_type(cxt, t, sub); }
     Type& operator()(Typename_type& t)  { return substitute_type(cxt, t, sub); }
   };
   return apply(t, fn{cxt, sub});
@@ -187,10 +186,10 @@ substitute_type(Context& cxt, Dynarray_type& t, Substitution& sub)
 
 
 Type&
-substitute_type(Context& cxt, Sequence_type& t, Substitution& sub)
+substitute_type(Context& cxt, Slice_type& t, Substitution& sub)
 {
   Type& s = substitute(cxt, t.type(), sub);
-  return cxt.get_sequence_type(s);
+  return cxt.get_slice_type(s);
 }
 
 
@@ -273,7 +272,7 @@ subst_conv(Context& cxt, Boolean_conv& e, Substitution& sub)
 {
   Expr& e1 = substitute(cxt, e.source(), sub);
   Type& t1 = substitute(cxt, e.destination(), sub);
-  return *new Boolean_conv(t1, e1);
+  return cxt.make<Boolean_conv>(t1, e1);
 }
 
 
@@ -9,9 +9,11 @@
 #include "substitution.hpp"
 #include "printer.hpp"
 
+#include <algorithm>
+#include <cstdint>
 #include <list>
-#include <unordered_set>
 #include <iostream>
+#include <vector>
 
 
 namespace banjo
@@ -21,27 +23,114 @@ namespace banjo
 // -------------------------------------------------------------------------- //
 // Proof structures
 
+// An open-addressed hash set of constraints, used to index the
+// propositions of a list. Slots are probed linearly, and erasure
+// shifts later entries of a cluster back so that no tombstones are
+// needed. The table is kept at most half full.
+struct Prop_index
+{
+  using Table = std::vector<Cons const*>;
+
+  Prop_index()
+    : count(0)
+  { }
+
+  // Returns true if c is in the set.
+  bool contains(Cons const& c) const
+  {
+    if (table.empty())
+      return false;
+    return table[find(c)] == &c;
+  }
+
+  // Add c to the set. Returns false if it was already present.
+  bool insert(Cons const& c)
+  {
+    if (2 * (count + 1) > table.size())
+      grow();
+    std::size_t i = find(c);
+    if (table[i])
+      return false;
+    table[i] = &c;
+    ++count;
+    return true;
+  }
+
+  // Remove c from the set, if present.
+  void erase(Cons const& c)
+  {
+    if (table.empty())
+      return;
+    std::size_t mask = table.size() - 1;
+    std::size_t i = find(c);
+    if (!table[i])
+      return;
+    table[i] = nullptr;
+    --count;
+
+    // Move entries that would no longer be reachable into the hole.
+    for (std::size_t j = (i + 1) & mask; table[j]; j = (j + 1) & mask) {
+      std::size_t k = hash(*table[j]) & mask;
+      if (((j - k) & mask) >= ((j - i) & mask)) {
+        table[i] = table[j];
+        table[j] = nullptr;
+        i = j;
+      }
+    }
+  }
+
+  // Returns the slot containing c, or the empty slot where it would
+  // be inserted. The table must not be empty.
+  std::size_t find(Cons const& c) const
+  {
+    std::size_t mask = table.size() - 1;
+    std::size_t i = hash(c) & mask;
+    while (table[i] && table[i] != &c)
+      i = (i + 1) & mask;
+    return i;
+  }
+
+  // Double the size of the table and reinsert its entries.
+  void grow()
+  {
+    Table old(table.empty() ? 8 : 2 * table.size(), nullptr);
+    table.swap(old);
+    for (Cons const* c : old)
+      if (c)
+        table[find(*c)] = c;
+  }
+
+  static std::size_t hash(Cons const& c)
+  {
+    std::uintptr_t n = reinterpret_cast<std::uintptr_t>(&c);
+    return (n >> 4) * std::size_t(0x9e3779b97f4a7c15ull);
+  }
+
+  Table       table;
+  std::size_t count;
+};
+
+
 // A list of propositions (constraints). These are accumulated on either
-// side of a sequent. This is actually a list equipped with a side-table
-// to optimize list membership.
+// side of a sequent. The propositions are stored contiguously so that
+// copying a sequent (when a proof branches) is a simple copy of an
+// array of pointers.
 //
-// FIXME: An unordered map on constraint *values* will be inefficient.
-// We really want to work on constraint identities, which means we
-// need to canonicalize constraints.
+// Constraints are canonicalized by the builder, so membership is
+// determined by the identity of constraints. Each list indexes its
+// members in a hash set, so membership is checked without searching
+// the list.
 struct Prop_list
 {
-  using Seq            = std::list<Cons const*>;
+  using Seq            = std::vector<Cons const*>;
   using iterator       = Seq::iterator;
   using const_iterator = Seq::const_iterator;
 
-  using Map = std::unordered_map<Cons const*, iterator, Cons_hash, Cons_eq>;
-
-
   // Returns true if the list has a constraint that is identical
   // to c.
   bool contains(Cons const& c) const
   {
-    return map.count(&c) != 0;
+    return index.contains(c);
   }
 
   // Insert a new constraint. No action is taken if the constraint
@@ -49,76 +138,63 @@ struct Prop_list
   // constraint or that of the original constraint.
   std::pair<iterator, bool> insert(Cons const& c)
   {
-    auto iter = map.find(&c);
-    if (iter != map.end()) {
-      return {iter->second, false};
-    } else {
-      auto pos = seq.insert(seq.end(), &c);
-      map.emplace(&c, pos);
-      return {pos, true};
-    }
+    if (!index.insert(c))
+      return {std::find(seq.begin(), seq.end(), &c), false};
+    seq.push_back(&c);
+    return {std::prev(seq.end()), true};
   }
 
   // Positionally insert the constraint before pos. This does nothing if
-  // c is in the map, returing the same iterator.
+  // c is in the list, returing the same iterator.
   std::pair<iterator, bool> insert(iterator pos, Cons const& c)
   {
-    auto iter = map.find(&c);
-    if (iter != map.end()) {
+    if (!index.insert(c))
       return {pos, false};
-    } else {
-      pos = seq.insert(pos, &c);
-      map.emplace(&c, pos);
-      return {pos, true};
-    }
+    return {seq.insert(pos, &c), true};
   }
 
-  // Erase the constraint from the list. This nulls the entry in the
-  // sequence, so it must be replaced.
+  // Erase the constraint from the list.
   iterator erase(iterator pos)
   {
-    map.erase(*pos);
+    index.erase(**pos);
     return seq.erase(pos);
   }
 
   // Replace the term in the list with c. Note that no replacement
   // may be made if c is already in the list.
   //
-  // Returns a pair (i, b) where i is an iterator and b a boolean
-  // value indicating successful insertion. If b is true, then i
-  // i is the position of the inserted constraint. Otherise, i the
-  // iterator past the original replaced element.
+  // Returns the position of the inserted constraint or, if c was not
+  // inserted, the position past the replaced element. Both of these
+  // have the same offset as pos.
   iterator replace(iterator pos, Cons const& c)
   {
+    std::size_t n = pos - seq.begin();
     pos = erase(pos);
-    auto x = insert(pos, c);
-    if (x.second)
-      return x.first;
-    return pos;
+    insert(pos, c);
+    return seq.begin() + n;
   }
 
   // Replace the term in the list with c1 folowed by c2. Note that
   // no replacements may be made if c1 and c2 are already in the list.
   iterator replace(iterator pos, Cons const& c1, Cons const& c2)
   {
+    std::size_t n = pos - seq.begin();
     pos = erase(pos);
-    auto x1 = insert(pos, c1);
-    auto x2 = insert(pos, c2);
-    if (x1.second)
-      return x1.first;
-    if (x2.second)
-      return x2.first;
-    return pos;
+    auto x = insert(pos, c1);
+    insert(seq.begin() + n + x.second, c2);
+    return seq.begin() + n;
   }
 
+  std::size_t size() const { return seq.size(); }
+
   iterator begin() { return seq.begin(); }
   iterator end()   { return seq.end(); }
 
   const_iterator begin() const { return seq.begin(); }
   const_iterator end()   const { return seq.end(); }
 
-  Map      map;
-  Seq      seq;
+  Seq        seq;
+  Prop_index index;
 };
 
 
@@ -278,12 +354,27 @@ is_reduced(Prop_list const& ps)
 
 // -------------------------------------------------------------------------- //
 // Subsumption memoization
+//
+// The results of subsumption queries are saved in the context. Since
+// constraints are canonical, a query is keyed by the identities of its
+// antecedent and consequent. Within a proof, a sub-goal whose
+// consequent is known to be subsumed by some antecedent is valid.
 
-// TODO: Memoize the subsumption relation.
-bool
-is_memoized(Context& cxt, Cons const& a, Cons const& b)
+
+// Returns true if it is known that a subsumes c.
+static inline bool
+is_memoized(Context& cxt, Cons const& a, Cons const& c)
 {
-  return false;
+  bool r;
+  return cxt.subsumed.find({&a, &c}, r) && r;
+}
+
+
+// Save the result of the proof that a subsumes c.
+static inline void
+memoize(Context& cxt, Cons const& a, Cons const& c, bool r)
+{
+  cxt.subsumed.save({&a, &c}, r);
 }
 
 
@@ -453,7 +544,12 @@ check_term(Proof& p, Prop_list& ants, Cons const& c)
   if (ants.contains(c))
     return valid_proof;
 
-  // FIXME: Memoization?
+  // If C is known to be subsumed by the only antecedent, the proof
+  // is valid. Only those proofs are saved below, so there is no point
+  // in probing the cache for each of several antecedents.
+  Context& cxt = p.context();
+  if (ants.size() == 1 && is_memoized(cxt, **ants.begin(), c))
+    return valid_proof;
 
   // Actually derive a proof of C from AS. If the result
   // is invalid, by the thre are incomplete terms, then
@@ -463,6 +559,11 @@ check_term(Proof& p, Prop_list& ants, Cons const& c)
     if (!is_reduced(ants))
       return incomplete_proof;
   }
+
+  // Save proofs of sub-goals having a single antecedent so that
+  // they can be reused in later proofs.
+  if (v == valid_proof && ants.size() == 1)
+    memoize(cxt, **ants.begin(), c, true);
   return v;
 }
 
@@ -575,7 +676,7 @@ void
 load_antecedents(Proof& p, Sequent& s)
 {
   Prop_list& as = s.antecedents();
-  for (auto iter = as.begin(); iter != as.end(); ++iter)
+  for (auto iter = as.begin(); iter != as.end(); )
     iter = load_antecedent(p, as, iter);
 }
 
@@ -614,7 +715,7 @@ void
 load_consequents(Proof& p, Sequent& s)
 {
   Prop_list& cs = s.consequents();
-  for (auto iter = cs.begin(); iter != cs.end(); ++iter)
+  for (auto iter = cs.begin(); iter != cs.end(); )
     iter = load_consequent(p, cs, iter);
 }
 
@@ -686,19 +787,12 @@ expand_proof(Proof& p)
 // Subsumption
 
 
-// Returns true if a subsumes c.
+// Prove that a subsumes c.
 //
 // TODO: How do I know when I've exhuasted all opportunities.
-bool
-subsumes(Context& cxt, Cons const& a, Cons const& c)
+static bool
+prove_subsumption(Context& cxt, Cons const& a, Cons const& c)
 {
-  // Check the easy cases before setting up a proof.
-  if (is_equivalent(a, c))
-    return true;
-  if (is_memoized(cxt, a, c))
-    return true;
-
-  // Alas... no quick check. We have to prove the implication.
   Proof p(cxt);
   Sequent& s = p.front();
   s.antecedents().insert(a);
@@ -747,6 +841,26 @@ subsumes(Context& cxt, Cons const& a, Cons const& c)
 }
 
 
+// Returns true if a subsumes c. The result of each query is saved
+// in the context.
+bool
+subsumes(Context& cxt, Cons const& a, Cons const& c)
+{
+  // Check the easy cases before setting up a proof. Constraints
+  // are canonical, so equivalent constraints are identical.
+  if (&a == &c)
+    return true;
+  bool known;
+  if (cxt.subsumed.find({&a, &c}, known))
+    return known;
+
+  // Alas... no quick check. We have to prove the implication.
+  bool r = prove_subsumption(cxt, a, c);
+  memoize(cxt, a, c, r);
+  return r;
+}
+
+
 bool
 subsumes(Context& cxt, Expr const& a, Expr const& c)
 {
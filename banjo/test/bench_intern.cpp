@@ -0,0 +1,86 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+// A microbenchmark for the concurrent interning table. Each thread
+// interns a stream of identifiers drawn from a shared vocabulary and
+// the aggregate throughput (in millions of lookups per second) is
+// reported for increasing numbers of threads.
+//
+//    bench_intern [lookups-per-thread] [max-threads]
+
+#include <banjo/intern.hpp>
+#include <banjo/token.hpp>
+
+#include <lingo/symbol.hpp>
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lingo;
+using namespace banjo;
+
+
+// Generate a vocabulary of n distinct identifiers.
+std::vector<std::string>
+vocabulary(std::size_t n)
+{
+  std::vector<std::string> v;
+  v.reserve(n);
+  for (std::size_t i = 0; i < n; ++i)
+    v.push_back("id_" + std::to_string(i * 2654435761u));
+  return v;
+}
+
+
+// Intern n identifiers chosen at random from the vocabulary.
+void
+work(Intern_table& tab, std::vector<std::string> const& vocab, std::size_t n, unsigned seed)
+{
+  std::minstd_rand gen(seed);
+  for (std::size_t i = 0; i < n; ++i) {
+    std::string const& s = vocab[gen() % vocab.size()];
+    Symbol const* sym = tab.put_identifier(s);
+    assert(sym);
+    (void)sym;
+  }
+}
+
+
+// Run the benchmark with t threads and report the throughput.
+void
+run(std::vector<std::string> const& vocab, std::size_t n, unsigned t)
+{
+  using Clock = std::chrono::steady_clock;
+  Symbol_table syms;
+  init_tokens(syms);
+  Intern_table tab(syms);
+
+  auto start = Clock::now();
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < t; ++i)
+    threads.emplace_back(work, std::ref(tab), std::cref(vocab), n, i + 1);
+  for (std::thread& th : threads)
+    th.join();
+  auto stop = Clock::now();
+
+  double secs = std::chrono::duration<double>(stop - start).count();
+  std::cout << t << " threads: " << tab.size() << " symbols, "
+            << (n * t) / secs / 1e6 << " M/s\n";
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  std::size_t n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  unsigned max = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+  std::vector<std::string> vocab = vocabulary(50000);
+  for (unsigned t = 1; t <= max; t *= 2)
+    run(vocab, n, t);
+}
@@ -0,0 +1,140 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+// A microbenchmark for the lexical scanners. This generates a large
+// synthetic input and reports the throughput (in MB/s) of a simple
+// lexing loop using the scalar scanners and the scanners selected for
+// the host processor. When files are given, they are memory-mapped
+// and lexed in place instead.
+//
+//    bench_lex [megabytes]
+//    bench_lex file...
+
+#include <banjo/scan.hpp>
+#include <banjo/source.hpp>
+
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace banjo;
+
+
+// Generate approximately n bytes of source-like text.
+std::string
+generate(std::size_t n)
+{
+  static char const* words[] = {
+    "def", "var", "return", "if", "while", "x", "value", "result_type",
+    "make_iterator", "count", "i", "operator", "really_long_identifier_name"
+  };
+  static char const* puncts[] = {
+    "(", ")", "{", "}", ";", ",", "=", "+", "==", "->", "."
+  };
+
+  std::minstd_rand gen(42);
+  std::string s;
+  s.reserve(n + 128);
+  while (s.size() < n) {
+    switch (gen() % 8) {
+    case 0:
+      s += "// a comment that runs to the end of the line\n";
+      break;
+    case 1:
+      s += "\n    ";
+      break;
+    case 2:
+      s += std::to_string(gen());
+      s += ' ';
+      break;
+    case 3:
+      s += puncts[gen() % (sizeof(puncts) / sizeof(*puncts))];
+      break;
+    default:
+      s += words[gen() % (sizeof(words) / sizeof(*words))];
+      s += ' ';
+      break;
+    }
+  }
+  return s;
+}
+
+
+// A simplified lexer: returns the number of tokens in [first, last).
+std::size_t
+lex(Scanner_set const& s, char const* first, char const* last)
+{
+  std::size_t n = 0;
+  while (true) {
+    first = s.space(first, last);
+    if (first == last)
+      break;
+    char c = *first;
+    if (c == '/' && last - first > 1 && first[1] == '/') {
+      first = s.line(first + 2, last);
+      continue;
+    }
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+      first = s.identifier(first + 1, last);
+    else if (c >= '0' && c <= '9')
+      first = s.digits(first + 1, last);
+    else
+      ++first;
+    ++n;
+  }
+  return n;
+}
+
+
+// Lex the input using the given scanners and report the throughput.
+std::size_t
+run(Scanner_set const& s, String_view text)
+{
+  using Clock = std::chrono::steady_clock;
+  char const* first = text.begin();
+  char const* last = text.end();
+
+  auto start = Clock::now();
+  std::size_t n = lex(s, first, last);
+  auto stop = Clock::now();
+
+  double secs = std::chrono::duration<double>(stop - start).count();
+  double mb = text.size() / (1024.0 * 1024.0);
+  std::cout << s.name << ": " << n << " tokens, "
+            << mb / secs << " MB/s\n";
+  return n;
+}
+
+
+// Compare the scalar and selected scanners on the text.
+bool
+compare(String_view text)
+{
+  std::size_t n1 = run(get_scalar_scanners(), text);
+  std::size_t n2 = run(get_scanners(), text);
+  assert(n1 == n2);
+  return n1 == n2;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  if (argc > 1 && !std::isdigit(argv[1][0])) {
+    bool ok = true;
+    for (int i = 1; i < argc; ++i) {
+      Source_file f(argv[i]);
+      std::cout << f.path() << ":\n";
+      ok &= compare(f.text());
+    }
+    return ok ? 0 : 1;
+  }
+
+  std::size_t mb = argc > 1 ? std::atoi(argv[1]) : 256;
+  std::string text = generate(mb * 1024 * 1024);
+  return compare(text) ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/arena.hpp>
+
+#include <iostream>
+#include <vector>
+
+
+// An object that records the order in which objects are destroyed.
+struct Tracked
+{
+  Tracked(std::vector<int>& v, int n)
+    : log(v), id(n)
+  { }
+
+  ~Tracked() { log.push_back(id); }
+
+  std::vector<int>& log;
+  int               id;
+};
+
+
+// Objects are counted by kind, and destroyed in reverse order of
+// construction when the arena is released.
+void
+test_objects()
+{
+  std::vector<int> log;
+  Arena a;
+  for (int i = 0; i < 3; ++i)
+    a.make<Tracked>(log, i);
+  a.make<int>(42);
+
+  assert(a.objects() == 4);
+  assert(a.allocated() == 3 * sizeof(Tracked) + sizeof(int));
+  Allocation_stats const& s = a.statistics()[allocation_kind<Tracked>()];
+  assert(s.objects == 3);
+  assert(s.bytes == 3 * sizeof(Tracked));
+
+  a.release();
+  assert(log == std::vector<int>({2, 1, 0}));
+  assert(a.objects() == 0);
+  assert(a.blocks() == 0);
+}
+
+
+// Allocations are aligned. Large requests get their own block, and do
+// not end the current block.
+void
+test_blocks()
+{
+  Arena a;
+  a.allocate(1, 1);
+  void* p = a.allocate(8, 64);
+  assert(reinterpret_cast<std::uintptr_t>(p) % 64 == 0);
+  assert(a.blocks() == 1);
+
+  a.allocate(Arena::block_size, 8);
+  assert(a.blocks() == 2);
+  a.allocate(16, 8);
+  assert(a.blocks() == 2);
+  assert(a.reserved() > 2 * Arena::block_size);
+}
+
+
+// Terms made by the builder are allocated in the context's arena.
+void
+test_terms()
+{
+  Context cxt;
+  Builder& build = cxt;
+  Type& z = build.get_int_type();
+  Arena const& a = cxt.memory();
+  std::size_t n = a.objects();
+  build.make_add(z, build.get_integer(z, 1), build.get_integer(z, 2));
+  assert(a.objects() > n);
+  assert(a.statistics()[allocation_kind<Add_expr>()].objects == 1);
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_objects();
+  test_blocks();
+  test_terms();
+}
@@ -0,0 +1,73 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/bytecode.hpp>
+#include <banjo/evaluation.hpp>
+#include <banjo/gen/llvm/generator.hpp>
+
+#include <iostream>
+
+
+// Returns the function:
+//
+//    def loop() -> int { while (true) { } return 0; }
+Function_decl&
+make_loop(Context& cxt)
+{
+  Builder& build = cxt;
+  Type& z = build.get_int_type();
+  Stmt_list body;
+  body.push_back(build.make_while_statement(build.get_true(), build.make_compound_statement(Stmt_list{})));
+  body.push_back(build.make_return_statement(build.get_integer(z, 0)));
+  Function_decl& f = build.make_function_declaration(build.get_id("loop"), Decl_list{}, z, build.make_compound_statement(std::move(body)));
+  allocate_frame(f);
+  return f;
+}
+
+
+// A non-terminating constant expression exceeds the step limit.
+void
+test_steps()
+{
+  Context cxt;
+  Builder& build = cxt;
+  cxt.limits.steps = 1000;
+
+  Function_decl& f = make_loop(cxt);
+  Expr& e = build.make_call(build.get_int_type(), f, Expr_list{});
+  try {
+    evaluate(cxt, e);
+    assert(false);
+  } catch (Evaluation_error&) {
+  }
+}
+
+
+// The code generator folds array extents within the same limits.
+void
+test_generator()
+{
+  Context cxt;
+  Builder& build = cxt;
+  cxt.limits.steps = 1000;
+
+  Function_decl& f = make_loop(cxt);
+  Expr& e = build.make_call(build.get_int_type(), f, Expr_list{});
+  Type& t = build.get_array_type(build.get_int_type(), e);
+  ll::Generator gen(cxt);
+  try {
+    gen.get_type(t);
+    assert(false);
+  } catch (Evaluation_error&) {
+  }
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_steps();
+  test_generator();
+}
@@ -0,0 +1,237 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/bytecode.hpp>
+#include <banjo/evaluation.hpp>
+
+#include <iostream>
+
+
+// Evaluate e with the virtual machine. The expression must compile.
+Value
+compiled(Context& cxt, Expr const& e)
+{
+  Function_code code(nullptr);
+  bool ok = compile_expression(cxt, e, code);
+  assert(ok);
+  Machine vm;
+  return vm(code, nullptr);
+}
+
+
+// Evaluate e with the tree-walking evaluator.
+Value
+interpreted(Expr const& e)
+{
+  Evaluator eval;
+  return eval(e);
+}
+
+
+// Check that both evaluators compute n.
+void
+check(Context& cxt, Expr const& e, Integer_value n)
+{
+  Integer_value a = compiled(cxt, e).get_integer();
+  Integer_value b = interpreted(e).get_integer();
+  assert(a == n);
+  assert(b == n);
+}
+
+
+// Check that both evaluators fail.
+void
+check_error(Context& cxt, Expr const& e)
+{
+  try {
+    compiled(cxt, e);
+    assert(false);
+  } catch (Evaluation_error&) {
+  }
+  try {
+    interpreted(e);
+    assert(false);
+  } catch (Evaluation_error&) {
+  }
+}
+
+
+// Returns the value of the object declared by d.
+Expr&
+load(Context& cxt, Object_decl& d)
+{
+  Builder& build = cxt;
+  Expr* ref;
+  if (Variable_decl* var = as<Variable_decl>(&d))
+    ref = &build.make_reference(*var);
+  else
+    ref = &build.make_reference(cast<Object_parm>(d));
+  return cxt.make<Value_conv>(d.type(), *ref);
+}
+
+
+// Returns a function with the given parameters and body, whose frame
+// has been allocated.
+Function_decl&
+make_function(Context& cxt, char const* name, Decl_list const& parms, Type& t, Stmt_list&& body)
+{
+  Builder& build = cxt;
+  Stmt& s = build.make_compound_statement(std::move(body));
+  Function_decl& f = build.make_function_declaration(build.get_id(name), parms, t, s);
+  allocate_frame(f);
+  return f;
+}
+
+
+// Arithmetic wraps on overflow, and the results of narrower types are
+// truncated to their precision.
+void
+test_wraparound()
+{
+  Context cxt;
+  Builder& build = cxt;
+  Type& i32 = build.get_integer_type(true, 32);
+  Type& i64 = build.get_integer_type(true, 64);
+
+  // def square(x: int32) -> int32 { return x * x; }
+  Object_parm& x = build.make_object_parm("x", i32);
+  Stmt_list body;
+  body.push_back(build.make_return_statement(build.make_mul(i32, load(cxt, x), load(cxt, x))));
+  Function_decl& f = make_function(cxt, "square", Decl_list{&x}, i32, std::move(body));
+  check(cxt, build.make_call(i32, f, Expr_list{&build.get_integer(i32, 65539)}), 393225);
+  check(cxt, build.make_call(i32, f, Expr_list{&build.get_integer(i32, 46341)}), -2147479015);
+
+  // (65536 * 65536) * (65536 * 65536) wraps to 0 in 64 bits.
+  Expr& k = build.get_integer(i64, 65536);
+  Expr& n = build.make_mul(i64, k, k);
+  check(cxt, build.make_mul(i64, n, n), 0);
+}
+
+
+// Integer conversions truncate to the precision of the destination.
+void
+test_narrowing()
+{
+  Context cxt;
+  Builder& build = cxt;
+  Type& i64 = build.get_integer_type(true, 64);
+  Type& u8 = build.get_integer_type(false, 8);
+  Type& s8 = build.get_integer_type(true, 8);
+
+  Expr& m1 = build.make_neg(i64, build.get_integer(i64, 1));
+  check(cxt, cxt.make<Integer_conv>(u8, m1), 255);
+  check(cxt, cxt.make<Integer_conv>(s8, build.get_integer(i64, 200)), -56);
+  check(cxt, cxt.make<Integer_conv>(u8, build.get_integer(i64, 256 + 7)), 7);
+}
+
+
+// Division by zero is an evaluation error.
+void
+test_division()
+{
+  Context cxt;
+  Builder& build = cxt;
+  Type& z = build.get_integer_type(true, 64);
+
+  // def div(a: int, b: int) -> int { return a / b; }
+  Object_parm& a = build.make_object_parm("a", z);
+  Object_parm& b = build.make_object_parm("b", z);
+  Stmt_list body;
+  body.push_back(build.make_return_statement(build.make_div(z, load(cxt, a), load(cxt, b))));
+  Function_decl& f = make_function(cxt, "div", Decl_list{&a, &b}, z, std::move(body));
+
+  check(cxt, build.make_call(z, f, Expr_list{&build.get_integer(z, 17), &build.get_integer(z, 5)}), 3);
+  check_error(cxt, build.make_call(z, f, Expr_list{&build.get_integer(z, 17), &build.get_integer(z, 0)}));
+  check_error(cxt, build.make_rem(z, build.get_integer(z, 1), build.get_integer(z, 0)));
+}
+
+
+// Break leaves a loop, and continue proceeds with the next iteration.
+void
+test_loops()
+{
+  Context cxt;
+  Builder& build = cxt;
+  Type& z = build.get_integer_type(true, 64);
+  Type& b = build.get_bool_type();
+
+  // def odds(k: int) -> int {
+  //   var s: int = 0;
+  //   var j: int = 0;
+  //   while (true) {
+  //     j = j + 1;
+  //     if (j > k) break;
+  //     if (j % 2 == 0) continue;
+  //     s = s + j;
+  //   }
+  //   return s;
+  // }
+  Object_parm& k = build.make_object_parm("k", z);
+  Variable_decl& s = build.make_variable_declaration("s", z, build.make_copy_init(z, build.get_integer(z, 0)));
+  Variable_decl& j = build.make_variable_declaration("j", z, build.make_copy_init(z, build.get_integer(z, 0)));
+  Expr& one = build.get_integer(z, 1);
+  Expr& two = build.get_integer(z, 2);
+  Expr& zero = build.get_integer(z, 0);
+
+  Stmt_list loop;
+  loop.push_back(build.make_expression_statement(
+    cxt.make<Assign_expr>(z, build.make_reference(j), build.make_add(z, load(cxt, j), one))));
+  loop.push_back(build.make_if_statement(
+    build.make_gt(b, load(cxt, j), load(cxt, k)), build.make_break_statement()));
+  loop.push_back(build.make_if_statement(
+    build.make_eq(b, build.make_rem(z, load(cxt, j), two), zero), build.make_continue_statement()));
+  loop.push_back(build.make_expression_statement(
+    cxt.make<Assign_expr>(z, build.make_reference(s), build.make_add(z, load(cxt, s), load(cxt, j)))));
+
+  Stmt_list body;
+  body.push_back(build.make_declaration_statement(s));
+  body.push_back(build.make_declaration_statement(j));
+  body.push_back(build.make_while_statement(build.get_true(), build.make_compound_statement(std::move(loop))));
+  body.push_back(build.make_return_statement(load(cxt, s)));
+  Function_decl& f = make_function(cxt, "odds", Decl_list{&k}, z, std::move(body));
+
+  check(cxt, build.make_call(z, f, Expr_list{&build.get_integer(z, 10)}), 25);
+  check(cxt, build.make_call(z, f, Expr_list{&build.get_integer(z, 99)}), 2500);
+}
+
+
+// Recursive calls.
+void
+test_recursion()
+{
+  Context cxt;
+  Builder& build = cxt;
+  Type& z = build.get_integer_type(true, 64);
+  Type& b = build.get_bool_type();
+
+  // def fib(n: int) -> int {
+  //   if (n < 2) return n;
+  //   else return fib(n - 1) + fib(n - 2);
+  // }
+  Object_parm& n = build.make_object_parm("n", z);
+  Function_decl& f = build.make_function_declaration(build.get_id("fib"), Decl_list{&n}, z, build.make_compound_statement(Stmt_list{}));
+  Expr& c1 = build.make_call(z, f, Expr_list{&build.make_sub(z, load(cxt, n), build.get_integer(z, 1))});
+  Expr& c2 = build.make_call(z, f, Expr_list{&build.make_sub(z, load(cxt, n), build.get_integer(z, 2))});
+  Stmt_list body;
+  body.push_back(build.make_if_statement(
+    build.make_lt(b, load(cxt, n), build.get_integer(z, 2)),
+    build.make_return_statement(load(cxt, n)),
+    build.make_return_statement(build.make_add(z, c1, c2))));
+  cast<Function_def>(f.definition()).stmt_ = &build.make_compound_statement(std::move(body));
+  allocate_frame(f);
+
+  check(cxt, build.make_call(z, f, Expr_list{&build.get_integer(z, 20)}), 6765);
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_wraparound();
+  test_narrowing();
+  test_division();
+  test_loops();
+  test_recursion();
+}
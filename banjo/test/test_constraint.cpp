@@ -3,6 +3,7 @@
 
 #include "test.hpp"
 
+#include <banjo/constraint.hpp>
 #include <banjo/normalization.hpp>
 #include <banjo/subsumption.hpp>
 
@@ -80,6 +81,97 @@ test_subsume_1(Context& cxt)
 }
 
 
+// Constraints are interned: equivalent constraints are the same object,
+// even when built from distinct expressions.
+void
+test_interning(Context& cxt)
+{
+  Builder build(cxt);
+
+  Type& b = build.get_bool_type();
+  Type& z = build.get_int_type();
+  Cons& p1 = build.get_predicate_constraint(build.get_integer(z, 1));
+  Cons& p2 = build.get_predicate_constraint(build.get_integer(z, 1));
+  Cons& p3 = build.get_predicate_constraint(build.get_integer(z, 2));
+  lingo_assert(&p1 == &p2);
+  lingo_assert(&p1 != &p3);
+
+  std::size_t n = cxt.cons.size();
+  Cons& c1 = build.get_conjunction_constraint(p1, p3);
+  Cons& c2 = build.get_conjunction_constraint(p2, p3);
+  Cons& c3 = build.get_conjunction_constraint(p3, p1);
+  lingo_assert(&c1 == &c2);
+  lingo_assert(&c1 != &c3);
+  lingo_assert(&build.get_disjunction_constraint(p1, p3) != &c1);
+  lingo_assert(cxt.cons.size() == n + 3);
+
+  Expr& e = build.make_and(b, build.get_integer(z, 1), build.get_integer(z, 2));
+  lingo_assert(&normalize(cxt, e) == &c1);
+}
+
+
+// Concept constraints are canonical, so each is expanded once.
+void
+test_expansion(Context& cxt)
+{
+  Builder build(cxt);
+
+  Concept_decl& c = make_concept_1(cxt);
+  Type_parm& p = build.make_type_parameter("U");
+  Type& t = build.get_typename_type(p);
+
+  Cons& c1 = normalize(cxt, build.make_check(c, {&t}));
+  Cons& c2 = normalize(cxt, build.make_check(c, {&t}));
+  lingo_assert(&c1 == &c2);
+
+  std::size_t n = cxt.expansions.hits();
+  Cons& e1 = expand(cxt, cast<Concept_cons>(c1));
+  Cons& e2 = expand(cxt, cast<Concept_cons>(c2));
+  lingo_assert(&e1 == &e2);
+  lingo_assert(cxt.expansions.hits() == n + 1);
+}
+
+
+// A sequent with several antecedents does not consult the cache of
+// proven subsumptions for each antecedent.
+void
+test_probes(Context& cxt)
+{
+  Builder build(cxt);
+
+  Type& b = build.get_bool_type();
+  Expr& e1 = build.make_and(b, build.get_int(1), build.get_int(2));
+  Expr& e2 = build.make_and(b, build.get_int(3), build.get_int(4));
+  Cons& a = normalize(cxt, build.make_and(b, e1, e2));
+  Cons& c = normalize(cxt, build.get_int(5));
+
+  std::size_t n = cxt.subsumed.misses();
+  lingo_assert(!subsumes(cxt, a, c));
+  lingo_assert(cxt.subsumed.misses() == n + 1);
+  lingo_assert(!subsumes(cxt, a, c));
+  lingo_assert(cxt.subsumed.misses() == n + 1);
+}
+
+
+// Membership in long lists of antecedents.
+void
+test_long(Context& cxt)
+{
+  Builder build(cxt);
+
+  Type& b = build.get_bool_type();
+  Expr* e = &build.get_int(0);
+  for (int i = 1; i < 200; ++i)
+    e = &build.make_and(b, *e, build.get_int(i));
+  Cons& a = normalize(cxt, *e);
+
+  lingo_assert(subsumes(cxt, a, normalize(cxt, build.get_int(0))));
+  lingo_assert(subsumes(cxt, a, normalize(cxt, build.get_int(137))));
+  lingo_assert(subsumes(cxt, a, normalize(cxt, build.get_int(199))));
+  lingo_assert(!subsumes(cxt, a, normalize(cxt, build.get_int(200))));
+}
+
+
 // This is GCC's bug 6756.
 void
 test_subsume_2(Context& cxt)
@@ -136,6 +228,10 @@ main(int argc, char* argv[])
 {
   Context cxt;
   test_canonical(cxt);
+  test_interning(cxt);
   test_subsume_1(cxt);
+  test_expansion(cxt);
+  test_probes(cxt);
+  test_long(cxt);
   test_subsume_2(cxt);
 }
@@ -0,0 +1,226 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/lexer.hpp>
+#include <banjo/parser.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+
+// Parse and elaborate text. The file is kept alive by f, since tokens
+// refer to it.
+Stmt&
+translate(Context& cxt, String const& text, std::unique_ptr<File>& f)
+{
+  char const* path = "test_elaborate.banjo";
+  {
+    std::ofstream os(path);
+    os << text;
+  }
+  f.reset(new File(path));
+  std::remove(path);
+
+  Token_buffer toks;
+  bool ok = lex_files(cxt, {f.get()}, toks, 1);
+  assert(ok);
+  Parser parse(cxt, toks);
+  return parse();
+}
+
+
+// Returns the body of the function named n in the translation s.
+Stmt&
+body(Stmt& s, char const* n)
+{
+  for (Stmt& s1 : cast<Translation_stmt>(s).statements()) {
+    if (Declaration_stmt* d = as<Declaration_stmt>(&s1)) {
+      if (Function_decl* f = as<Function_decl>(&d->declaration())) {
+        if (cast<Simple_id>(f->name()).symbol().spelling() == n)
+          return cast<Function_def>(f->definition()).statement();
+      }
+    }
+  }
+  lingo_unreachable();
+}
+
+
+// Returns the printed form of s.
+String
+print(Stmt const& s)
+{
+  std::stringstream ss;
+  ss << s;
+  return ss.str();
+}
+
+
+// Returns a translation of n functions, each of which calls the one
+// before it.
+String
+make_chain(int n)
+{
+  String text = "def f0(x : int) -> int { return x; }\n";
+  for (int i = 1; i < n; ++i) {
+    text += "def f" + std::to_string(i) + "(x : int) -> int { ";
+    text += "return f" + std::to_string(i - 1) + "(x) + " + std::to_string(i) + "; }\n";
+  }
+  return text;
+}
+
+
+// Elaborating function bodies on several threads gives the same
+// translation as elaborating them on one.
+void
+test_parallel()
+{
+  String text = make_chain(40);
+
+  Context c1;
+  std::unique_ptr<File> f1;
+  Stmt& s1 = translate(c1, text, f1);
+
+  Context c2;
+  c2.jobs = 4;
+  std::unique_ptr<File> f2;
+  Stmt& s2 = translate(c2, text, f2);
+
+  assert(c2.arenas.size() == 4);
+  for (int i = 0; i < 40; ++i) {
+    String n = "f" + std::to_string(i);
+    assert(!is<Unparsed_stmt>(&body(s2, n.c_str())));
+  }
+  assert(print(s1).find("f38(x)") != String::npos);
+  assert(print(s1) == print(s2));
+}
+
+
+// Buffers count errors, and discarding buffers do not keep messages.
+void
+test_buffers()
+{
+  Diagnostic_buffer b1;
+  b1.put(error_diag, Location(), "e{}", 1);
+  b1.put(warning_diag, Location(), "w{}", 2);
+  Diagnostic_buffer b2;
+  b2.put(error_diag, Location(), "e{}", 3);
+  b1.append(b2);
+  assert(b2.empty());
+  assert(b1.errors() == 2);
+  assert(b1.diags.size() == 3);
+  assert(b1.diags[0].msg == "e1");
+  assert(b1.diags[2].msg == "e3");
+
+  Diagnostic_buffer b3(true);
+  b3.put(error_diag, Location(), "e{}", 4);
+  assert(b3.errors() == 1);
+  assert(b3.empty());
+}
+
+
+// Translate text with the given number of jobs, buffering diagnostics
+// in diags. Returns the kind of error thrown, if any.
+char const*
+translate_errors(String const& text, int jobs, Diagnostic_buffer& diags)
+{
+  Context cxt;
+  cxt.jobs = jobs;
+  std::unique_ptr<File> f;
+  Buffer_diagnostics buffer(cxt, diags);
+  try {
+    translate(cxt, text, f);
+  } catch (Declaration_error&) {
+    return "declaration";
+  } catch (Lookup_error&) {
+    return "lookup";
+  }
+  return "none";
+}
+
+
+// When several definitions fail, the diagnostics and the error of the
+// first one, in source order, are reported, regardless of the order in
+// which the definitions were elaborated.
+void
+test_errors()
+{
+  String text;
+  String tail;
+  for (int i = 0; i < 40; ++i) {
+    String n = std::to_string(i);
+    String def = "def f" + n + "(x : int) -> int { ";
+    if (i == 5)
+      def += "var a : int = 0; var a : int = 1; ";
+    if (i == 25)
+      def += "return y; ";
+    def += "return x; }\n";
+    text += def;
+    if (i > 5)
+      tail += def;
+  }
+
+  // Without the first failure, the second is reported.
+  Diagnostic_buffer d0;
+  assert(String(translate_errors(tail, 4, d0)) == "lookup");
+
+  Diagnostic_buffer d1;
+  String e1 = translate_errors(text, 1, d1);
+  assert(e1 == "declaration");
+  assert(d1.errors() == 1);
+  for (int jobs = 2; jobs <= 8; jobs *= 2) {
+    Diagnostic_buffer d2;
+    assert(translate_errors(text, jobs, d2) == e1);
+    assert(d2.errors() == d1.errors());
+    assert(d2.diags.size() == d1.diags.size());
+    assert(d2.diags[0].msg == d1.diags[0].msg);
+  }
+}
+
+
+// With lazy elaboration, only the bodies of functions that are
+// referenced (and of main) are elaborated. Errors in the others are
+// not diagnosed.
+void
+test_lazy()
+{
+  String text =
+    "def unused(x : int) -> int { return undeclared; }\n"
+    "def h(x : int) -> int { return x; }\n"
+    "def g(x : int) -> int { return h(x) + 1; }\n"
+    "def main() -> int { return g(1); }\n";
+
+  Context cxt;
+  cxt.lazy = true;
+  std::unique_ptr<File> f;
+  Stmt& s = translate(cxt, text, f);
+  assert(is<Unparsed_stmt>(&body(s, "unused")));
+  assert(!is<Unparsed_stmt>(&body(s, "h")));
+  assert(!is<Unparsed_stmt>(&body(s, "g")));
+  assert(!is<Unparsed_stmt>(&body(s, "main")));
+  assert(cxt.deferred.empty());
+
+  // Eagerly, the unused function fails.
+  Context c2;
+  std::unique_ptr<File> f2;
+  try {
+    translate(c2, text, f2);
+    assert(false);
+  } catch (Lookup_error&) {
+  }
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_parallel();
+  test_buffers();
+  test_errors();
+  test_lazy();
+}
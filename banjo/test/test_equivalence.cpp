@@ -23,8 +23,43 @@ test_types()
 }
 
 
+// Types built from the same components are the same object, so
+// equivalence is identity.
+void
+test_canonical()
+{
+  Context cxt;
+  Builder& build = cxt;
+  Type& z = build.get_int_type();
+  Type& b = build.get_bool_type();
+
+  assert(&build.get_int_type() == &z);
+  assert(&build.get_integer_type(true, 32) == &z);
+  assert(&build.get_integer_type(false, 32) != &z);
+  assert(&build.get_pointer_type(z) == &build.get_pointer_type(z));
+  assert(&build.get_reference_type(build.get_const_type(z)) ==
+         &build.get_reference_type(build.get_const_type(z)));
+  assert(&build.get_function_type(Type_list{&z, &b}, z) ==
+         &build.get_function_type(Type_list{&z, &b}, z));
+  assert(&build.get_function_type(Type_list{&z, &b}, z) !=
+         &build.get_function_type(Type_list{&b, &z}, z));
+  assert(&build.get_tuple_type(Type_list{&z, &b}) ==
+         &build.get_tuple_type(Type_list{&z, &b}));
+
+  // Array extents are compared structurally.
+  Type& a1 = build.get_array_type(z, build.get_integer(z, 4));
+  Type& a2 = build.get_array_type(z, build.get_integer(z, 4));
+  Type& a3 = build.get_array_type(z, build.get_integer(z, 5));
+  assert(&a1 == &a2);
+  assert(&a1 != &a3);
+  assert(is_equivalent(a1, a2));
+  assert(!is_equivalent(a1, a3));
+}
+
+
 int
 main(int argc, char* argv[])
 {
   test_types();
+  test_canonical();
 }
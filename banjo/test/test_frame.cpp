@@ -0,0 +1,139 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/evaluation.hpp>
+
+#include <iostream>
+
+
+// Returns the value of the object declared by d.
+Expr&
+load(Context& cxt, Object_decl& d)
+{
+  Builder& build = cxt;
+  Expr* ref;
+  if (Variable_decl* var = as<Variable_decl>(&d))
+    ref = &build.make_reference(*var);
+  else
+    ref = &build.make_reference(cast<Object_parm>(d));
+  return cxt.make<Value_conv>(d.type(), *ref);
+}
+
+
+// Returns a statement that assigns e to v.
+Stmt&
+assign(Context& cxt, Variable_decl& v, Expr& e)
+{
+  Builder& build = cxt;
+  return build.make_expression_statement(
+    cxt.make<Assign_expr>(v.type(), build.make_reference(v), e));
+}
+
+
+// Parameters are allocated first, then local variables in order of
+// declaration. Sibling blocks share slots, so the frame is as large as
+// the deepest nesting of declarations.
+void
+test_slots()
+{
+  Context cxt;
+  Builder& build = cxt;
+  Type& z = build.get_int_type();
+
+  // def f(a : int, b : int) -> int {
+  //   var x : int = a + b;
+  //   { var y : int = x * 2; x = y; }
+  //   { var u : int = x + 1; var w : int = u + 1; x = w; }
+  //   return x;
+  // }
+  Object_parm& a = build.make_object_parm("a", z);
+  Object_parm& b = build.make_object_parm("b", z);
+  Variable_decl& x = build.make_variable_declaration("x", z,
+    build.make_copy_init(z, build.make_add(z, load(cxt, a), load(cxt, b))));
+  Variable_decl& y = build.make_variable_declaration("y", z,
+    build.make_copy_init(z, build.make_mul(z, load(cxt, x), build.get_integer(z, 2))));
+  Variable_decl& u = build.make_variable_declaration("u", z,
+    build.make_copy_init(z, build.make_add(z, load(cxt, x), build.get_integer(z, 1))));
+  Variable_decl& w = build.make_variable_declaration("w", z,
+    build.make_copy_init(z, build.make_add(z, load(cxt, u), build.get_integer(z, 1))));
+
+  Stmt_list b1;
+  b1.push_back(build.make_declaration_statement(y));
+  b1.push_back(assign(cxt, x, load(cxt, y)));
+  Stmt_list b2;
+  b2.push_back(build.make_declaration_statement(u));
+  b2.push_back(build.make_declaration_statement(w));
+  b2.push_back(assign(cxt, x, load(cxt, w)));
+  Stmt_list body;
+  body.push_back(build.make_declaration_statement(x));
+  body.push_back(build.make_compound_statement(std::move(b1)));
+  body.push_back(build.make_compound_statement(std::move(b2)));
+  body.push_back(build.make_return_statement(load(cxt, x)));
+  Function_decl& f = build.make_function_declaration(build.get_id("f"),
+    Decl_list{&a, &b}, z, build.make_compound_statement(std::move(body)));
+
+  assert(f.frame_size() == -1);
+  assert(x.slot() == -1);
+  assert(allocate_frame(f) == 5);
+  assert(f.frame_size() == 5);
+  assert(a.slot() == 0);
+  assert(b.slot() == 1);
+  assert(x.slot() == 2);
+  assert(y.slot() == 3);
+  assert(u.slot() == 3);
+  assert(w.slot() == 4);
+
+  Evaluator eval;
+  Expr& call = build.make_call(z, f, Expr_list{&build.get_integer(z, 2), &build.get_integer(z, 3)});
+  assert(eval(call).get_integer() == 12);
+  assert(eval.frame == nullptr);
+}
+
+
+// Frames that do not fit in the current block are allocated in the
+// next, and frames below them do not move. Popped frames are reset.
+void
+test_stack()
+{
+  Frame_stack s;
+  std::size_t n = Frame_stack::block_size - 10;
+  Value* f1 = s.push(n);
+  f1[0] = 1;
+  f1[n - 1] = 2;
+  Value* f2 = s.push(20);
+  assert(s.blocks.size() == 2);
+  assert(f2 == s.blocks[1].data.get());
+  f2[0] = 3;
+  assert(f1[0].get_integer() == 1);
+  assert(f1[n - 1].get_integer() == 2);
+
+  s.pop();
+  assert(s.blocks[1].used == 0);
+  Value* f3 = s.push(5);
+  assert(f3 == f1 + n);
+  assert(f3[0].is_error());
+  s.pop();
+  s.pop();
+  assert(s.marks.empty());
+  assert(s.blocks[0].used == 0);
+  assert(f1[0].is_error());
+
+  // A frame larger than a block replaces an unused block that is too
+  // small for it.
+  Value* f4 = s.push(2 * Frame_stack::block_size);
+  assert(s.blocks.size() == 2);
+  assert(f4 == s.blocks[1].data.get());
+  assert(s.blocks[1].size == 2 * Frame_stack::block_size);
+  f4[2 * Frame_stack::block_size - 1] = 4;
+  s.pop();
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_slots();
+  test_stack();
+}
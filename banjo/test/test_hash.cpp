@@ -35,8 +35,39 @@ test_types()
 }
 
 
+// Hashes are cached when first computed. Assigning the type of an
+// expression does not affect its hash, and copies do not share the
+// cached hash.
+void
+test_cache()
+{
+  Context cxt;
+  Builder& build = cxt;
+  Type& z = build.get_int_type();
+  Type& b = build.get_bool_type();
+
+  Expr& e1 = build.make_add(z, build.get_integer(z, 1), build.get_integer(z, 2));
+  Expr& e2 = build.make_add(z, build.get_integer(z, 1), build.get_integer(z, 2));
+  assert(e1.hash == 0);
+  std::size_t h = hash_value(e1);
+  assert(h != 0);
+  assert(e1.hash == h);
+  assert(hash_value(e2) == h);
+
+  e1.type_ = &b;
+  assert(hash_value(e1) == h);
+
+  Integer_type t(true, 64);
+  assert(hash_value(t) != 0);
+  Integer_type t1(t);
+  assert(t1.hash == 0);
+  assert(hash_value(t1) == hash_value(t));
+}
+
+
 int
 main(int argc, char* argv[])
 {
   test_types();
+  test_cache();
 }
@@ -0,0 +1,124 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/incremental.hpp>
+
+#include <cstdio>
+#include <iostream>
+
+
+Function_decl&
+make_function(Context& cxt, char const* name, Type& p, Type& r)
+{
+  Builder& build = cxt;
+  Decl_list parms {&build.make_object_parm("p", p)};
+  Stmt& body = build.make_compound_statement(Stmt_list{});
+  return build.make_function_declaration(build.get_id(name), parms, r, body);
+}
+
+
+// Overloads are keyed by their signatures, so reordering declarations
+// does not make them stale.
+void
+test_overloads()
+{
+  Context cxt;
+  Builder& build = cxt;
+  Type& z = build.get_int_type();
+  Type& b = build.get_bool_type();
+  Function_decl& f1 = make_function(cxt, "f", z, z);
+  Function_decl& f2 = make_function(cxt, "f", b, z);
+
+  Decl_tracker t1;
+  t1.declare(f1, 1);
+  t1.declare(f2, 2);
+  Decl_tracker t2;
+  t2.declare(f2, 2);
+  t2.declare(f1, 1);
+
+  Decl_cache c1 = make_decl_cache(t1);
+  Decl_cache c2 = make_decl_cache(t2);
+  assert(c1.size() == 2);
+  assert(get_stale_declarations(c1, c2).empty());
+
+  // Changing the tokens of one overload makes only that one stale.
+  Decl_tracker t3;
+  t3.declare(f2, 3);
+  t3.declare(f1, 1);
+  std::vector<String> stale = get_stale_declarations(c1, make_decl_cache(t3));
+  assert(stale.size() == 1);
+  assert(c1.decls.at(stale[0]).tokens == 2);
+}
+
+
+// A declaration is stale if the interface of a declaration it uses
+// changes.
+void
+test_uses()
+{
+  Context cxt;
+  Builder& build = cxt;
+  Type& z = build.get_int_type();
+  Type& b = build.get_bool_type();
+  Variable_decl& v1 = build.make_variable_declaration("v", z, build.get_integer(z, 0));
+  Variable_decl& v2 = build.make_variable_declaration("v", b, build.get_true());
+  Function_decl& f = make_function(cxt, "f", z, z);
+  Function_decl& g = make_function(cxt, "g", z, z);
+
+  Decl_tracker t1;
+  t1.declare(v1, 1);
+  t1.declare(f, 2);
+  t1.declare(g, 3);
+  t1.use(f, v1);
+  Decl_cache c1 = make_decl_cache(t1);
+
+  Decl_tracker t2;
+  t2.declare(v2, 4);
+  t2.declare(f, 2);
+  t2.declare(g, 3);
+  t2.use(f, v2);
+  std::vector<String> stale = get_stale_declarations(c1, make_decl_cache(t2));
+  assert(stale.size() == 2);
+  for (String const& k : stale) {
+    Decl_fingerprint const& fp = c1.decls.at(k);
+    assert(fp.tokens == 1 || fp.tokens == 2);
+  }
+}
+
+
+// A cache survives a round trip through a file.
+void
+test_file()
+{
+  Context cxt;
+  Builder& build = cxt;
+  Type& z = build.get_int_type();
+  Function_decl& f = make_function(cxt, "f", z, z);
+  Function_decl& g = make_function(cxt, "g", z, z);
+
+  Decl_tracker t;
+  t.declare(f, 1);
+  t.declare(g, 2);
+  t.use(g, f);
+  Decl_cache c1 = make_decl_cache(t);
+
+  char const* path = "test_incremental.cache";
+  assert(c1.save(path));
+  Decl_cache c2;
+  assert(c2.load(path));
+  std::remove(path);
+
+  assert(c2.size() == c1.size());
+  assert(get_stale_declarations(c2, c1).empty());
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_overloads();
+  test_uses();
+  test_file();
+}
@@ -51,8 +51,8 @@ main(int argc, char* argv[])
   }
 
   File input(argv[1]);
-  Character_stream cs(input);
-  Token_stream ts;
+  Input_stream cs(input);
+  Token_buffer ts;
   Lexer lex(cxt, cs, ts);
   Parser parse(cxt, ts);
 
@@ -0,0 +1,85 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/intern.hpp>
+#include <banjo/token.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Keywords are found in the symbol table. Unknown spellings are not
+// interned by lookup.
+void
+test_lookup()
+{
+  Context cxt;
+  Intern_table& tab = cxt.spellings();
+  Symbol const* var = tab.get("var");
+  assert(var);
+  assert(var->spelling() == "var");
+  assert(tab.get("var") == var);
+  assert(tab.put_identifier("var") == var);
+
+  std::size_t n = tab.size();
+  assert(!tab.get("unknown"));
+  assert(tab.size() == n);
+
+  // The table keeps its own copy of the spelling.
+  Symbol const* x;
+  {
+    String s = "xyz";
+    x = tab.put_identifier(s);
+  }
+  assert(tab.get("xyz") == x);
+  assert(tab.size() == n + 1);
+}
+
+
+// Threads interning the same spellings in different orders get the
+// same symbols, and each spelling is interned once.
+void
+test_threads()
+{
+  Context cxt;
+  Intern_table& tab = cxt.spellings();
+  std::size_t n = tab.size();
+
+  int const count = 2000;
+  std::vector<String> spellings;
+  for (int i = 0; i < count; ++i)
+    spellings.push_back("s" + std::to_string(i));
+
+  int const threads = 8;
+  std::vector<std::vector<Symbol const*>> results(threads, std::vector<Symbol const*>(count));
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; ++t) {
+    pool.emplace_back([&, t]() {
+      for (int k = 0; k < count; ++k) {
+        int i = (k * 7 + t * 131) % count;
+        results[t][i] = tab.put_identifier(spellings[i]);
+      }
+    });
+  }
+  for (std::thread& t : pool)
+    t.join();
+
+  for (int t = 1; t < threads; ++t)
+    assert(results[t] == results[0]);
+  for (int i = 0; i < count; ++i)
+    assert(results[0][i]->spelling() == spellings[i]);
+  assert(tab.size() == n + count);
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_lookup();
+  test_threads();
+}
@@ -0,0 +1,174 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/lexer.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+// Write text to a file at path.
+void
+write_file(char const* path, char const* text)
+{
+  std::ofstream os(path);
+  os << text;
+}
+
+
+// Lex the file into toks.
+void
+lex_file(Context& cxt, File& file, Token_buffer& toks)
+{
+  Input_stream cs(file);
+  Lexer lex(cxt, cs, toks);
+  lex();
+}
+
+
+// Spellings are viewed in the input buffer and interned once, so equal
+// spellings have the same symbol, within and across files.
+void
+test_spellings()
+{
+  Context cxt;
+  char const* p1 = "test_lex_1.banjo";
+  char const* p2 = "test_lex_2.banjo";
+  write_file(p1, "var x : int = 42; // x\nx y x 42");
+  write_file(p2, "y\tx\n  42");
+
+  File f1(p1);
+  File f2(p2);
+  Token_buffer t1;
+  lex_file(cxt, f1, t1);
+  Token_buffer t2;
+  lex_file(cxt, f2, t2);
+  std::remove(p1);
+  std::remove(p2);
+
+  assert(t1.size() == 11);
+  assert(t1.kind(0) == var_tok);
+  assert(t1.kind(1) == identifier_tok);
+  assert(t1.kind(5) == integer_tok);
+  assert(t1.kind(6) == semicolon_tok);
+
+  Symbol const* x = t1.peek(1).symbol();
+  assert(x->spelling() == "x");
+  assert(t1.peek(7).symbol() == x);
+  assert(t1.peek(9).symbol() == x);
+  assert(t1.peek(8).symbol() != x);
+  assert(t1.peek(10).symbol() == t1.peek(5).symbol());
+
+  assert(t2.size() == 3);
+  assert(t2.peek(0).symbol() == t1.peek(8).symbol());
+  assert(t2.peek(1).symbol() == x);
+  assert(t2.peek(2).symbol() == t1.peek(5).symbol());
+}
+
+
+// Tokens record the offsets of their spellings. Appending a buffer
+// keeps the file of each token, and the symbol of each token.
+void
+test_records()
+{
+  Context cxt;
+  char const* p1 = "test_lex_3.banjo";
+  char const* p2 = "test_lex_4.banjo";
+  write_file(p1, "var x : int = 42; // x\nx y x 42");
+  write_file(p2, "y\tx\n  42");
+  File f1(p1);
+  File f2(p2);
+  Token_buffer t1;
+  lex_file(cxt, f1, t1);
+  Token_buffer t2;
+  lex_file(cxt, f2, t2);
+  std::remove(p1);
+  std::remove(p2);
+
+  static_assert(sizeof(Token_rec) <= 12, "token records are not compact");
+  assert(t1.toks[0].off == 0);
+  assert(t1.toks[1].off == 4);
+  assert(t1.toks[7].off == 23);
+  assert(t1.toks[10].off == 29);
+  assert(t2.toks[2].off == 6);
+
+  Token_buffer t3;
+  t3.append(t1);
+  t3.append(t2);
+  assert(t3.size() == 14);
+  assert(t3.runs.size() == 2);
+  assert(t3.runs[1].first == 11);
+  assert(t3.runs[1].file == &f2);
+  for (std::size_t i = 0; i < t1.size(); ++i)
+    assert(&t3.symbol(i) == &t1.symbol(i));
+  for (std::size_t i = 0; i < t2.size(); ++i) {
+    assert(&t3.symbol(11 + i) == &t2.symbol(i));
+    assert(t3.toks[11 + i].off == t2.toks[i].off);
+  }
+
+  // Tokens that were not lexed keep their locations in the buffer.
+  Token_seq seq {t3.peek(0), t3.peek(12)};
+  Token_buffer t4(seq);
+  assert(t4.runs.size() == 1);
+  assert(t4.runs[0].file == nullptr);
+  assert(t4.locs.size() == 2);
+  assert(t4.kind(0) == var_tok);
+  assert(t4.peek(1).symbol() == t1.peek(1).symbol());
+}
+
+
+// Lexing files on several threads yields the same buffer as lexing
+// them on one thread.
+void
+test_parallel()
+{
+  Context cxt;
+  std::vector<String> paths;
+  std::vector<File*> files;
+  for (int i = 0; i < 8; ++i) {
+    String path = "test_lex_p" + std::to_string(i) + ".banjo";
+    String text;
+    for (int j = 0; j <= i * 50; ++j)
+      text += "var x" + std::to_string(j % 7) + " : int = " + std::to_string(i + j) + ";\n";
+    write_file(path.c_str(), text.c_str());
+    paths.push_back(path);
+    files.push_back(new File(path));
+  }
+
+  Token_buffer t1;
+  assert(lex_files(cxt, files, t1, 1));
+  for (int n = 2; n <= 8; n *= 2) {
+    Token_buffer t2;
+    assert(lex_files(cxt, files, t2, n));
+    assert(t2.size() == t1.size());
+    for (std::size_t i = 0; i < t1.size(); ++i) {
+      assert(t2.toks[i].kind == t1.toks[i].kind);
+      assert(t2.toks[i].off == t1.toks[i].off);
+      assert(&t2.symbol(i) == &t1.symbol(i));
+    }
+    assert(t2.runs.size() == files.size());
+    for (std::size_t i = 0; i < files.size(); ++i) {
+      assert(t2.runs[i].first == t1.runs[i].first);
+      assert(t2.runs[i].file == files[i]);
+    }
+  }
+
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    delete files[i];
+    std::remove(paths[i].c_str());
+  }
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_spellings();
+  test_records();
+  test_parallel();
+}
@@ -0,0 +1,149 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/bytecode.hpp>
+#include <banjo/evaluation.hpp>
+
+#include <iostream>
+
+
+// When a set is full, the least recently used entry is evicted.
+void
+test_eviction()
+{
+  Call_memo memo(Call_memo::ways);
+  assert(memo.capacity() == Call_memo::ways);
+
+  Function_code f(nullptr);
+  f.parms = 1;
+  Value v;
+  for (Integer_value n = 0; n < 4; ++n) {
+    Call_memo::Key k = {n};
+    memo.save(f, k, Value(n * n));
+  }
+  assert(memo.size() == 4);
+  assert(memo.evictions() == 0);
+
+  // Use the first entry so that the second is the oldest.
+  Call_memo::Key k0 = {0};
+  assert(memo.find(f, k0, v));
+
+  Call_memo::Key k4 = {4};
+  memo.save(f, k4, Value(16));
+  assert(memo.size() == 4);
+  assert(memo.evictions() == 1);
+
+  Call_memo::Key k1 = {1};
+  assert(!memo.find(f, k1, v));
+  assert(memo.find(f, k0, v));
+  assert(v.get_integer() == 0);
+  assert(memo.find(f, k4, v));
+  assert(v.get_integer() == 16);
+}
+
+
+// Only the arguments of the callee's parameters are part of the key.
+void
+test_arguments()
+{
+  Call_memo memo;
+
+  Function_code f(nullptr);
+  f.parms = 2;
+  Call_memo::Key k1 = {1, 2, 3, 4};
+  Call_memo::Key k2 = {1, 2, 5, 6};
+  Call_memo::Key k3 = {1, 3, 3, 4};
+  memo.save(f, k1, Value(3));
+
+  Value v;
+  assert(memo.find(f, k2, v));
+  assert(v.get_integer() == 3);
+  assert(!memo.find(f, k3, v));
+
+  // The same arguments to a different function do not match.
+  Function_code g(nullptr);
+  g.parms = 2;
+  assert(!memo.find(g, k1, v));
+}
+
+
+// Returns the function:
+//
+//    def f(a1: int, ..., an: int) -> int { return a1 + ... + an; }
+Function_decl&
+make_sum(Context& cxt, int n)
+{
+  Builder& build = cxt;
+  Type& z = build.get_integer_type(true, 64);
+  Decl_list parms;
+  Expr* e = &build.get_integer(z, 0);
+  for (int i = 0; i < n; ++i) {
+    Object_parm& p = build.make_object_parm("a", z);
+    parms.push_back(p);
+    e = &build.make_add(z, *e, cxt.make<Value_conv>(z, build.make_reference(p)));
+  }
+  Stmt_list body;
+  body.push_back(build.make_return_statement(*e));
+  Stmt& s = build.make_compound_statement(std::move(body));
+  Function_decl& f = build.make_function_declaration(build.get_id("f"), parms, z, s);
+  allocate_frame(f);
+  return f;
+}
+
+
+// Returns a call to f with the arguments 1 through n.
+Expr&
+make_call(Context& cxt, Function_decl& f, int n)
+{
+  Builder& build = cxt;
+  Type& z = build.get_integer_type(true, 64);
+  Expr_list args;
+  for (int i = 1; i <= n; ++i)
+    args.push_back(build.get_integer(z, i));
+  return build.make_call(z, f, args);
+}
+
+
+// Repeated compile-time calls are answered from the context's cache.
+void
+test_calls()
+{
+  Context cxt;
+
+  Function_decl& f = make_sum(cxt, 2);
+  Expr& e = make_call(cxt, f, 2);
+  assert(evaluate(cxt, e).get_integer() == 3);
+  assert(cxt.calls.hits() == 0);
+  assert(cxt.calls.size() == 1);
+  assert(evaluate(cxt, e).get_integer() == 3);
+  assert(cxt.calls.hits() == 1);
+}
+
+
+// Calls with more than max_args arguments bypass the cache.
+void
+test_bypass()
+{
+  Context cxt;
+
+  int n = Call_memo::max_args + 1;
+  Function_decl& f = make_sum(cxt, n);
+  Expr& e = make_call(cxt, f, n);
+  assert(evaluate(cxt, e).get_integer() == n * (n + 1) / 2);
+  assert(evaluate(cxt, e).get_integer() == n * (n + 1) / 2);
+  assert(cxt.calls.size() == 0);
+  assert(cxt.calls.hits() == 0);
+  assert(cxt.calls.misses() == 0);
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_eviction();
+  test_arguments();
+  test_calls();
+  test_bypass();
+}
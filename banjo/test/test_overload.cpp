@@ -0,0 +1,110 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/lookup.hpp>
+#include <banjo/overload.hpp>
+#include <banjo/scope.hpp>
+
+#include <iostream>
+#include <vector>
+
+
+// Returns n new variables named x.
+std::vector<Decl*>
+make_vars(Context& cxt, int n)
+{
+  Builder& build = cxt;
+  Type& z = build.get_int_type();
+  std::vector<Decl*> ds;
+  for (int i = 0; i < n; ++i)
+    ds.push_back(&build.make_variable_declaration("x", z, build.get_integer(z, i)));
+  return ds;
+}
+
+
+// Returns the declarations in s.
+template<typename S>
+std::vector<Decl*>
+elements(S const& s)
+{
+  std::vector<Decl*> ds;
+  for (auto i = s.begin(); i != s.end(); ++i)
+    ds.push_back(&const_cast<Decl&>(*i));
+  return ds;
+}
+
+
+// Small sets are stored inline. Insertion past the inline capacity
+// moves the declarations to the heap, in order.
+void
+test_insert()
+{
+  Context cxt;
+  std::vector<Decl*> ds = make_vars(cxt, 5);
+  Overload_set ovl(*ds[0]);
+  for (std::size_t i = 1; i < Overload_set::inline_size; ++i)
+    ovl.insert(*ds[i]);
+  assert(ovl.data == ovl.local);
+
+  for (std::size_t i = Overload_set::inline_size; i < ds.size(); ++i)
+    ovl.insert(*ds[i]);
+  assert(ovl.data != ovl.local);
+  assert(ovl.size() == 5);
+  assert(&ovl.front() == ds[0]);
+  assert(&ovl.back() == ds[4]);
+  assert(elements(ovl) == ds);
+
+  // Copies do not share storage.
+  Overload_set c1(ovl);
+  assert(c1.data != ovl.data);
+  assert(elements(c1) == ds);
+  Overload_set small(*ds[0]);
+  Overload_set c2(small);
+  assert(c2.data == c2.local);
+  assert(elements(c2) == elements(small));
+}
+
+
+// Lookup returns a view of the bound set, which sees declarations
+// added after the lookup. A failed lookup throws.
+void
+test_view()
+{
+  Context cxt;
+  std::vector<Decl*> ds = make_vars(cxt, 4);
+  Scope s;
+  Enter_scope scope(cxt, s);
+  Overload_set& ovl = s.bind(*ds[0]);
+
+  Overload_view v = unqualified_lookup(cxt, ds[0]->name());
+  assert(v.set() == &ovl);
+  assert(v.size() == 1);
+  assert(&v.front() == ds[0]);
+
+  for (int i = 1; i < 4; ++i)
+    ovl.insert(*ds[i]);
+  assert(v.size() == 4);
+  assert(&v.back() == ds[3]);
+  assert(elements(v) == ds);
+
+  Overload_view empty;
+  assert(empty.empty());
+  assert(empty.begin() == empty.end());
+
+  Builder& build = cxt;
+  try {
+    unqualified_lookup(cxt, build.get_id("y"));
+    assert(false);
+  } catch (Lookup_error&) {
+  }
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_insert();
+  test_view();
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/declaration.hpp>
+#include <banjo/normalization.hpp>
+#include <banjo/satisfaction.hpp>
+
+#include <iostream>
+
+
+// Returns an empty class named n.
+Class_decl&
+make_class(Context& cxt, char const* n)
+{
+  Builder& build = cxt;
+  Stmt& body = build.make_compound_statement(Stmt_list{});
+  return build.make_class_declaration(build.get_id(n), build.get_type_type(), body);
+}
+
+
+// Returns true if the result of satisfying c is cached.
+bool
+is_cached(Context& cxt, Cons& c)
+{
+  Satisfaction s;
+  return cxt.satisfied.find(&c, s);
+}
+
+
+// Declarations discard only the results that depend on their names
+// or on the classes that they are members of.
+void
+test_invalidation()
+{
+  Context cxt;
+  Builder& build = cxt;
+  Type& z = build.get_int_type();
+
+  // concept C1<T> = true;
+  Type_parm& p = build.make_type_parameter("T");
+  Concept_decl& c = build.make_concept("C1", {&p}, build.get_true());
+  Class_decl& s = make_class(cxt, "S");
+  Class_decl& u = make_class(cxt, "U");
+
+  Cons& c1 = normalize(cxt, build.make_check(c, {&build.get_class_type(s)}));
+  Cons& c2 = normalize(cxt, build.make_check(c, {&build.get_class_type(u)}));
+  assert(is_satisfied(cxt, c1));
+  assert(is_satisfied(cxt, c2));
+  assert(is_cached(cxt, c1));
+  assert(is_cached(cxt, c2));
+
+  // A local variable and an unrelated function change nothing.
+  Scope global;
+  Scope block(global);
+  declare(cxt, block, build.make_variable_declaration("x", z, build.get_integer(z, 0)));
+  Decl_list parms;
+  Stmt& body = build.make_compound_statement(Stmt_list{});
+  declare(cxt, global, build.make_function_declaration(build.get_id("f"), parms, z, body));
+  assert(is_cached(cxt, c1));
+  assert(is_cached(cxt, c2));
+
+  // A member of S discards only the result for S.
+  declare(cxt, cxt.saved_scope(s), build.make_field_declaration(build.get_id("m"), z));
+  assert(!is_cached(cxt, c1));
+  assert(is_cached(cxt, c2));
+
+  // So does a base class of U.
+  declare(cxt, cxt.saved_scope(u), build.make_super_declaration(build.get_class_type(s)));
+  assert(!is_cached(cxt, c2));
+
+  // Recomputed results depend on the concept's name.
+  assert(is_satisfied(cxt, c1));
+  assert(is_satisfied(cxt, c2));
+  std::size_t n = cxt.satisfied.size();
+  cxt.satisfied.invalidate(build.get_id("V"));
+  assert(cxt.satisfied.size() == n);
+  cxt.satisfied.invalidate(build.get_id("C1"));
+  assert(!is_cached(cxt, c1));
+  assert(!is_cached(cxt, c2));
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_invalidation();
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/scan.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <random>
+
+
+// Each scanner stops at the first character outside its class.
+void
+test_classes()
+{
+  Scanner_set const& s = get_scalar_scanners();
+  char const* str = " \t\r\n x_1y+9 // c\n";
+  char const* end = str + std::strlen(str);
+  assert(s.space(str, end) == str + 5);
+  assert(s.identifier(str + 5, end) == str + 9);
+  assert(s.digits(str + 10, end) == str + 11);
+  assert(s.line(str + 12, end) == str + 16);
+  assert(s.line(str + 17, end) == end);
+  assert(s.space(end, end) == end);
+}
+
+
+// The scanners for the host processor agree with the scalar scanners
+// at every offset and length, so that runs crossing vector boundaries
+// are handled.
+void
+test_agreement()
+{
+  Scanner_set const& fast = get_scanners();
+  Scanner_set const& slow = get_scalar_scanners();
+  std::cout << "scanners: " << fast.name << '\n';
+
+  char const alphabet[] = " \t\n\r\vaz_Z09+/\x80\xff";
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> pick(0, sizeof(alphabet) - 2);
+  std::uniform_int_distribution<int> run(0, 40);
+
+  // Build text from long runs of one character, so that each scanner
+  // sees runs of all lengths.
+  std::string text;
+  while (text.size() < 4096)
+    text.append(run(gen), alphabet[pick(gen)]);
+
+  char const* first = text.data();
+  char const* last = first + text.size();
+  for (char const* p = first; p != last; ++p) {
+    for (char const* q : {p + 1, p + 17, p + 33, p + 70, last}) {
+      if (q > last)
+        continue;
+      assert(fast.space(p, q) == slow.space(p, q));
+      assert(fast.identifier(p, q) == slow.identifier(p, q));
+      assert(fast.digits(p, q) == slow.digits(p, q));
+      assert(fast.line(p, q) == slow.line(p, q));
+    }
+  }
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_classes();
+  test_agreement();
+}
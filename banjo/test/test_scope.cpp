@@ -0,0 +1,107 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/scope.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+// Returns a new variable named n.
+Decl&
+make_var(Context& cxt, String const& n)
+{
+  Builder& build = cxt;
+  Type& z = build.get_int_type();
+  return build.make_variable_declaration(n.c_str(), z, build.get_integer(z, 0));
+}
+
+
+// Names are found in the innermost scope that binds them. The result
+// is cached in the scope where the search started, but the cached
+// entry is not a binding of that scope.
+void
+test_lookup()
+{
+  Context cxt;
+  Scope outer;
+  Decl& x = make_var(cxt, "x");
+  Overload_set& ovl = outer.bind(x);
+  Scope middle(outer);
+  Scope inner(middle);
+
+  assert(inner.find(x.name()) == &ovl);
+  assert(inner.table.size() == 1);
+  assert(!inner.lookup(x.name()));
+  assert(inner.find(x.name()) == &ovl);
+  assert(middle.table.size() == 0);
+
+  Decl& y = make_var(cxt, "y");
+  assert(!inner.find(y.name()));
+  assert(inner.table.size() == 1);
+}
+
+
+// Binding a name in a scope with nested scopes hides the binding that
+// they cached. Binding another name does not invalidate the cache.
+void
+test_invalidate()
+{
+  Context cxt;
+  Scope outer;
+  Decl& x1 = make_var(cxt, "x");
+  Overload_set& o1 = outer.bind(x1);
+  Scope middle(outer);
+  Scope inner(middle);
+  assert(inner.find(x1.name()) == &o1);
+
+  Decl& y = make_var(cxt, "y");
+  Symbol const* sx = &cast<Simple_id>(x1.name()).symbol();
+  Symbol const* sy = &cast<Simple_id>(y.name()).symbol();
+  std::size_t gx = Scope::generation(sx);
+  middle.bind(y);
+  if (&Scope::generation(sx) != &Scope::generation(sy))
+    assert(Scope::generation(sx) == gx);
+  assert(inner.find(x1.name()) == &o1);
+
+  Decl& x2 = make_var(cxt, "x");
+  Overload_set& o2 = middle.bind(x2);
+  assert(Scope::generation(sx) == gx + 1);
+  assert(inner.find(x2.name()) == &o2);
+  assert(inner.find(x1.name()) == &o2);
+}
+
+
+// The binding table grows as names are added, and bindings are found
+// after it has grown.
+void
+test_grow()
+{
+  Context cxt;
+  Scope s;
+  assert(s.table.slots.empty());
+
+  std::vector<Decl*> decls;
+  std::vector<Overload_set*> sets;
+  for (int i = 0; i < 100; ++i) {
+    Decl& d = make_var(cxt, "v" + std::to_string(i));
+    decls.push_back(&d);
+    sets.push_back(&s.bind(d));
+  }
+  assert(s.table.size() == 100);
+  assert(s.table.slots.size() >= 128);
+  for (int i = 0; i < 100; ++i)
+    assert(s.lookup(decls[i]->name()) == sets[i]);
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_lookup();
+  test_invalidate();
+  test_grow();
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/serialization.hpp>
+
+#include <iostream>
+
+
+// Returns the serialized form of a translation that declares a
+// variable with the given name.
+String
+make_translation(char const* name)
+{
+  Context cxt;
+  Builder& build = cxt;
+  Type& z = build.get_int_type();
+  Stmt_list ss;
+  ss.push_back(build.make_declaration_statement(
+    build.make_variable_declaration(name, z, build.get_integer(z, 42))));
+  return save_ast(build.make_translation_statement(std::move(ss)));
+}
+
+
+// Returns true if reading the translation in buf fails cleanly.
+bool
+fails(String const& buf)
+{
+  Context cxt;
+  try {
+    Ast_reader r(cxt, buf);
+    r.translation();
+  } catch (Translation_error&) {
+    return true;
+  }
+  return false;
+}
+
+
+// A saved translation can be read.
+void
+test_round_trip()
+{
+  String buf = make_translation("v");
+  Context cxt;
+  Ast_reader r(cxt, buf);
+  Stmt& s = r.translation();
+  assert(is<Translation_stmt>(&s));
+  assert(r.declaration(*cxt.spellings().put_identifier("v")));
+}
+
+
+// Every truncation of a saved translation is rejected.
+void
+test_truncated()
+{
+  String buf = make_translation("v");
+  for (std::size_t n = 0; n < buf.size(); ++n)
+    assert(fails(buf.substr(0, n)));
+}
+
+
+// Symbols that are spelled like integers, but are not integers, are
+// rejected.
+void
+test_corrupt()
+{
+  String buf = make_translation("abcdefghijk");
+  std::size_t n = buf.find("abcdefghijk");
+  assert(n != String::npos);
+
+  String b1 = buf;
+  b1.replace(n, 11, "1bcdefghijk");
+  assert(fails(b1));
+
+  String b2 = buf;
+  b2.replace(n, 11, "99999999999");
+  assert(fails(b2));
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_round_trip();
+  test_truncated();
+  test_corrupt();
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2015-2016 Andrew Sutton
+// All rights reserved
+
+#include "test.hpp"
+
+#include <banjo/value.hpp>
+
+#include <iostream>
+
+
+// Every value fits in two words.
+void
+test_size()
+{
+  assert(sizeof(Value) <= 2 * sizeof(void*));
+  assert(sizeof(Array_value) == sizeof(void*));
+  assert(Array_value(0).rep == nullptr);
+  assert(Array_value(0).size() == 0);
+}
+
+
+// Copies of an aggregate share storage until one of them is modified.
+void
+test_sharing()
+{
+  Value a = Array_value(3);
+  a.r.arr_[1] = 7;
+  Aggregate_rep* rep = a.get_array().rep;
+
+  // The element was referred to, so the copy has its own storage.
+  Value b = a;
+  assert(b.get_array().rep != rep);
+  assert(b.get_array()[1].get_integer() == 7);
+
+  // Fresh storage is shared by copies, and reading does not copy.
+  Value c = b;
+  Value d = c;
+  Aggregate_rep* shared = c.get_array().rep;
+  assert(b.get_array().rep == shared);
+  assert(d.get_array().rep == shared);
+  assert(shared->refs == 3);
+  assert(d.get_array()[1].get_integer() == 7);
+  assert(d.get_array().rep == shared);
+
+  // Writing through one copy does not affect the other.
+  d.r.arr_[1] = 8;
+  assert(d.get_array().rep != shared);
+  assert(shared->refs == 2);
+  assert(c.get_array()[1].get_integer() == 7);
+  assert(d.get_array()[1].get_integer() == 8);
+
+  // Destroying a copy releases its reference.
+  {
+    Value e = c;
+    assert(shared->refs == 3);
+  }
+  assert(shared->refs == 2);
+}
+
+
+// Moving a value transfers its storage and leaves an error. Assigning
+// over an aggregate releases it.
+void
+test_moves()
+{
+  Value a = Array_value("abc", 3);
+  Aggregate_rep* rep = a.get_array().rep;
+  Value b = std::move(a);
+  assert(a.is_error());
+  assert(b.get_array().rep == rep);
+  assert(b.get_array().get_as_string() == "abc");
+
+  Value c = b;
+  assert(rep->refs == 2);
+  b = 5;
+  assert(b.get_integer() == 5);
+  assert(rep->refs == 1);
+  c = Value();
+  assert(c.is_error());
+}
+
+
+// Nested aggregates own their elements. Copying an outer aggregate
+// whose elements were referred to copies the elements, which share the
+// storage of inner aggregates.
+void
+test_nesting()
+{
+  Value inner = Array_value(2);
+  Aggregate_rep* irep = inner.get_array().rep;
+  Value t = Tuple_value(2);
+  t.r.tup_[0] = 1;
+  t.r.tup_[1] = inner;
+  assert(irep->refs == 2);
+
+  {
+    Value u = t;
+    assert(u.get_tuple().rep != t.get_tuple().rep);
+    assert(u.get_tuple()[1].get_array().rep == irep);
+    assert(irep->refs == 3);
+  }
+  assert(irep->refs == 2);
+  t = Value();
+  assert(irep->refs == 1);
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  test_size();
+  test_sharing();
+  test_moves();
+  test_nesting();
+}
@@ -2,6 +2,9 @@
 // All rights reserved
 
 #include "token.hpp"
+#include "lexer.hpp"
+
+#include <algorithm>
 
 namespace banjo
 {
@@ -162,4 +165,113 @@ init_tokens(Symbol_table& syms)
 }
 
 
+// -------------------------------------------------------------------------- //
+// Token buffer
+
+// Initialize the buffer with the sequence of tokens.
+Token_buffer::Token_buffer(Token_seq const& seq)
+  : pos(0)
+{
+  toks.reserve(seq.size());
+  for (Token tok : seq)
+    put(tok);
+}
+
+
+// Append the token tok, which was lexed from the given offset in the
+// file f.
+void
+Token_buffer::put(Token tok, File& f, std::size_t off)
+{
+  if (off > UINT32_MAX)
+    throw Limitation_error("input file '{}' is too large", f.pathname());
+  start(&f);
+  toks.push_back({Token_kind(tok.kind()), index(*tok.symbol()), std::uint32_t(off)});
+}
+
+
+// Append the token tok. Its location is saved in the buffer.
+void
+Token_buffer::put(Token tok)
+{
+  start(nullptr);
+  locs.push_back(tok.location());
+  toks.push_back({Token_kind(tok.kind()), index(*tok.symbol()), std::uint32_t(locs.size() - 1)});
+}
+
+
+// Append the tokens of another buffer.
+void
+Token_buffer::append(Token_buffer const& b)
+{
+  toks.reserve(toks.size() + b.toks.size());
+  for (std::size_t r = 0; r < b.runs.size(); ++r) {
+    Token_run const& run = b.runs[r];
+    std::size_t last = r + 1 < b.runs.size() ? b.runs[r + 1].first : b.toks.size();
+    start(run.file);
+    for (std::size_t i = run.first; i < last; ++i) {
+      Token_rec rec = b.toks[i];
+      rec.sym = index(*b.syms[rec.sym]);
+      if (!run.file) {
+        locs.push_back(b.locs[rec.off]);
+        rec.off = locs.size() - 1;
+      }
+      toks.push_back(rec);
+    }
+  }
+}
+
+
+// Returns the index of the symbol s in the buffer's symbol table,
+// adding it if needed.
+std::uint32_t
+Token_buffer::index(Symbol const& s)
+{
+  auto ins = ids.emplace(&s, syms.size());
+  if (ins.second)
+    syms.push_back(&s);
+  return ins.first->second;
+}
+
+
+// Start a new run of tokens from the file f, unless the last run is
+// from the same file.
+void
+Token_buffer::start(File* f)
+{
+  if (runs.empty() || runs.back().file != f)
+    runs.push_back({toks.size(), f});
+}
+
+
+// Returns the location of the token at position p. For tokens lexed
+// from a file, the location is rebuilt from the token's offset.
+Location
+Token_buffer::location(Position p) const
+{
+  auto iter = std::upper_bound(runs.begin(), runs.end(), p, [](Position p, Token_run const& r) {
+    return p < r.first;
+  });
+  Token_run const& run = *std::prev(iter);
+  if (!run.file)
+    return locs[toks[p].off];
+  Input_stream cs(*run.file);
+  cs.advance(run.file->begin() + toks[p].off);
+  return cs.location();
+}
+
+
+// Returns the location of the current token. At the end of input,
+// this is the location of the last token.
+Location
+Token_buffer::location() const
+{
+  if (!eof())
+    return location(pos);
+  if (!toks.empty())
+    return location(toks.size() - 1);
+  return Location();
+}
+
+
 } // namespace banjo
@@ -6,8 +6,13 @@
 
 #include "prelude.hpp"
 
+#include <lingo/file.hpp>
 #include <lingo/token.hpp>
 
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
 
 namespace banjo
 {
@@ -146,6 +151,120 @@ char const* get_spelling(Token_kind);
 void init_tokens(Symbol_table&);
 
 
+// -------------------------------------------------------------------------- //
+// Token buffer
+
+// A compact record of a token: its kind, the index of its symbol in
+// the buffer's symbol table, and its offset in the input. Locations
+// are not stored; they are rebuilt from the offset when requested.
+struct Token_rec
+{
+  Token_kind    kind;
+  std::uint32_t sym;
+  std::uint32_t off;
+};
+
+
+// A run of tokens that were read from the same file, starting at the
+// given position in the buffer. Tokens that were not lexed from a file
+// belong to a run with no file, and their offsets index the locations
+// saved by the buffer.
+struct Token_run
+{
+  std::size_t first;
+  File*       file;
+};
+
+
+// A contiguous buffer of tokens. The lexer appends tokens to the
+// buffer, and the parser reads them by index. Peeking past the end
+// of the buffer yields an invalid token whose kind is error_tok.
+//
+// The files from which tokens were lexed must outlive the buffer.
+struct Token_buffer
+{
+  using Position = std::size_t;
+
+  Token_buffer()
+    : pos(0)
+  { }
+
+  explicit Token_buffer(Token_seq const&);
+
+  // Append a token lexed from the given offset in the file f.
+  void put(Token, File&, std::size_t);
+
+  // Append a token.
+  void put(Token);
+
+  // Append the tokens of another buffer.
+  void append(Token_buffer const&);
+
+  // Returns true when all tokens have been read.
+  bool eof() const { return pos == toks.size(); }
+
+  // Returns the nth token past the current token, or the invalid
+  // token if there is no such token.
+  Token peek(std::size_t n = 0) const;
+
+  // Returns the kind of the nth token past the current token.
+  Token_kind kind(std::size_t n = 0) const;
+
+  // Returns the current token and advances to the next.
+  Token get();
+
+  // Returns the location of the current token. At the end of input,
+  // this is the location of the last token.
+  Location location() const;
+
+  // Returns the current position.
+  Position position() const       { return pos; }
+  void     reposition(Position p) { pos = p; }
+
+  std::size_t size() const { return toks.size(); }
+
+  Symbol const& symbol(Position p) const { return *syms[toks[p].sym]; }
+  Location      location(Position) const;
+  Token         token(Position p) const { return Token(location(p), &symbol(p)); }
+
+  std::uint32_t index(Symbol const&);
+  void          start(File*);
+
+  std::vector<Token_rec>                           toks;
+  std::vector<Symbol const*>                       syms; // Symbols by index
+  std::unordered_map<Symbol const*, std::uint32_t> ids;  // Indexes of symbols
+  std::vector<Token_run>                           runs; // Sources of tokens
+  std::vector<Location>                            locs; // Locations not in files
+  Position                                         pos;
+};
+
+
+inline Token
+Token_buffer::peek(std::size_t n) const
+{
+  if (n < toks.size() - pos)
+    return token(pos + n);
+  return Token();
+}
+
+
+inline Token_kind
+Token_buffer::kind(std::size_t n) const
+{
+  if (n < toks.size() - pos)
+    return toks[pos + n].kind;
+  return error_tok;
+}
+
+
+inline Token
+Token_buffer::get()
+{
+  lingo_assert(!eof());
+  return token(pos++);
+}
+
+
 } // namespace banjo
 
 
@@ -26,6 +26,7 @@ make_type(Context& cxt, Simple_id& id)
     throw Type_error("not a type");
   }
   Class_decl& decl = cast<Class_decl>(d);
+  note_use(cxt, decl);
   return cxt.get_class_type(decl);
 }
 
@@ -50,12 +51,7 @@ make_type(Context& cxt, Name& n)
 Type&
 make_qualified_type(Context& cxt, Type& t, Qualifier_set q)
 {
-  if (Qualified_type* qt = as<Qualified_type>(&t)) {
-    qt->qual |= q;
-    return *qt;
-  } else {
-    return cxt.get_qualified_type(t, q);
-  }
+  return cxt.get_qualified_type(t, q);
 }
 
 
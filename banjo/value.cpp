@@ -17,8 +17,8 @@ namespace banjo
 std::string
 Array_value::get_as_string() const
 {
-  std::string str(len, '\0');
-  std::transform(data, data + len, str.begin(), [](Value const& v) -> char {
+  std::string str(size(), '\0');
+  std::transform(begin(), end(), str.begin(), [](Value const& v) -> char {
     return (v.is_integer() ? v.get_integer() : v.get_float());
   });
   return str;
@@ -34,8 +34,8 @@ inline void
 print(std::ostream& os, Array_value const& v)
 {
   os << '[';
-  Value const* p = v.data;
-  Value const* q = p + v.len;
+  Value const* p = v.begin();
+  Value const* q = v.end();
   while (p != q) {
     os << *p;
     if (p + 1 != q)
@@ -50,8 +50,8 @@ inline void
 print(std::ostream& os, Tuple_value const& v)
 {
   os << '{';
-  Value const* p = v.data;
-  Value const* q = p + v.len;
+  Value const* p = v.begin();
+  Value const* q = v.end();
   while (p != q) {
     os << *p;
     if (p + 1 != q)
@@ -106,8 +106,9 @@ zero_initialize(Float_value& v)
 void
 zero_initialize(Aggregate_value& v)
 {
-  for (std::size_t i = 0; i < v.len; ++i)
-    zero_initialize(v.data[i]);
+  Value* p = v.data();
+  for (std::size_t i = 0; i < v.size(); ++i)
+    zero_initialize(p[i]);
 }
 
 
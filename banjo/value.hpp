@@ -6,6 +6,10 @@
 
 #include "prelude.hpp"
 
+#include <cstring>
+#include <memory>
+#include <new>
+
 
 namespace banjo
 {
@@ -42,17 +46,58 @@ using Function_value = Function_decl const*;
 using Reference_value = Value*;
 
 
-// The common structure of array and tuple values.
+// The shared storage of an aggregate value. The elements are
+// allocated immediately after the header.
+//
+// Storage is reference counted, and copying an aggregate shares its
+// storage until one of the copies is modified (copy-on-write). Once
+// a pointer to an element has been handed out, the storage is no
+// longer shareable, and later copies copy the elements.
 //
-// FIXME: Memory allocated to this array is never freed. It probably
-// should be managed a little better.
+// Values are not shared between threads, so the count is not atomic.
+struct Aggregate_rep
+{
+  std::size_t refs;      // The number of aggregates using the storage
+  std::size_t len;       // The number of elements
+  bool        shareable; // False if an element may be referred to
+
+  Value*       data()       { return reinterpret_cast<Value*>(this + 1); }
+  Value const* data() const { return reinterpret_cast<Value const*>(this + 1); }
+
+  static Aggregate_rep* make(std::size_t);
+  static Aggregate_rep* make(Value const*, std::size_t);
+  static void           release(Aggregate_rep*);
+};
+
+
+// The common structure of array and tuple values. An aggregate is a
+// single pointer to its storage, so it fits in a value's union. An
+// empty aggregate has no storage.
 struct Aggregate_value
 {
-  Aggregate_value(std::size_t n);
+  explicit Aggregate_value(std::size_t n);
   Aggregate_value(char const*, std::size_t n);
+  Aggregate_value(Aggregate_value const&);
+  Aggregate_value(Aggregate_value&&) noexcept;
+  ~Aggregate_value();
+
+  Aggregate_value& operator=(Aggregate_value const&);
+  Aggregate_value& operator=(Aggregate_value&&) noexcept;
+
+  std::size_t size() const { return rep ? rep->len : 0; }
+
+  // Read-only access to the elements never copies.
+  Value const* data() const  { return rep ? rep->data() : nullptr; }
+  Value const* begin() const { return data(); }
+  Value const* end() const;
+
+  Value const& operator[](std::size_t) const;
 
-  std::size_t len;
-  Value*      data;
+  // Modifiable access copies the elements if they are shared.
+  Value* data();
+  Value& operator[](std::size_t);
+
+  Aggregate_rep* rep;
 };
 
 
@@ -73,6 +118,8 @@ struct Tuple_value : Aggregate_value
 };
 
 
+// The representation of a value. Every alternative fits in a single
+// word. The owning value constructs and destroys aggregates.
 union Value_rep
 {
   Value_rep() : err_() { }
@@ -80,8 +127,8 @@ union Value_rep
   Value_rep(Float_value fp) : float_(fp) { }
   Value_rep(Function_value f) : fn_(f) { }
   Value_rep(Reference_value r) : ref_(r) { }
-  Value_rep(Array_value a) : arr_(a) { }
-  Value_rep(Tuple_value t) : tup_(t) { }
+  Value_rep(Array_value&& a) : arr_(std::move(a)) { }
+  Value_rep(Tuple_value&& t) : tup_(std::move(t)) { }
   ~Value_rep() { }
 
   Error_value     err_;
@@ -94,7 +141,8 @@ union Value_rep
 };
 
 
-// Represents a compile time value.
+// Represents a compile time value. Values are copied and moved like
+// the values they represent. Aggregate values own their elements.
 struct Value
 {
   struct Visitor;
@@ -131,16 +179,21 @@ struct Value
   { }
 
   Value(Array_value a)
-    : k(array_value), r(a)
+    : k(array_value), r(std::move(a))
   { }
 
   Value(Tuple_value a)
-    : k(tuple_value), r(a)
+    : k(tuple_value), r(std::move(a))
   { }
 
   Value(Value* v);
 
-  ~Value() { }
+  Value(Value const&);
+  Value(Value&&) noexcept;
+  ~Value();
+
+  Value& operator=(Value const&);
+  Value& operator=(Value&&) noexcept;
 
   void accept(Visitor&) const;
   void accept(Mutator&);
@@ -159,10 +212,12 @@ struct Value
   Float_value     get_float() const;
   Function_value  get_function() const;
   Reference_value get_reference() const;
-  Array_value     get_array() const;
-  Tuple_value     get_tuple() const;
+  Array_value const& get_array() const;
+  Tuple_value const& get_tuple() const;
   bool            get_boolean() const;
 
+  bool is_aggregate() const { return k == array_value || k == tuple_value; }
+
   Value_kind k;
   Value_rep r;
 };
@@ -205,6 +260,66 @@ Value::Value(Value* v)
 }
 
 
+// Scalars are copied bitwise. Aggregates share or copy their storage.
+inline
+Value::Value(Value const& v)
+  : k(v.k)
+{
+  if (k == array_value)
+    new (&r.arr_) Array_value(v.r.arr_);
+  else if (k == tuple_value)
+    new (&r.tup_) Tuple_value(v.r.tup_);
+  else
+    std::memcpy(static_cast<void*>(&r), &v.r, sizeof(r));
+}
+
+
+// Moving a value leaves v as an error.
+inline
+Value::Value(Value&& v) noexcept
+  : k(v.k)
+{
+  std::memcpy(static_cast<void*>(&r), &v.r, sizeof(r));
+  v.k = error_value;
+}
+
+
+inline
+Value::~Value()
+{
+  if (k == array_value)
+    r.arr_.~Array_value();
+  else if (k == tuple_value)
+    r.tup_.~Tuple_value();
+}
+
+
+inline Value&
+Value::operator=(Value const& v)
+{
+  if (this != &v) {
+    if (!is_aggregate() && !v.is_aggregate()) {
+      k = v.k;
+      std::memcpy(static_cast<void*>(&r), &v.r, sizeof(r));
+    } else {
+      *this = Value(v);
+    }
+  }
+  return *this;
+}
+
+
+inline Value&
+Value::operator=(Value&& v) noexcept
+{
+  if (this != &v) {
+    this->~Value();
+    new (this) Value(std::move(v));
+  }
+  return *this;
+}
+
+
 // Returns true if the value is an error.
 inline bool
 Value::is_error() const
@@ -305,7 +420,7 @@ Value::get_reference() const
 
 
 // Returns the array value.
-inline Array_value
+inline Array_value const&
 Value::get_array() const
 {
   assert(is_array());
@@ -313,8 +428,8 @@ Value::get_array() const
 }
 
 
-// Returns the array value.
-inline Tuple_value
+// Returns the tuple value.
+inline Tuple_value const&
 Value::get_tuple() const
 {
   assert(is_tuple());
@@ -419,9 +534,50 @@ apply(Value& v, F fn)
 // -------------------------------------------------------------------------- //
 // Aggregate values
 
+// Allocate storage for n values, which are errors. The storage is
+// not shared.
+inline Aggregate_rep*
+Aggregate_rep::make(std::size_t n)
+{
+  void* p = ::operator new(sizeof(Aggregate_rep) + n * sizeof(Value));
+  Aggregate_rep* a = new (p) Aggregate_rep{1, n, true};
+  std::uninitialized_fill_n(a->data(), n, Value());
+  return a;
+}
+
+
+// Allocate storage for a copy of the n values in v.
+inline Aggregate_rep*
+Aggregate_rep::make(Value const* v, std::size_t n)
+{
+  void* p = ::operator new(sizeof(Aggregate_rep) + n * sizeof(Value));
+  try {
+    std::uninitialized_copy_n(v, n, reinterpret_cast<Value*>(static_cast<Aggregate_rep*>(p) + 1));
+  } catch (...) {
+    ::operator delete(p);
+    throw;
+  }
+  return new (p) Aggregate_rep{1, n, true};
+}
+
+
+// Release a reference to the storage, destroying it if it was the
+// last one.
+inline void
+Aggregate_rep::release(Aggregate_rep* a)
+{
+  if (a && --a->refs == 0) {
+    for (std::size_t i = 0; i < a->len; ++i)
+      a->data()[i].~Value();
+    a->~Aggregate_rep();
+    ::operator delete(a);
+  }
+}
+
+
 inline
 Aggregate_value::Aggregate_value(std::size_t n)
-  : len(n), data(new Value[n])
+  : rep(n ? Aggregate_rep::make(n) : nullptr)
 { }
 
 
@@ -429,7 +585,89 @@ inline
 Aggregate_value::Aggregate_value(char const* s, std::size_t n)
   : Aggregate_value(n)
 {
-  std::copy(s, s + n, data);
+  std::copy(s, s + n, rep->data());
+}
+
+
+inline
+Aggregate_value::Aggregate_value(Aggregate_value const& a)
+  : rep(a.rep)
+{
+  if (!rep)
+    return;
+  if (rep->shareable)
+    ++rep->refs;
+  else
+    rep = Aggregate_rep::make(a.rep->data(), a.rep->len);
+}
+
+
+inline
+Aggregate_value::Aggregate_value(Aggregate_value&& a) noexcept
+  : rep(a.rep)
+{
+  a.rep = nullptr;
+}
+
+
+inline
+Aggregate_value::~Aggregate_value()
+{
+  Aggregate_rep::release(rep);
+}
+
+
+inline Aggregate_value&
+Aggregate_value::operator=(Aggregate_value const& a)
+{
+  return *this = Aggregate_value(a);
+}
+
+
+inline Aggregate_value&
+Aggregate_value::operator=(Aggregate_value&& a) noexcept
+{
+  std::swap(rep, a.rep);
+  return *this;
+}
+
+
+inline Value const*
+Aggregate_value::end() const
+{
+  return data() + size();
+}
+
+
+inline Value const&
+Aggregate_value::operator[](std::size_t n) const
+{
+  return data()[n];
+}
+
+
+inline Value&
+Aggregate_value::operator[](std::size_t n)
+{
+  return data()[n];
+}
+
+
+// Returns the elements for modification. If the storage is shared,
+// the elements are copied first. The storage is no longer shareable,
+// since the caller may retain a pointer into it.
+inline Value*
+Aggregate_value::data()
+{
+  if (!rep)
+    return nullptr;
+  if (rep->refs > 1) {
+    Aggregate_rep* a = Aggregate_rep::make(rep->data(), rep->len);
+    Aggregate_rep::release(rep);
+    rep = a;
+  }
+  rep->shareable = false;
+  return rep->data();
 }
 
 